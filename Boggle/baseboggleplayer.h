@@ -25,9 +25,9 @@ class BaseBogglePlayer {
   public:
   virtual void buildLexicon(const set<string>& word_list) = 0;
   virtual void setBoard(unsigned int rows, unsigned int cols, string** diceArray) = 0;
-  virtual bool getAllValidWords(unsigned int minimum_word_length, set<string>* words) = 0;
-  virtual bool isInLexicon(const string& word_to_check) = 0;
-  virtual vector<int> isOnBoard(const string& word_to_check) = 0;
+  virtual bool getAllValidWords(unsigned int minimum_word_length, set<string>* words) const = 0;
+  virtual bool isInLexicon(const string& word_to_check) const = 0;
+  virtual vector<int> isOnBoard(const string& word_to_check) const = 0;
   virtual void getCustomBoard(string** &new_board, unsigned int *rows, unsigned int *cols) = 0;
   virtual ~BaseBogglePlayer() {}
 
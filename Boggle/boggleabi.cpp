@@ -0,0 +1,224 @@
+#include "boggleabi.h"
+#include "boggleplayer.h"
+#include "lexiconloader.h"
+
+#include <cctype>
+#include <cstring>
+#include <new>
+
+struct boggle_lexicon {
+    std::shared_ptr<const FlatLexicon> flat;
+};
+
+struct boggle_player {
+    BogglePlayer player;
+    WordBuffer words;
+    bool board_set;
+
+    /* The board in the form setBoard takes */
+    std::vector<std::string> dice;
+    std::vector<std::string *> rows;
+
+    boggle_player() : board_set(false) {}
+};
+
+static std::string lowered(const char *word) {
+    std::string text(word);
+    for(size_t i = 0; i < text.size(); i++)
+        text[i] = (char)tolower((unsigned char)text[i]);
+    return text;
+}
+
+static void describe(const WordBuffer &words, boggle_words *result) {
+    result->count = words.size();
+    result->text_bytes = words.text.size();
+    result->text = words.text.empty() ? NULL : &words.text[0];
+    result->offsets = words.offsets.empty() ? NULL : &words.offsets[0];
+    result->ids = words.ids.empty() ? NULL : &words.ids[0];
+}
+
+    int boggle_abi_version(void) {
+        return BOGGLE_ABI_VERSION;
+    }
+
+    boggle_lexicon *boggle_lexicon_from_words(const char *const *words, size_t count) {
+        if(words == NULL && count > 0)
+            return NULL;
+        try {
+            std::set<std::string> word_list;
+            for(size_t i = 0; i < count; i++) {
+                if(words[i] != NULL)
+                    word_list.insert(lowered(words[i]));
+            }
+            BogglePlayer builder;
+            builder.buildLexicon(word_list);
+            boggle_lexicon *lexicon = new boggle_lexicon;
+            lexicon->flat = builder.getLexicon();
+            return lexicon;
+        }
+        catch(...) {
+            return NULL;
+        }
+    }
+
+    boggle_lexicon *boggle_lexicon_load(const char *path) {
+        if(path == NULL)
+            return NULL;
+        try {
+            WordList words;
+            if(!loadWordList(path, &words))
+                return NULL;
+            BogglePlayer builder;
+            builder.buildLexicon(words);
+            boggle_lexicon *lexicon = new boggle_lexicon;
+            lexicon->flat = builder.getLexicon();
+            return lexicon;
+        }
+        catch(...) {
+            return NULL;
+        }
+    }
+
+    void boggle_lexicon_free(boggle_lexicon *lexicon) {
+        delete lexicon;
+    }
+
+    size_t boggle_lexicon_word_count(const boggle_lexicon *lexicon) {
+        return lexicon == NULL ? 0 : lexicon->flat->wordCount();
+    }
+
+    int boggle_lexicon_contains(const boggle_lexicon *lexicon, const char *word) {
+        if(lexicon == NULL || word == NULL)
+            return 0;
+        try {
+            return lexicon->flat->find(lowered(word)) ? 1 : 0;
+        }
+        catch(...) {
+            return 0;
+        }
+    }
+
+    boggle_player *boggle_player_new(const boggle_lexicon *lexicon) {
+        if(lexicon == NULL)
+            return NULL;
+        boggle_player *player = NULL;
+        try {
+            player = new boggle_player;
+            player->player.useLexicon(lexicon->flat);
+            return player;
+        }
+        catch(...) {
+            delete player;
+            return NULL;
+        }
+    }
+
+    void boggle_player_free(boggle_player *player) {
+        delete player;
+    }
+
+    int boggle_set_board(boggle_player *player, unsigned rows, unsigned cols,
+            const char *const *dice) {
+        if(player == NULL || dice == NULL || rows == 0 || cols == 0)
+            return BOGGLE_ERR_ARGUMENT;
+        for(size_t i = 0; i < (size_t)rows * cols; i++) {
+            if(dice[i] == NULL)
+                return BOGGLE_ERR_ARGUMENT;
+        }
+        try {
+            player->dice.assign(dice, dice + (size_t)rows * cols);
+            player->rows.resize(rows);
+            for(unsigned r = 0; r < rows; r++)
+                player->rows[r] = &player->dice[(size_t)r * cols];
+            player->player.setBoard(rows, cols, &player->rows[0]);
+            player->words.clear();
+            player->board_set = true;
+            return BOGGLE_OK;
+        }
+        catch(const std::bad_alloc &) {
+            player->board_set = false;
+            return BOGGLE_ERR_MEMORY;
+        }
+        catch(...) {
+            player->board_set = false;
+            return BOGGLE_ERR_ARGUMENT;
+        }
+    }
+
+    int boggle_is_in_lexicon(boggle_player *player, const char *word) {
+        if(player == NULL || word == NULL)
+            return 0;
+        try {
+            return player->player.isInLexicon(lowered(word)) ? 1 : 0;
+        }
+        catch(...) {
+            return 0;
+        }
+    }
+
+    int boggle_is_on_board(boggle_player *player, const char *word, int *path, size_t capacity) {
+        if(player == NULL || word == NULL || (path == NULL && capacity > 0))
+            return BOGGLE_ERR_ARGUMENT;
+        if(!player->board_set)
+            return BOGGLE_ERR_STATE;
+        try {
+            std::vector<int> found = player->player.isOnBoard(word);
+            if(found.size() > capacity)
+                return BOGGLE_ERR_SPACE;
+            if(!found.empty())
+                memcpy(path, &found[0], found.size() * sizeof(int));
+            return (int)found.size();
+        }
+        catch(const std::bad_alloc &) {
+            return BOGGLE_ERR_MEMORY;
+        }
+        catch(...) {
+            return BOGGLE_ERR_ARGUMENT;
+        }
+    }
+
+    int boggle_solve(boggle_player *player, unsigned minimum_length, boggle_words *result) {
+        if(player == NULL || result == NULL)
+            return BOGGLE_ERR_ARGUMENT;
+        if(!player->board_set)
+            return BOGGLE_ERR_STATE;
+        try {
+            player->player.getAllValidWords(minimum_length, &player->words);
+        }
+        catch(const std::bad_alloc &) {
+            player->words.clear();
+            return BOGGLE_ERR_MEMORY;
+        }
+        catch(...) {
+            player->words.clear();
+            return BOGGLE_ERR_ARGUMENT;
+        }
+        describe(player->words, result);
+        return BOGGLE_OK;
+    }
+
+    int boggle_solve_into(boggle_player *player, unsigned minimum_length,
+            char *text, size_t text_capacity, uint32_t *offsets, int32_t *ids,
+            size_t word_capacity, boggle_words *result) {
+        if(player == NULL || result == NULL || (text == NULL && text_capacity > 0) ||
+                (offsets == NULL && word_capacity > 0))
+            return BOGGLE_ERR_ARGUMENT;
+        int status = boggle_solve(player, minimum_length, result);
+        if(status != BOGGLE_OK)
+            return status;
+
+        const WordBuffer &words = player->words;
+        if(words.text.size() > text_capacity || words.size() > word_capacity)
+            return BOGGLE_ERR_SPACE;
+        if(!words.text.empty())
+            memcpy(text, &words.text[0], words.text.size());
+        if(words.size() > 0) {
+            memcpy(offsets, &words.offsets[0], words.size() * sizeof(uint32_t));
+            if(ids != NULL)
+                memcpy(ids, &words.ids[0], words.size() * sizeof(int32_t));
+        }
+        result->text = text;
+        result->offsets = offsets;
+        result->ids = ids;
+        return BOGGLE_OK;
+    }
@@ -0,0 +1,125 @@
+#ifndef BOGGLEABI_H
+#define BOGGLEABI_H
+
+/**
+ * C interface to the Boggle player, built into libboggle.so for use
+ * from other languages. Only plain C types cross it, no C++ exception
+ * escapes it, and the structs below only ever grow at the end, so code
+ * built against one version keeps working with later ones; check
+ * boggle_abi_version() against BOGGLE_ABI_VERSION at start up.
+ *
+ * A lexicon handle is immutable once made and may be used by any
+ * number of threads and players at once. A player handle holds a board
+ * and its result buffers; each one must only be used by one thread at a
+ * time, but different players may be used concurrently, sharing a
+ * lexicon.
+ *
+ * Calls returning int return BOGGLE_OK or one of the negative
+ * BOGGLE_ERR_ codes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(BOGGLE_ABI_BUILD)
+#define BOGGLE_API __attribute__((visibility("default")))
+#else
+#define BOGGLE_API
+#endif
+
+#define BOGGLE_ABI_VERSION 1
+
+#define BOGGLE_OK 0
+#define BOGGLE_ERR_ARGUMENT (-1)    /* a NULL handle or malformed argument */
+#define BOGGLE_ERR_STATE (-2)       /* no board set yet */
+#define BOGGLE_ERR_SPACE (-3)       /* a caller buffer is too small */
+#define BOGGLE_ERR_MEMORY (-4)
+
+typedef struct boggle_lexicon boggle_lexicon;
+typedef struct boggle_player boggle_player;
+
+/**
+ * Words found on a board, packed: word i is the NUL-terminated string
+ * at text + offsets[i] and ids[i] is its id in the lexicon. Words come
+ * in the order they were found; within one lexicon ids grow in sorted
+ * word order, so sorting by id sorts the words.
+ */
+typedef struct boggle_words {
+    size_t count;
+    size_t text_bytes;          /* total bytes of text, NULs included */
+    const char *text;
+    const uint32_t *offsets;
+    const int32_t *ids;
+} boggle_words;
+
+BOGGLE_API int boggle_abi_version(void);
+
+/**
+ * A lexicon of count words (in any case), or of the one-word-per-line
+ * file at path. Returns NULL if the words can not be read or memory
+ * runs out.
+ */
+BOGGLE_API boggle_lexicon *boggle_lexicon_from_words(const char *const *words, size_t count);
+BOGGLE_API boggle_lexicon *boggle_lexicon_load(const char *path);
+
+/* Players made from the lexicon keep it alive after it is freed */
+BOGGLE_API void boggle_lexicon_free(boggle_lexicon *lexicon);
+
+BOGGLE_API size_t boggle_lexicon_word_count(const boggle_lexicon *lexicon);
+
+/* 1 if word is in the lexicon (in any case), 0 if not */
+BOGGLE_API int boggle_lexicon_contains(const boggle_lexicon *lexicon, const char *word);
+
+/* A player searching lexicon, with no board; NULL if memory runs out */
+BOGGLE_API boggle_player *boggle_player_new(const boggle_lexicon *lexicon);
+BOGGLE_API void boggle_player_free(boggle_player *player);
+
+/**
+ * Sets a rows x cols board; dice holds the text of each die in
+ * row-major order ("?" for a blank die).
+ */
+BOGGLE_API int boggle_set_board(boggle_player *player, unsigned rows, unsigned cols,
+        const char *const *dice);
+
+/* 1 if word is in the player's lexicon, 0 if not */
+BOGGLE_API int boggle_is_in_lexicon(boggle_player *player, const char *word);
+
+/**
+ * Looks for a path spelling word on the board and stores its board
+ * indices (row * cols + col) in path, which has room for capacity of
+ * them. Returns the length of the path, 0 if the word is not on the
+ * board, or an error; BOGGLE_ERR_SPACE if the path does not fit.
+ */
+BOGGLE_API int boggle_is_on_board(boggle_player *player, const char *word,
+        int *path, size_t capacity);
+
+/**
+ * Finds every word of at least minimum_length characters on the board
+ * and points result at them. The arrays belong to the player and stay
+ * valid until its next solve, set_board or free; nothing is allocated
+ * per word, and the memory is reused from one solve to the next.
+ */
+BOGGLE_API int boggle_solve(boggle_player *player, unsigned minimum_length,
+        boggle_words *result);
+
+/**
+ * Like boggle_solve, but copies the words into the caller's arrays:
+ * text with room for text_capacity bytes, and offsets and ids (ids may
+ * be NULL) with room for word_capacity entries each. result is pointed
+ * at the caller's arrays. If either is too small, BOGGLE_ERR_SPACE is
+ * returned with result->count and result->text_bytes set to the sizes
+ * needed, and the arrays are left untouched.
+ */
+BOGGLE_API int boggle_solve_into(boggle_player *player, unsigned minimum_length,
+        char *text, size_t text_capacity, uint32_t *offsets, int32_t *ids,
+        size_t word_capacity, boggle_words *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOGGLEABI_H */
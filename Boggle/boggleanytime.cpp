@@ -0,0 +1,186 @@
+#include "boggleanytime.h"
+#include "boggleutil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static const uint32_t NO_STEP = 0xffffffffu;
+
+/* Reading the clock costs about as much as an expansion, so it is only
+ * read every so often */
+static const uint64_t CLOCK_INTERVAL = 64;
+
+/* Best first: most points, then longest, then alphabetical */
+static bool better(const ScoredWord &a, const ScoredWord &b) {
+    if(a.points != b.points)
+        return a.points > b.points;
+    if(a.length != b.length)
+        return a.length > b.length;
+    return a.word < b.word;
+}
+
+    /**
+     * Gathers the best points and the number of counting words below
+     * each node in a postorder walk of the trie, then combines them.
+     */
+    SubtrieValues::SubtrieValues(const FlatLexicon &lexicon,
+            const std::shared_ptr<const ScoreTable> &table)
+            : score_table(table), values(lexicon.nodeCount(), 0) {
+        std::vector<uint16_t> best(lexicon.nodeCount(), 0);
+        std::vector<uint32_t> count(lexicon.nodeCount(), 0);
+        std::vector<std::pair<const FlatLexNode *, bool> > stack;
+        stack.push_back(std::make_pair(lexicon.getRoot(), false));
+        while(!stack.empty()) {
+            const FlatLexNode *node = stack.back().first;
+            unsigned children = __builtin_popcount(node->child_mask);
+            if(!stack.back().second) {
+                stack.back().second = true;
+                for(unsigned c = 0; c < children; c++)
+                    stack.push_back(std::make_pair(lexicon.firstChild(node) + c, false));
+                continue;
+            }
+            stack.pop_back();
+
+            uint32_t n = lexicon.indexOf(node);
+            if(node->word_id >= 0 && table->counts(node->word_id)) {
+                best[n] = (uint16_t)table->points(node->word_id);
+                count[n] = 1;
+            }
+            for(unsigned c = 0; c < children; c++) {
+                uint32_t child = lexicon.indexOf(lexicon.firstChild(node) + c);
+                best[n] = std::max(best[n], best[child]);
+                count[n] += count[child];
+            }
+            if(count[n] > 0)
+                values[n] = (best[n] + 1) * UNIT + (uint32_t)(std::log2(count[n] + 1.0) * UNIT);
+        }
+    }
+
+    AnytimeSearch::AnytimeSearch(const BoardTopology &topology, const std::vector<std::string> &dice)
+        : topology(topology), dice(dice), lexicon(NULL), values(NULL), seen(NULL),
+          found(NULL), on_path(dice.size(), 0), generation(0) {}
+
+    void AnytimeSearch::search(const FlatLexicon &lexicon, const SubtrieValues &values,
+            WordStamps &seen, const SolveBudget &budget, AnytimeResult *result) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        this->lexicon = &lexicon;
+        this->values = &values;
+        this->seen = &seen;
+        found = &result->found;
+        found->words = 0;
+        found->total = 0;
+        found->by_length.clear();
+        found->top.clear();
+        result->expansions = 0;
+        steps.clear();
+        queue.clear();
+
+        for(unsigned i = 0; i < dice.size(); i++)
+            push(NO_STEP, i, lexicon.getRoot(), 0);
+        while(!queue.empty()) {
+            if(budget.expansions != 0 && result->expansions >= budget.expansions)
+                break;
+            if(budget.seconds > 0 && result->expansions % CLOCK_INTERVAL == 0 &&
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                    >= budget.seconds)
+                break;
+
+            std::pop_heap(queue.begin(), queue.end());
+            uint32_t step = queue.back().step;
+            queue.pop_back();
+            result->expansions++;
+            expand(step);
+        }
+        result->complete = queue.empty();
+        std::sort(found->top.begin(), found->top.end(), better);
+    }
+
+    /**
+     * Opens every path one die longer than step: marks the dice already
+     * on it, then walks each free neighbour's die down the trie.
+     */
+    void AnytimeSearch::expand(uint32_t step) {
+        if(++generation == 0) {
+            std::fill(on_path.begin(), on_path.end(), 0);
+            generation = 1;
+        }
+        for(uint32_t s = step; s != NO_STEP; s = steps[s].parent)
+            on_path[steps[s].cell] = generation;
+
+        const FlatLexNode *node = steps[step].node;
+        int cell = steps[step].cell;
+        const int *neighbours = topology.neighbours(cell);
+        for(unsigned n = 0; n < topology.degree(cell); n++) {
+            if(on_path[neighbours[n]] != generation)
+                push(step, neighbours[n], node, 0);
+        }
+    }
+
+    /**
+     * Extends the path parent (or starts one, from the root) with die
+     * cell: records the word it spells if that counts, and queues it
+     * if a counting word lies further on. A blank die is tried as each
+     * letter the trie allows.
+     */
+    void AnytimeSearch::push(uint32_t parent, int cell, const FlatLexNode *node, char letter) {
+        if(letter == 0 && isWildcardDie(dice[cell])) {
+            const FlatLexNode *child = lexicon->firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0; options &= options - 1, child++)
+                push(parent, cell, child, (char)('a' + __builtin_ctz(options)));
+            return;
+        }
+        if(letter == 0) {
+            const std::string &text = dice[cell];
+            for(size_t k = 0; k < text.size() && node != NULL; k++)
+                node = lexicon->getChild(node, text[k]);
+            if(node == NULL)
+                return;
+        }
+
+        uint32_t value = values->value(*lexicon, node);
+        if(value == 0)
+            return;
+        unsigned depth = parent == NO_STEP ? 1 : steps[parent].depth + 1;
+        Step step = { parent, cell, node, letter, (uint8_t)std::min(depth, 255u) };
+        steps.push_back(step);
+        uint32_t index = (uint32_t)(steps.size() - 1);
+        if(node->word_id >= 0 && values->table()->counts(node->word_id))
+            record(index);
+        if(node->child_mask != 0) {
+            Entry entry = { value + depth * SubtrieValues::UNIT, index };
+            queue.push_back(entry);
+            std::push_heap(queue.begin(), queue.end());
+        }
+    }
+
+    /* Adds the word spelled by the path ending at step, unless it has
+     * been found before */
+    void AnytimeSearch::record(uint32_t step) {
+        int32_t id = steps[step].node->word_id;
+        if(!seen->mark(id))
+            return;
+        const ScoreTable &table = *values->table();
+        ScoredWord word;
+        spell(step, &word.word);
+        word.length = table.length(id);
+        word.points = table.points(id);
+        found->words++;
+        found->total += word.points;
+        if(word.length >= found->by_length.size())
+            found->by_length.resize(word.length + 1, 0);
+        found->by_length[word.length]++;
+        found->top.push_back(word);
+    }
+
+    /* Spells out the path ending at step */
+    void AnytimeSearch::spell(uint32_t step, std::string *word) const {
+        word->clear();
+        for(uint32_t s = step; s != NO_STEP; s = steps[s].parent) {
+            if(steps[s].letter != 0)
+                word->push_back(steps[s].letter);
+            else
+                word->append(dice[steps[s].cell].rbegin(), dice[steps[s].cell].rend());
+        }
+        std::reverse(word->begin(), word->end());
+    }
@@ -0,0 +1,124 @@
+#ifndef BOGGLEANYTIME_H
+#define BOGGLEANYTIME_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bogglescore.h"
+#include "boggletopology.h"
+#include "flatlexicon.h"
+
+/* How long an anytime solve may run; 0 means no limit */
+struct SolveBudget {
+    double seconds;
+    uint64_t expansions;    // paths extended by one die
+
+    explicit SolveBudget(double seconds = 0, uint64_t expansions = 0)
+        : seconds(seconds), expansions(expansions) {}
+};
+
+/* What an anytime solve found before its budget ran out */
+struct AnytimeResult {
+    /* Counts and totals of the words found, with every one of them in
+     * found.top, best first */
+    ScoreResult found;
+
+    /* Whether the whole board was searched, so found holds every word */
+    bool complete;
+
+    uint64_t expansions;
+};
+
+/**
+ * How promising each node of a lexicon is for a search scoring under
+ * one ScoreTable, from the words at or below it that count: the most
+ * points one of them scores, which stands for the long words still in
+ * reach, plus the log of how many there are. Both are in units of
+ * 1/UNIT; a node with no counting word below it has value 0.
+ */
+class SubtrieValues {
+  public:
+    static const uint32_t UNIT = 256;
+
+    SubtrieValues(const FlatLexicon &lexicon, const std::shared_ptr<const ScoreTable> &table);
+
+    uint32_t value(const FlatLexicon &lexicon, const FlatLexNode *node) const {
+        return values[lexicon.indexOf(node)];
+    }
+
+    /* The table the values were computed from */
+    const ScoreTable *table() const { return score_table.get(); }
+
+  private:
+    std::shared_ptr<const ScoreTable> score_table;
+    std::vector<uint32_t> values;
+};
+
+/**
+ * Best-first board search for anytime solving. Open paths wait in a
+ * priority queue ordered by the value of the node they lead to (see
+ * SubtrieValues) plus their length, which keeps the search digging
+ * towards words once it has started down a good path; every word is
+ * recorded as soon as a path reaches it. Stopped early, it has found
+ * well more of the board's points than a depth-first search that has
+ * taken as many steps.
+ *
+ * The queue holds every open path, so a complete search costs more than
+ * a depth-first one; it pays off when a deadline cuts it short.
+ */
+class AnytimeSearch {
+  public:
+    /* A search of a board of the given topology with the given
+     * lowercased dice, one per cell */
+    AnytimeSearch(const BoardTopology &topology, const std::vector<std::string> &dice);
+
+    /**
+     * Searches the board for the words the values' table counts until
+     * the queue runs dry or the budget runs out, then sorts them best
+     * first. seen must be reset for the lexicon.
+     */
+    void search(const FlatLexicon &lexicon, const SubtrieValues &values, WordStamps &seen,
+            const SolveBudget &budget, AnytimeResult *result);
+
+  private:
+    /* A path: the die it ends on, the letter a blank die there stands
+     * for (0 otherwise), the node it leads to, and the path without
+     * that die */
+    struct Step {
+        uint32_t parent;
+        int32_t cell;
+        const FlatLexNode *node;
+        char letter;
+        uint8_t depth;
+    };
+
+    /* An open path */
+    struct Entry {
+        uint32_t key;
+        uint32_t step;
+
+        bool operator<(const Entry &other) const { return key < other.key; }
+    };
+
+    void expand(uint32_t step);
+    void push(uint32_t parent, int cell, const FlatLexNode *node, char letter);
+    void record(uint32_t step);
+    void spell(uint32_t step, std::string *word) const;
+
+    BoardTopology topology;
+    std::vector<std::string> dice;
+
+    /* State of the current search */
+    const FlatLexicon *lexicon;
+    const SubtrieValues *values;
+    WordStamps *seen;
+    ScoreResult *found;
+    std::vector<Step> steps;
+    std::vector<Entry> queue;
+    std::vector<uint32_t> on_path;
+    uint32_t generation;
+};
+
+#endif // BOGGLEANYTIME_H
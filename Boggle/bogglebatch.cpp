@@ -0,0 +1,877 @@
+/**
+ * bogglebatch: solves a stream of boards.
+ *
+ * Boards are read from the given files (or stdin) in the format
+ * described in README_brd; a file may hold any number of boards one
+ * after another. Files in the binary board stream format (see
+ * bogglestream.h, and boggleconv to make them) are recognized and
+ * mapped instead of parsed. For every board the number of words found is printed,
+ * followed by the words themselves with -w, and with -p the solver's
+ * counters for the board (meaningful in a make PROBES=1 build).
+ *
+ * With -s boards are scored instead under the official rules: the
+ * count and total score are printed, plus the best K words by points
+ * with -k K. Scoring does not collect the words, so -w is ignored.
+ *
+ * With -c N word lists are cached for up to N boards, so that repeated,
+ * rotated and mirrored boards are solved once, and with -C FILE also in
+ * FILE across runs; the cache's counters are printed to stderr at the
+ * end. Scoring (-s) does not use the cache.
+ *
+ * Without -l the lexicon compiled into the program is used, if it was
+ * built with one (bogglebatch_EMBED in the Makefile). With -L the
+ * lexicon is mapped from a lexicon map (see lexiconmap.h; lexgen -m
+ * writes them) instead of being built.
+ *
+ * Sharded runs: with -j N the boards are cut into shards of -S boards
+ * of one size and solved by N worker processes, which all map one
+ * lexicon map: -L's, or one written to a temporary file. With -a
+ * ADDRESS,... they go instead (or as well) to workers already serving
+ * at those addresses, started with -W ADDRESS; each serves one
+ * coordinator at a time. A worker that dies, answers badly or takes
+ * longer than the shard deadline has its shard handed out again, up to
+ * three times in all; local workers are restarted (a stalled one is
+ * killed first), remote ones dropped. The deadline is -D seconds, or
+ * without -D ten times the mean solve time of the shards answered so
+ * far, but at least a minute. Boards of more than 4096 dice are not
+ * sent to workers: they are reported, skipped, and the run fails. The
+ * output is that of a run in one process, in the same order, and the
+ * shards' totals are printed to stderr at the end. Local workers keep a cache of their own with -c;
+ * -C can not be shared between them. -X SHARD makes the local worker
+ * first given that shard exit without answering, to exercise the
+ * retries.
+ *
+ * usage: bogglebatch [-l lexicon | -L map] [-m min_len] [-w] [-p] [-s [-k K]]
+ *                    [-c entries] [-C file] [-j workers] [-a addresses]
+ *                    [-S shard_boards] [-D seconds] [-X shard] [board files...]
+ *        bogglebatch [-l lexicon | -L map] [-c entries] -W address
+ */
+
+#include "bogglecache.h"
+#include "boggleplayer.h"
+#include "boggleproto.h"
+#include "bogglestream.h"
+#include "flatlexicon.h"
+#include "lexiconloader.h"
+#include "lexiconmap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static unsigned DEFAULTMINWORDLENGTH = 3;
+
+/* Cache size when only a cache file is given */
+static const size_t DEFAULTCACHEENTRIES = 10000;
+
+/* Boards per shard unless -S says otherwise */
+static const size_t DEFAULTSHARDBOARDS = 64;
+
+/* Times a shard is handed out before the run gives up on it */
+static const unsigned MAX_SHARD_ATTEMPTS = 3;
+
+/* Largest board a shard may hold, as in boggled */
+static const unsigned MAX_BOARD_CELLS = 4096;
+
+/* Without -D, a shard may take this many times the mean solve time of
+ * the shards answered so far, and at least MIN_SHARD_DEADLINE seconds */
+static const unsigned SHARD_DEADLINE_FACTOR = 10;
+static const unsigned MIN_SHARD_DEADLINE = 60;
+
+/* The flags of an OP_SOLVE_SHARD request */
+enum ShardFlags {
+    SHARD_WORDS = 1,
+    SHARD_PROBES = 2,
+    SHARD_SCORE = 4
+};
+
+/* What to print for every board */
+struct BatchOptions {
+    unsigned min_len;
+    bool print_words;
+    bool print_probes;
+    bool score;
+    unsigned top_k;
+    SolveCache *cache;
+};
+
+/* Counts summed over the boards solved */
+struct BatchTotals {
+    uint64_t boards;
+    uint64_t words;
+    uint64_t points;        // with -s only
+};
+
+/* Solves one board, numbered *index, printing it to out */
+static void solveBoard(BogglePlayer &player, const BatchOptions &options, unsigned rows,
+        unsigned cols, const std::vector<std::string> &dice, unsigned long *index,
+        std::ostream &out, BatchTotals *totals) {
+    std::set<std::string> words;
+    ScoreResult score;
+
+    player.setBoard(rows, cols, dice);
+
+    totals->boards++;
+    if(options.score) {
+        player.scoreBoard(options.top_k, SCORE_BY_POINTS, &score);
+        out << "board " << (*index)++ << ": " << score.words << " words, "
+            << score.total << " points\n";
+        for(size_t i = 0; i < score.top.size(); i++) {
+            out << "  " << score.top[i].word << " " << score.top[i].points << "\n";
+        }
+        totals->words += score.words;
+        totals->points += score.total;
+    }
+    else {
+        if(options.cache)
+            options.cache->getAllValidWords(player, rows, cols, dice, options.min_len, &words);
+        else
+            player.getAllValidWords(options.min_len, &words);
+        out << "board " << (*index)++ << ": " << words.size() << " words\n";
+        totals->words += words.size();
+    }
+    if(options.print_probes) {
+        out << "  probes " << player.lastSolveProbes().toJson() << "\n";
+    }
+    if(options.print_words && !options.score) {
+        for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+            out << "  " << *it << "\n";
+        }
+    }
+}
+
+/**
+ * The boards of the named files, or of stdin if none are named, one at
+ * a time in order. Board streams are mapped and text files parsed as
+ * they come up.
+ */
+class BoardSource {
+  public:
+    BoardSource(char **names, int count)
+        : names(names), count(count), next_name(0), broken(false), text(NULL),
+          streaming(false), next_board(0) {}
+
+    /**
+     * Sets rows, cols and dice to the next board. Returns false at the
+     * end of the input, or if a file could not be opened (reported on
+     * stderr, and failed() is then true).
+     */
+    bool next(unsigned *rows, unsigned *cols, std::vector<std::string> *dice) {
+        for(;;) {
+            if(streaming && next_board < stream.size()) {
+                stream.board(next_board++, dice);
+                *rows = stream.rows();
+                *cols = stream.cols();
+                return true;
+            }
+            if(text != NULL && readTextBoard(*text, rows, cols, dice))
+                return true;
+            if(!openNext())
+                return false;
+        }
+    }
+
+    bool failed() const { return broken; }
+
+  private:
+    bool openNext() {
+        streaming = false;
+        text = NULL;
+        if(broken || next_name == (count == 0 ? 1 : count))
+            return false;
+        if(count == 0) {
+            next_name++;
+            text = &std::cin;
+            return true;
+        }
+        const char *name = names[next_name++];
+        if(BoardStreamReader::sniff(name)) {
+            if(!stream.open(name)) {
+                std::cerr << "Could not map board stream " << name << std::endl;
+                broken = true;
+                return false;
+            }
+            if(stream.truncatedBytes() != 0)
+                std::cerr << "Board stream " << name << " ends in a partial board of "
+                    << stream.truncatedBytes() << " bytes; ignored" << std::endl;
+            streaming = true;
+            next_board = 0;
+            return true;
+        }
+        file.close();
+        file.clear();
+        file.open(name);
+        if(!file) {
+            std::cerr << "Could not open board file " << name << std::endl;
+            broken = true;
+            return false;
+        }
+        text = &file;
+        return true;
+    }
+
+    char **names;
+    int count;
+    int next_name;
+    bool broken;
+
+    std::istream *text;
+    std::ifstream file;
+    BoardStreamReader stream;
+    bool streaming;
+    size_t next_board;
+};
+
+/**
+ * Answers OP_SOLVE_SHARD requests on fd until the other end hangs up:
+ * solves each shard's boards as solveBoard does and sends back their
+ * output and totals. A request for crash_shard (unless -1) on its first
+ * attempt ends the process without an answer.
+ */
+static void serveShards(int fd, BogglePlayer &player, uint64_t fingerprint, SolveCache *cache,
+        long crash_shard) {
+    std::string request;
+    std::vector<std::string> dice;
+    FrameWriter reply;
+    while(readFrame(fd, &request)) {
+        FrameReader in(request.data(), request.size());
+        uint8_t op = 0, attempt = 0, flags = 0;
+        uint16_t min_len = 0, top_k = 0, rows = 0, cols = 0;
+        uint32_t shard = 0, count = 0;
+        uint64_t first = 0;
+        bool valid = in.getU8(&op) && op == OP_SOLVE_SHARD && in.getU32(&shard) &&
+            in.getU8(&attempt) && in.getU8(&flags) && in.getU16(&min_len) &&
+            in.getU16(&top_k) && in.getU64(&first) && in.getU16(&rows) && in.getU16(&cols) &&
+            in.getU32(&count) && rows > 0 && cols > 0 && (unsigned)rows * cols <= MAX_BOARD_CELLS;
+        if(valid && (long)shard == crash_shard && attempt == 0)
+            _exit(1);
+
+        BatchOptions options = { min_len, (flags & SHARD_WORDS) != 0, (flags & SHARD_PROBES) != 0,
+            (flags & SHARD_SCORE) != 0, top_k, cache };
+        BatchTotals totals = { 0, 0, 0 };
+        std::ostringstream out;
+        unsigned long index = first;
+        uint64_t start = nowMicros();
+        dice.resize((size_t)rows * cols);
+        for(uint32_t b = 0; valid && b < count; b++) {
+            for(size_t i = 0; valid && i < dice.size(); i++)
+                valid = in.getString(&dice[i]);
+            if(valid)
+                solveBoard(player, options, rows, cols, dice, &index, out, &totals);
+        }
+        if(valid && in.atEnd()) {
+            reply.putU8(STATUS_OK);
+            reply.putU32(shard);
+            reply.putU64(fingerprint);
+            reply.putU64(totals.boards);
+            reply.putU64(totals.words);
+            reply.putU64(totals.points);
+            reply.putU64(nowMicros() - start);
+            reply.putText(out.str());
+        }
+        else {
+            reply.putU8(STATUS_BAD_REQUEST);
+        }
+        std::string frame = reply.finish();
+        if(!writeFull(fd, frame.data(), frame.size()))
+            return;
+    }
+}
+
+/* Serves shards to one coordinator after another at address; only
+ * returns if the address can not be listened on */
+static int serveAddress(const std::string &address, BogglePlayer &player, uint64_t fingerprint,
+        SolveCache *cache) {
+    int listener = listenOn(address);
+    if(listener < 0)
+        return 1;
+    signal(SIGPIPE, SIG_IGN);
+    std::cerr << "Serving shards at " << address << std::endl;
+    for(;;) {
+        int fd = accept(listener, NULL, NULL);
+        if(fd < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("accept");
+            close(listener);
+            return 1;
+        }
+        serveShards(fd, player, fingerprint, cache, -1);
+        close(fd);
+    }
+}
+
+/* A run of boards of one size, numbered from first */
+struct Shard {
+    unsigned long first;
+    unsigned rows, cols;
+    uint32_t count;
+    std::vector<std::string> dice;      // the boards' dice one after another
+    unsigned attempts;
+};
+
+/* A worker and the shard it is solving */
+struct ShardWorker {
+    int fd;                 // -1 once a remote worker is dropped
+    pid_t pid;              // of a local worker, or 0
+    std::string address;    // of a remote worker
+    long shard;             // -1 while idle
+    uint64_t sent_usec;     // when the shard was handed out
+};
+
+/* How a sharded run went, summed over the shards' answers */
+struct ShardStats {
+    uint64_t shards;
+    uint64_t retries;
+    uint64_t solve_usec;
+    uint64_t wall_usec;
+    BatchTotals totals;
+
+    std::string toJson(size_t workers) const {
+        std::ostringstream out;
+        out << "{\"shards\":" << shards << ",\"boards\":" << totals.boards
+            << ",\"words\":" << totals.words << ",\"points\":" << totals.points
+            << ",\"workers\":" << workers << ",\"retries\":" << retries
+            << ",\"solve_ms\":" << solve_usec / 1000 << ",\"wall_ms\":" << wall_usec / 1000 << "}";
+        return out.str();
+    }
+};
+
+/**
+ * Cuts the boards of a source into shards, hands them to workers over
+ * sockets, one shard per worker at a time, and prints their answers in
+ * board order as they arrive.
+ */
+class Coordinator {
+  public:
+    /* A deadline_secs of 0 sets the shard deadline from the shards'
+     * mean solve time */
+    Coordinator(BoardSource &source, const BatchOptions &options, size_t shard_boards,
+            unsigned deadline_secs, uint64_t fingerprint)
+        : source(source), options(options), shard_boards(shard_boards),
+          deadline_usec((uint64_t)deadline_secs * 1000000), fingerprint(fingerprint),
+          exhausted(false), held(false), boards_read(0), rejected(false), next_id(0),
+          next_print(0), fatal(false) {
+        stats.shards = stats.retries = stats.solve_usec = stats.wall_usec = 0;
+        stats.totals.boards = stats.totals.words = stats.totals.points = 0;
+    }
+
+    ~Coordinator() {
+        for(size_t i = 0; i < workers.size(); i++)
+            stop(workers[i]);
+    }
+
+    /**
+     * Starts a worker process solving against the lexicon map
+     * map_file, with a cache of cache_entries boards (if not 0).
+     */
+    bool addLocal(const std::string &map_file, size_t cache_entries, long crash_shard) {
+        this->map_file = map_file;
+        this->cache_entries = cache_entries;
+        this->crash_shard = crash_shard;
+        ShardWorker worker = { -1, 0, "", -1, 0 };
+        if(!spawn(worker))
+            return false;
+        workers.push_back(worker);
+        return true;
+    }
+
+    /* Connects to a worker serving at address */
+    bool addRemote(const std::string &address) {
+        ShardWorker worker = { connectTo(address), 0, address, -1, 0 };
+        if(worker.fd < 0)
+            return false;
+        workers.push_back(worker);
+        return true;
+    }
+
+    /* Solves every board of the source. Returns false if a shard could
+     * not be solved, a board was too big to send or the input could not
+     * be read. */
+    bool run() {
+        uint64_t start = nowMicros();
+        std::vector<pollfd> polled;
+        std::vector<size_t> polled_workers;
+        while(!fatal) {
+            for(size_t i = 0; i < workers.size() && !fatal; i++) {
+                if(workers[i].fd >= 0 && workers[i].shard < 0)
+                    handOut(workers[i]);
+            }
+            polled.clear();
+            polled_workers.clear();
+            uint64_t now = nowMicros(), deadline = shardDeadline(), wait = deadline;
+            for(size_t i = 0; i < workers.size(); i++) {
+                if(workers[i].fd >= 0 && workers[i].shard >= 0) {
+                    pollfd entry = { workers[i].fd, POLLIN, 0 };
+                    polled.push_back(entry);
+                    polled_workers.push_back(i);
+                    uint64_t taken = now - workers[i].sent_usec;
+                    wait = std::min(wait, taken < deadline ? deadline - taken : 0);
+                }
+            }
+            if(polled.empty()) {
+                if(!retry.empty() || !exhausted) {
+                    std::cerr << "No workers left" << std::endl;
+                    fatal = true;
+                }
+                break;
+            }
+            // rounded up, so that a shard is overdue when poll returns
+            int timeout = (int)std::min<uint64_t>((wait + 999) / 1000, 1u << 30);
+            if(poll(&polled[0], polled.size(), timeout) < 0) {
+                if(errno == EINTR)
+                    continue;
+                perror("poll");
+                fatal = true;
+                break;
+            }
+            now = nowMicros();
+            for(size_t i = 0; i < polled.size() && !fatal; i++) {
+                ShardWorker &worker = workers[polled_workers[i]];
+                if(polled[i].revents != 0)
+                    collect(worker);
+                else if(now - worker.sent_usec >= deadline)
+                    fail(worker, "timed out");
+            }
+            print();
+        }
+        stats.wall_usec = nowMicros() - start;
+        std::cout.flush();
+        return !fatal && !source.failed() && !rejected;
+    }
+
+    const ShardStats &getStats() const { return stats; }
+
+    size_t workerCount() const { return workers.size(); }
+
+  private:
+    /* Forks a local worker into worker, talking over a socket pair */
+    bool spawn(ShardWorker &worker) {
+        int ends[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, ends) < 0) {
+            perror("socketpair");
+            return false;
+        }
+        std::cout.flush();
+        pid_t pid = fork();
+        if(pid < 0) {
+            perror("fork");
+            close(ends[0]);
+            close(ends[1]);
+            return false;
+        }
+        if(pid == 0) {
+            // the other workers' sockets must close when the
+            // coordinator's do, so the child lets go of its copies
+            close(ends[0]);
+            for(size_t i = 0; i < workers.size(); i++) {
+                if(workers[i].fd >= 0)
+                    close(workers[i].fd);
+            }
+            MappedLexicon map;
+            if(!map.open(map_file)) {
+                std::cerr << "Worker could not map lexicon " << map_file << std::endl;
+                _exit(1);
+            }
+            BogglePlayer player(map.image());
+            std::unique_ptr<SolveCache> cache;
+            if(cache_entries > 0)
+                cache.reset(new SolveCache(cache_entries));
+            serveShards(ends[1], player, map.fingerprint(), cache.get(), crash_shard);
+            _exit(0);
+        }
+        close(ends[1]);
+        worker.fd = ends[0];
+        worker.pid = pid;
+        return true;
+    }
+
+    /* Closes worker's socket, and waits for it to exit if it is local */
+    void stop(ShardWorker &worker) {
+        if(worker.fd >= 0)
+            close(worker.fd);
+        worker.fd = -1;
+        if(worker.pid > 0) {
+            waitpid(worker.pid, NULL, 0);
+            worker.pid = 0;
+        }
+    }
+
+    /* How long a shard may take before it is handed to another worker */
+    uint64_t shardDeadline() const {
+        if(deadline_usec > 0)
+            return deadline_usec;
+        uint64_t usec = (uint64_t)MIN_SHARD_DEADLINE * 1000000;
+        if(stats.shards > 0)
+            usec = std::max(usec, SHARD_DEADLINE_FACTOR * (stats.solve_usec / stats.shards));
+        return usec;
+    }
+
+    /* Reads the next board a worker can take into the held board,
+     * reporting and skipping those with too many dice; returns false
+     * at the end of the input */
+    bool readBoard() {
+        while(source.next(&held_rows, &held_cols, &held_dice)) {
+            held_index = boards_read++;
+            if(held_rows > 0 && held_cols > 0 && (size_t)held_rows * held_cols <= MAX_BOARD_CELLS)
+                return true;
+            std::cerr << "Board " << held_index << " has " << held_rows << "x" << held_cols
+                << " dice, more than a shard may hold; skipped" << std::endl;
+            rejected = true;
+        }
+        return false;
+    }
+
+    /* Reads the next shard from the source into shards, or returns
+     * false at the end of the input */
+    bool readShard(uint32_t *id) {
+        if(!held && (exhausted || !readBoard())) {
+            exhausted = true;
+            return false;
+        }
+        Shard &shard = shards[next_id];
+        shard.first = held_index;
+        shard.rows = held_rows;
+        shard.cols = held_cols;
+        shard.count = 0;
+        shard.attempts = 0;
+        for(;;) {
+            shard.dice.insert(shard.dice.end(), held_dice.begin(), held_dice.end());
+            shard.count++;
+            held = false;
+            if(shard.count == shard_boards)
+                break;
+            if(!readBoard()) {
+                exhausted = true;
+                break;
+            }
+            held = true;
+            // a skipped board ends the run of numbers as well
+            if(held_rows != shard.rows || held_cols != shard.cols ||
+                    held_index != shard.first + shard.count)
+                break;
+        }
+        *id = next_id++;
+        return true;
+    }
+
+    /* Sends worker the next shard to retry, or else a new one */
+    void handOut(ShardWorker &worker) {
+        uint32_t id;
+        if(!retry.empty()) {
+            id = retry.front();
+            retry.pop_front();
+        }
+        else if(!readShard(&id)) {
+            return;
+        }
+        Shard &shard = shards[id];
+        uint8_t flags = (options.print_words ? SHARD_WORDS : 0) |
+            (options.print_probes ? SHARD_PROBES : 0) | (options.score ? SHARD_SCORE : 0);
+        FrameWriter request;
+        request.putU8(OP_SOLVE_SHARD);
+        request.putU32(id);
+        request.putU8((uint8_t)std::min(shard.attempts, 255u));
+        request.putU8(flags);
+        request.putU16((uint16_t)std::min(options.min_len, 0xffffu));
+        request.putU16((uint16_t)std::min(options.top_k, 0xffffu));
+        request.putU64(shard.first);
+        request.putU16((uint16_t)shard.rows);
+        request.putU16((uint16_t)shard.cols);
+        request.putU32(shard.count);
+        for(size_t i = 0; i < shard.dice.size(); i++)
+            request.putString(shard.dice[i]);
+        std::string frame = request.finish();
+
+        shard.attempts++;
+        worker.shard = id;
+        worker.sent_usec = nowMicros();
+        if(!writeFull(worker.fd, frame.data(), frame.size()))
+            fail(worker, "could not send");
+    }
+
+    /* Takes in worker's answer for its shard */
+    void collect(ShardWorker &worker) {
+        std::string answer;
+        if(!readFrame(worker.fd, &answer)) {
+            fail(worker, "hung up");
+            return;
+        }
+        FrameReader in(answer.data(), answer.size());
+        uint8_t status = STATUS_BAD_REQUEST;
+        uint32_t id = 0;
+        uint64_t print = 0, usec = 0;
+        BatchTotals totals = { 0, 0, 0 };
+        std::string text;
+        bool valid = in.getU8(&status) && status == STATUS_OK && in.getU32(&id) &&
+            in.getU64(&print) && in.getU64(&totals.boards) && in.getU64(&totals.words) &&
+            in.getU64(&totals.points) && in.getU64(&usec) && in.getText(&text) && in.atEnd() &&
+            (long)id == worker.shard && totals.boards == shards[id].count;
+        if(!valid) {
+            fail(worker, "answered badly");
+            return;
+        }
+        if(print != fingerprint) {
+            std::cerr << "Worker " << name(worker) << " has a different lexicon" << std::endl;
+            fatal = true;
+            return;
+        }
+        outputs[id].swap(text);
+        shards.erase(id);
+        worker.shard = -1;
+        stats.shards++;
+        stats.solve_usec += usec;
+        stats.totals.boards += totals.boards;
+        stats.totals.words += totals.words;
+        stats.totals.points += totals.points;
+    }
+
+    /* Puts worker's shard back to be handed out again, and replaces or
+     * drops the worker */
+    void fail(ShardWorker &worker, const char *why) {
+        uint32_t id = (uint32_t)worker.shard;
+        std::cerr << "Worker " << name(worker) << " " << why << " on shard " << id << std::endl;
+        worker.shard = -1;
+        if(worker.pid > 0)
+            kill(worker.pid, SIGKILL);
+        stop(worker);
+        if(shards[id].attempts >= MAX_SHARD_ATTEMPTS) {
+            std::cerr << "Giving up on shard " << id << " after "
+                << MAX_SHARD_ATTEMPTS << " attempts" << std::endl;
+            fatal = true;
+            return;
+        }
+        stats.retries++;
+        retry.push_back(id);
+        if(worker.address.empty())
+            spawn(worker);
+    }
+
+    /* Prints the answers that are next in board order */
+    void print() {
+        std::map<uint32_t, std::string>::iterator it;
+        while((it = outputs.find(next_print)) != outputs.end()) {
+            std::cout << it->second;
+            outputs.erase(it);
+            next_print++;
+        }
+    }
+
+    std::string name(const ShardWorker &worker) const {
+        if(!worker.address.empty())
+            return worker.address;
+        std::ostringstream out;
+        out << "process " << worker.pid;
+        return out.str();
+    }
+
+    BoardSource &source;
+    BatchOptions options;
+    size_t shard_boards;
+    uint64_t deadline_usec;     // 0 for a deadline from the mean
+    uint64_t fingerprint;
+
+    /* What local workers are started with */
+    std::string map_file;
+    size_t cache_entries;
+    long crash_shard;
+
+    std::vector<ShardWorker> workers;
+
+    /* The shards handed out or waiting to be, by id */
+    std::map<uint32_t, Shard> shards;
+    std::deque<uint32_t> retry;
+    bool exhausted;
+
+    /* A board read past the end of the last shard, and its number */
+    bool held;
+    unsigned held_rows, held_cols;
+    std::vector<std::string> held_dice;
+    unsigned long held_index;
+
+    /* Boards read so far, and whether any were too big to send */
+    unsigned long boards_read;
+    bool rejected;
+
+    uint32_t next_id;
+
+    /* Answers waiting for the ones before them */
+    std::map<uint32_t, std::string> outputs;
+    uint32_t next_print;
+
+    bool fatal;
+    ShardStats stats;
+};
+
+/* Removes a file when it goes out of scope */
+struct TemporaryFile {
+    std::string path;
+    ~TemporaryFile() {
+        if(!path.empty())
+            unlink(path.c_str());
+    }
+};
+
+int main(int argc, char *argv[]) {
+    const char *lexfilename = NULL;
+    const char *mapfilename = NULL;
+    BatchOptions options = { DEFAULTMINWORDLENGTH, false, false, false, 0, NULL };
+    size_t cache_entries = 0;
+    const char *cache_file = NULL;
+    unsigned local_workers = 0;
+    std::vector<std::string> remote_workers;
+    size_t shard_boards = DEFAULTSHARDBOARDS;
+    long crash_shard = -1;
+    unsigned deadline_secs = 0;
+    const char *serve_address = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "l:L:m:wpsk:c:C:j:a:S:D:X:W:")) != -1) {
+        switch(opt) {
+            case 'l': lexfilename = optarg; break;
+            case 'L': mapfilename = optarg; break;
+            case 'm': options.min_len = atoi(optarg); break;
+            case 'w': options.print_words = true; break;
+            case 'p': options.print_probes = true; break;
+            case 's': options.score = true; break;
+            case 'k': options.top_k = atoi(optarg); break;
+            case 'c': cache_entries = strtoul(optarg, NULL, 10); break;
+            case 'C': cache_file = optarg; break;
+            case 'j': local_workers = atoi(optarg); break;
+            case 'a': {
+                std::istringstream list(optarg);
+                std::string address;
+                while(std::getline(list, address, ','))
+                    if(!address.empty())
+                        remote_workers.push_back(address);
+                break;
+            }
+            case 'S': shard_boards = strtoul(optarg, NULL, 10); break;
+            case 'D': deadline_secs = atoi(optarg); break;
+            case 'X': crash_shard = atol(optarg); break;
+            case 'W': serve_address = optarg; break;
+            default:
+                std::cerr << "usage: " << argv[0]
+                    << " [-l lexicon | -L map] [-m min_len] [-w] [-p] [-s [-k K]]"
+                    " [-c entries] [-C file] [-j workers] [-a addresses]"
+                    " [-S shard_boards] [-D seconds] [-X shard] [board files...]\n"
+                    "       " << argv[0] << " [-l lexicon | -L map] [-c entries] -W address"
+                    << std::endl;
+                return 1;
+        }
+    }
+    bool sharded = local_workers > 0 || !remote_workers.empty();
+    if(sharded && cache_file != NULL) {
+        std::cerr << "A cache file can not be shared between workers" << std::endl;
+        return 1;
+    }
+    if(shard_boards == 0)
+        shard_boards = DEFAULTSHARDBOARDS;
+
+    std::unique_ptr<SolveCache> cache;
+    if(!sharded && (cache_entries > 0 || cache_file != NULL)) {
+        cache.reset(new SolveCache(cache_entries > 0 ? cache_entries : DEFAULTCACHEENTRIES));
+        if(cache_file != NULL && !cache->openDisk(cache_file)) {
+            std::cerr << "Could not open cache file " << cache_file
+                << " (unreadable, not a cache file, or in use)" << std::endl;
+            return 1;
+        }
+        options.cache = cache.get();
+    }
+
+    MappedLexicon map;
+    std::unique_ptr<BogglePlayer> player;
+    if(mapfilename != NULL) {
+        if(!map.open(mapfilename)) {
+            std::cerr << "Could not map lexicon " << mapfilename << std::endl;
+            return 1;
+        }
+        player.reset(new BogglePlayer(map.image()));
+    }
+    else if(lexfilename != NULL) {
+        WordList words;
+        if(!loadWordList(lexfilename, &words)) {
+            std::cerr << "Could not read lexicon file " << lexfilename << std::endl;
+            return 1;
+        }
+        player.reset(new BogglePlayer());
+        player->buildLexicon(words);
+    }
+    else if(embeddedLexicon() != NULL) {
+        player.reset(new BogglePlayer(*embeddedLexicon()));
+    }
+    else {
+        std::cerr << "No lexicon compiled in; pass one with -l" << std::endl;
+        return 1;
+    }
+    uint64_t fingerprint = mapfilename != NULL ? map.fingerprint()
+        : player->getLexicon()->fingerprint();
+
+    if(serve_address != NULL)
+        return serveAddress(serve_address, *player, fingerprint, cache.get());
+
+    BoardSource source(argv + optind, argc - optind);
+    if(!sharded) {
+        unsigned long index = 0;
+        BatchTotals totals = { 0, 0, 0 };
+        unsigned rows, cols;
+        std::vector<std::string> dice;
+        while(source.next(&rows, &cols, &dice)) {
+            solveBoard(*player, options, rows, cols, dice, &index, std::cout, &totals);
+        }
+        if(cache)
+            std::cerr << "cache: " << cache->stats().toJson() << std::endl;
+        return source.failed() ? 1 : 0;
+    }
+
+    // local workers map -L's lexicon, or this one written out for them
+    TemporaryFile written;
+    if(local_workers > 0 && mapfilename == NULL) {
+        const char *tmpdir = getenv("TMPDIR");
+        std::string path = std::string(tmpdir != NULL ? tmpdir : "/tmp") + "/bogglebatch-XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if(fd < 0) {
+            perror(path.c_str());
+            return 1;
+        }
+        close(fd);
+        written.path = path;
+        if(!writeLexiconMap(*player->getLexicon(), path)) {
+            std::cerr << "Could not write lexicon map " << path << std::endl;
+            return 1;
+        }
+        mapfilename = written.path.c_str();
+    }
+    player.reset();
+
+    signal(SIGPIPE, SIG_IGN);
+    Coordinator coordinator(source, options, shard_boards, deadline_secs, fingerprint);
+    for(unsigned i = 0; i < local_workers; i++) {
+        if(!coordinator.addLocal(mapfilename, cache_entries, crash_shard))
+            return 1;
+    }
+    for(size_t i = 0; i < remote_workers.size(); i++) {
+        if(!coordinator.addRemote(remote_workers[i]))
+            return 1;
+    }
+    bool solved = coordinator.run();
+    std::cerr << "shards: " << coordinator.getStats().toJson(coordinator.workerCount())
+        << std::endl;
+    return solved ? 0 : 1;
+}
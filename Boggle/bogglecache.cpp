@@ -0,0 +1,366 @@
+#include "bogglecache.h"
+#include "boggleplayer.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Disk tier layout: a header, then fixed size slots. A slot starts
+ * with its key's hash (0 when empty), the key and data lengths and the
+ * solve time, followed by the key and the words, each ending in '\n'. */
+static const char DISK_MAGIC[8] = { 'B', 'O', 'G', 'C', 'A', 'C', 'H', '1' };
+static const size_t DISK_HEADER_BYTES = 64;
+static const size_t SLOT_HEADER_BYTES = 24;
+
+/* Slots tried for a key, starting at its home slot */
+static const unsigned DISK_PROBES = 4;
+
+    /* Cell of the original board shown at cell i after symmetry s:
+     * bit 2 transposes, bits 0 and 1 flip the rows and the columns of
+     * the transformed board, which has R x C cells */
+    static int symmetricCell(unsigned s, unsigned i, unsigned R, unsigned C, unsigned cols) {
+        unsigned r = i / C, c = i % C;
+        if(s & 1)
+            r = R - 1 - r;
+        if(s & 2)
+            c = C - 1 - c;
+        return (s & 4) ? c * cols + r : r * cols + c;
+    }
+
+    CanonicalBoard canonicalBoard(unsigned rows, unsigned cols,
+            const std::vector<std::string> &dice) {
+        std::vector<std::string> lower(dice.size());
+        for(size_t i = 0; i < dice.size(); i++) {
+            for(size_t k = 0; k < dice[i].size(); k++) {
+                lower[i] += (char)tolower((unsigned char)dice[i][k]);
+            }
+        }
+
+        // the least of the eight, comparing sizes first, then dice
+        unsigned best = 0;
+        for(unsigned s = 1; s < 8; s++) {
+            unsigned R = (s & 4) ? cols : rows, C = (s & 4) ? rows : cols;
+            unsigned best_R = (best & 4) ? cols : rows, best_C = (best & 4) ? rows : cols;
+            int order = R != best_R ? (R < best_R ? -1 : 1) : 0;
+            for(unsigned i = 0; order == 0 && i < lower.size(); i++) {
+                order = lower[symmetricCell(s, i, R, C, cols)].compare(
+                        lower[symmetricCell(best, i, best_R, best_C, cols)]);
+            }
+            if(order < 0)
+                best = s;
+        }
+
+        CanonicalBoard canon;
+        canon.rows = (best & 4) ? cols : rows;
+        canon.cols = (best & 4) ? rows : cols;
+        for(unsigned i = 0; i < lower.size(); i++) {
+            int cell = symmetricCell(best, i, canon.rows, canon.cols, cols);
+            canon.to_original.push_back(cell);
+            canon.dice.push_back(lower[cell]);
+        }
+        return canon;
+    }
+
+    std::vector<int> CanonicalBoard::originalPath(const std::vector<int> &path) const {
+        std::vector<int> mapped(path.size());
+        for(size_t i = 0; i < path.size(); i++) {
+            mapped[i] = to_original[path[i]];
+        }
+        return mapped;
+    }
+
+    double SolveCacheStats::hitRate() const {
+        uint64_t lookups = memory_hits + disk_hits + misses;
+        return lookups ? (double)(memory_hits + disk_hits) / lookups : 0;
+    }
+
+    std::string SolveCacheStats::toJson() const {
+        std::ostringstream out;
+        out << "{\"memory_hits\":" << memory_hits << ",\"disk_hits\":" << disk_hits
+            << ",\"misses\":" << misses << ",\"evictions\":" << evictions
+            << ",\"disk_writes\":" << disk_writes << ",\"hit_rate\":" << hitRate()
+            << ",\"solve_ns\":" << solve_ns << ",\"saved_ns\":" << saved_ns << "}";
+        return out.str();
+    }
+
+    /* FNV-1a, never 0 so that 0 can mark empty disk slots */
+    static uint64_t keyHash(const std::string &key) {
+        uint64_t hash = 14695981039346656037ull;
+        for(size_t i = 0; i < key.size(); i++) {
+            hash = (hash ^ (unsigned char)key[i]) * 1099511628211ull;
+        }
+        return hash | 1;
+    }
+
+    SolveCache::SolveCache(size_t capacity, unsigned shard_count)
+            : last_fingerprint(0), disk_fd(-1), disk(NULL), disk_size(0), disk_slots(0),
+              slot_bytes(0), disk_writes(0) {
+        if(shard_count == 0)
+            shard_count = 1;
+        shard_capacity = (capacity + shard_count - 1) / shard_count;
+        for(unsigned i = 0; i < shard_count; i++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard()));
+        }
+    }
+
+    SolveCache::~SolveCache() {
+        if(disk != NULL)
+            munmap(disk, disk_size);
+        if(disk_fd >= 0)
+            close(disk_fd);
+    }
+
+    bool SolveCache::openDisk(const std::string &filename, size_t slots, size_t bytes) {
+        std::lock_guard<std::mutex> guard(disk_lock);
+        if(disk != NULL) {
+            munmap(disk, disk_size);
+            close(disk_fd);
+            disk = NULL;
+            disk_fd = -1;
+        }
+
+        int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+
+        bool fresh = st.st_size == 0;
+        uint64_t count = slots, size_each = (bytes + 7) / 8 * 8;
+        size_t size = (size_t)st.st_size;
+        if(fresh) {
+            if(count == 0 || size_each < SLOT_HEADER_BYTES + 16) {
+                close(fd);
+                return false;
+            }
+            size = DISK_HEADER_BYTES + count * size_each;
+            if(ftruncate(fd, size) != 0) {
+                close(fd);
+                return false;
+            }
+        }
+        else if(size < DISK_HEADER_BYTES) {
+            close(fd);
+            return false;
+        }
+
+        void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(mapped == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        unsigned char *base = (unsigned char *)mapped;
+        if(fresh) {
+            memcpy(base, DISK_MAGIC, sizeof(DISK_MAGIC));
+            memcpy(base + 8, &count, 8);
+            memcpy(base + 16, &size_each, 8);
+        }
+        else {
+            memcpy(&count, base + 8, 8);
+            memcpy(&size_each, base + 16, 8);
+            if(memcmp(base, DISK_MAGIC, sizeof(DISK_MAGIC)) != 0 || count == 0 ||
+               size_each < SLOT_HEADER_BYTES || DISK_HEADER_BYTES + count * size_each != size) {
+                munmap(mapped, size);
+                close(fd);
+                return false;
+            }
+        }
+
+        disk_fd = fd;
+        disk = base;
+        disk_size = size;
+        disk_slots = count;
+        slot_bytes = size_each;
+        return true;
+    }
+
+    bool SolveCache::getAllValidWords(BogglePlayer &player, unsigned rows, unsigned cols,
+            const std::vector<std::string> &dice, unsigned minimum_word_length,
+            std::set<std::string> *words) {
+        player.setBoard(rows, cols, dice);
+        if(!player.lexIsBuilt())
+            return false;
+
+        CanonicalBoard canon = canonicalBoard(rows, cols, dice);
+        uint64_t fingerprint = lexiconFingerprint(player.getLexicon());
+        uint32_t header[3] = { minimum_word_length, canon.rows, canon.cols };
+        std::string key((const char *)&fingerprint, 8);
+        key.append((const char *)header, sizeof(header));
+        for(size_t i = 0; i < canon.dice.size(); i++) {
+            key += canon.dice[i];
+            key += '\n';
+        }
+        uint64_t hash = keyHash(key);
+        Shard &shard = *shards[hash % shards.size()];
+
+        if(memoryLookup(shard, key, words))
+            return true;
+
+        std::set<std::string> found;
+        uint64_t solve_ns;
+        if(diskLookup(key, hash, &found, &solve_ns)) {
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                shard.stats.disk_hits++;
+                shard.stats.saved_ns += solve_ns;
+            }
+            memoryStore(shard, key, found, solve_ns);
+            words->insert(found.begin(), found.end());
+            return true;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        player.getAllValidWords(minimum_word_length, &found);
+        solve_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.stats.misses++;
+            shard.stats.solve_ns += solve_ns;
+        }
+        memoryStore(shard, key, found, solve_ns);
+        diskStore(key, hash, found, solve_ns);
+        words->insert(found.begin(), found.end());
+        return true;
+    }
+
+    SolveCacheStats SolveCache::stats() {
+        SolveCacheStats total;
+        for(size_t i = 0; i < shards.size(); i++) {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            const SolveCacheStats &s = shards[i]->stats;
+            total.memory_hits += s.memory_hits;
+            total.disk_hits += s.disk_hits;
+            total.misses += s.misses;
+            total.evictions += s.evictions;
+            total.solve_ns += s.solve_ns;
+            total.saved_ns += s.saved_ns;
+        }
+        std::lock_guard<std::mutex> guard(disk_lock);
+        total.disk_writes = disk_writes;
+        return total;
+    }
+
+    /* The fingerprint walks the whole trie, so it is kept for as long as
+     * the same lexicon keeps being used */
+    uint64_t SolveCache::lexiconFingerprint(const std::shared_ptr<const FlatLexicon> &lexicon) {
+        std::lock_guard<std::mutex> guard(lexicon_lock);
+        if(last_lexicon.lock() != lexicon) {
+            last_fingerprint = lexicon->fingerprint();
+            last_lexicon = lexicon;
+        }
+        return last_fingerprint;
+    }
+
+    bool SolveCache::memoryLookup(Shard &shard, const std::string &key,
+            std::set<std::string> *words) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        std::unordered_map<std::string, EntryList::iterator>::iterator it = shard.index.find(key);
+        if(it == shard.index.end())
+            return false;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        words->insert(it->second->words.begin(), it->second->words.end());
+        shard.stats.memory_hits++;
+        shard.stats.saved_ns += it->second->solve_ns;
+        return true;
+    }
+
+    void SolveCache::memoryStore(Shard &shard, const std::string &key,
+            const std::set<std::string> &words, uint64_t solve_ns) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if(shard.index.count(key))
+            return;     // another thread solved it meanwhile
+        Entry entry = { key, words, solve_ns };
+        shard.entries.push_front(entry);
+        shard.index[key] = shard.entries.begin();
+        while(shard.entries.size() > shard_capacity) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+            shard.stats.evictions++;
+        }
+    }
+
+    bool SolveCache::diskLookup(const std::string &key, uint64_t hash,
+            std::set<std::string> *words, uint64_t *solve_ns) {
+        std::lock_guard<std::mutex> guard(disk_lock);
+        if(disk == NULL)
+            return false;
+        for(unsigned p = 0; p < DISK_PROBES; p++) {
+            const unsigned char *slot = disk + DISK_HEADER_BYTES
+                + ((hash + p) % disk_slots) * slot_bytes;
+            uint64_t slot_hash;
+            uint32_t key_len, data_len;
+            memcpy(&slot_hash, slot, 8);
+            if(slot_hash == 0)
+                return false;
+            memcpy(&key_len, slot + 8, 4);
+            memcpy(&data_len, slot + 12, 4);
+            if(slot_hash != hash || key_len != key.size() ||
+               SLOT_HEADER_BYTES + (uint64_t)key_len + data_len > slot_bytes ||
+               memcmp(slot + SLOT_HEADER_BYTES, key.data(), key_len) != 0)
+                continue;
+
+            memcpy(solve_ns, slot + 16, 8);
+            const char *data = (const char *)slot + SLOT_HEADER_BYTES + key_len;
+            const char *end = data + data_len;
+            while(data < end) {
+                const char *next = (const char *)memchr(data, '\n', end - data);
+                if(next == NULL)
+                    break;
+                words->insert(words->end(), std::string(data, next));
+                data = next + 1;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void SolveCache::diskStore(const std::string &key, uint64_t hash,
+            const std::set<std::string> &words, uint64_t solve_ns) {
+        std::string data;
+        for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+            data += *it;
+            data += '\n';
+        }
+
+        std::lock_guard<std::mutex> guard(disk_lock);
+        if(disk == NULL || SLOT_HEADER_BYTES + key.size() + data.size() > slot_bytes)
+            return;
+
+        // an empty slot or the key's own along the probe sequence, or
+        // else the key's home slot is overwritten
+        unsigned char *home = disk + DISK_HEADER_BYTES + (hash % disk_slots) * slot_bytes;
+        unsigned char *target = home;
+        for(unsigned p = 0; p < DISK_PROBES; p++) {
+            unsigned char *slot = disk + DISK_HEADER_BYTES
+                + ((hash + p) % disk_slots) * slot_bytes;
+            uint64_t slot_hash;
+            memcpy(&slot_hash, slot, 8);
+            if(slot_hash == 0 || slot_hash == hash) {
+                target = slot;
+                break;
+            }
+        }
+
+        // the hash goes in last, so a slot is never found half written
+        uint64_t empty = 0;
+        uint32_t key_len = (uint32_t)key.size(), data_len = (uint32_t)data.size();
+        memcpy(target, &empty, 8);
+        memcpy(target + 8, &key_len, 4);
+        memcpy(target + 12, &data_len, 4);
+        memcpy(target + 16, &solve_ns, 8);
+        memcpy(target + SLOT_HEADER_BYTES, key.data(), key_len);
+        memcpy(target + SLOT_HEADER_BYTES + key_len, data.data(), data_len);
+        memcpy(target, &hash, 8);
+        disk_writes++;
+    }
@@ -0,0 +1,149 @@
+#ifndef BOGGLECACHE_H
+#define BOGGLECACHE_H
+
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flatlexicon.h"
+
+class BogglePlayer;
+
+/**
+ * A board in canonical form: of the eight boards its rotations and
+ * reflections give (four of them rows x cols, four transposed to cols
+ * x rows), the least by size and then by dice in row-major order.
+ * Every rotation and reflection of a board has the same canonical form,
+ * and the same words.
+ */
+struct CanonicalBoard {
+    unsigned rows, cols;
+
+    /* Lowercased dice of the canonical board in row-major order */
+    std::vector<std::string> dice;
+
+    /* Index on the original board of each canonical cell */
+    std::vector<int> to_original;
+
+    /* Maps a path on the canonical board back onto the original */
+    std::vector<int> originalPath(const std::vector<int> &path) const;
+};
+
+CanonicalBoard canonicalBoard(unsigned rows, unsigned cols,
+        const std::vector<std::string> &dice);
+
+/* Counters of a SolveCache since it was made */
+struct SolveCacheStats {
+    uint64_t memory_hits;
+    uint64_t disk_hits;
+    uint64_t misses;
+    uint64_t evictions;     // entries the memory tier dropped for room
+    uint64_t disk_writes;
+
+    /* Time spent solving the misses, and the time the hits would have
+     * taken, going by how long each took when it was solved */
+    uint64_t solve_ns;
+    uint64_t saved_ns;
+
+    SolveCacheStats() : memory_hits(0), disk_hits(0), misses(0), evictions(0),
+        disk_writes(0), solve_ns(0), saved_ns(0) {}
+
+    double hitRate() const;
+
+    /* {"memory_hits":..,"disk_hits":..,...,"hit_rate":..,"saved_ns":..} */
+    std::string toJson() const;
+};
+
+/**
+ * Cache of getAllValidWords results, keyed by the canonical form of
+ * the board, the lexicon's fingerprint and the minimum word length, so
+ * that a rotated or mirrored copy of a board solved before is a hit.
+ *
+ * The memory tier is an LRU split into shards, each with its own lock,
+ * so solver threads rarely contend. An optional disk tier behind it is
+ * a fixed size hash table in a memory-mapped file which keeps results
+ * across runs; entries too large for a slot stay in memory only. Only
+ * one process may have a cache file open at a time.
+ */
+class SolveCache {
+  public:
+    /* A cache of up to capacity results in memory */
+    explicit SolveCache(size_t capacity, unsigned shards = 16);
+    ~SolveCache();
+
+    /**
+     * Adds the disk tier, kept in filename. A new file gets slots slots
+     * of slot_bytes bytes each; an existing one keeps its own layout.
+     * Returns false if the file can not be created, mapped or locked,
+     * or is not a cache file.
+     */
+    bool openDisk(const std::string &filename, size_t slots = 16384,
+            size_t slot_bytes = 4096);
+
+    /**
+     * Sets the board on player and fills words with what
+     * player.getAllValidWords(minimum_word_length, words) would,
+     * solving the board only if the cache has no result for it. The
+     * board is left set on player either way, so isOnBoard can be
+     * asked about the words afterwards.
+     *
+     * Returns false if player has no lexicon.
+     */
+    bool getAllValidWords(BogglePlayer &player, unsigned rows, unsigned cols,
+            const std::vector<std::string> &dice, unsigned minimum_word_length,
+            std::set<std::string> *words);
+
+    SolveCacheStats stats();
+
+  private:
+    SolveCache(const SolveCache &);
+    SolveCache &operator=(const SolveCache &);
+
+    struct Entry {
+        std::string key;
+        std::set<std::string> words;
+        uint64_t solve_ns;
+    };
+    typedef std::list<Entry> EntryList;
+
+    /* One LRU: entries most recently used first */
+    struct Shard {
+        std::mutex lock;
+        EntryList entries;
+        std::unordered_map<std::string, EntryList::iterator> index;
+        SolveCacheStats stats;
+    };
+
+    uint64_t lexiconFingerprint(const std::shared_ptr<const FlatLexicon> &lexicon);
+    bool memoryLookup(Shard &shard, const std::string &key, std::set<std::string> *words);
+    void memoryStore(Shard &shard, const std::string &key,
+            const std::set<std::string> &words, uint64_t solve_ns);
+    bool diskLookup(const std::string &key, uint64_t hash, std::set<std::string> *words,
+            uint64_t *solve_ns);
+    void diskStore(const std::string &key, uint64_t hash,
+            const std::set<std::string> &words, uint64_t solve_ns);
+
+    size_t shard_capacity;
+    std::vector<std::unique_ptr<Shard> > shards;
+
+    /* Fingerprint of the lexicon last seen */
+    std::mutex lexicon_lock;
+    std::weak_ptr<const FlatLexicon> last_lexicon;
+    uint64_t last_fingerprint;
+
+    /* The mapped file, if any, and its geometry; guarded by disk_lock */
+    std::mutex disk_lock;
+    int disk_fd;
+    unsigned char *disk;
+    size_t disk_size;
+    uint64_t disk_slots;
+    uint64_t slot_bytes;
+    uint64_t disk_writes;
+};
+
+#endif // BOGGLECACHE_H
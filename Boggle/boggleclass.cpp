@@ -0,0 +1,321 @@
+#include "boggleclass.h"
+#include "boggleplayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static const char *CHECKPOINT_MAGIC = "boggleclass-checkpoint 1";
+
+    bool isConcrete(const BoardClass &board_class) {
+        for(size_t i = 0; i < board_class.size(); i++) {
+            if(__builtin_popcount(board_class[i]) != 1)
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<std::string> classDice(const BoardClass &board_class) {
+        std::vector<std::string> dice(board_class.size());
+        for(size_t i = 0; i < board_class.size(); i++) {
+            char letter = (char)('a' + __builtin_ctz(board_class[i]));
+            dice[i] = letter == 'q' ? "qu" : std::string(1, letter);
+        }
+        return dice;
+    }
+
+    std::string classLetters(const BoardClass &board_class) {
+        std::string letters;
+        for(size_t i = 0; i < board_class.size(); i++) {
+            letters += (char)('a' + __builtin_ctz(board_class[i]));
+        }
+        return letters;
+    }
+
+    ClassBounder::ClassBounder(const FlatLexicon &lexicon, const ScoreTable &table,
+            unsigned rows, unsigned cols)
+            : lexicon(lexicon), table(table), neighbours(rows * cols), letters(NULL) {
+        for(unsigned i = 0; i < rows * cols; i++) {
+            int row = i / cols, col = i % cols;
+            for(int r = row - 1; r <= row + 1; r++) {
+                for(int c = col - 1; c <= col + 1; c++) {
+                    if(r < 0 || c < 0 || r >= (int)rows || c >= (int)cols || (r == row && c == col))
+                        continue;
+                    neighbours[i].push_back(r * cols + c);
+                }
+            }
+        }
+    }
+
+    uint64_t ClassBounder::bound(const BoardClass &board_class) {
+        letters = &board_class[0];
+        uint64_t total = 0;
+        for(unsigned i = 0; i < neighbours.size(); i++) {
+            total += from(i, lexicon.getRoot(), (uint64_t)1 << i);
+        }
+        return total;
+    }
+
+    /* Most points any letter of cell can lead to along paths extending
+     * the one that reached node */
+    uint64_t ClassBounder::from(unsigned cell, const FlatLexNode *node, uint64_t visited) {
+        uint64_t best = 0;
+        for(uint32_t options = letters[cell] & node->child_mask; options != 0;
+                options &= options - 1) {
+            unsigned k = __builtin_ctz(options);
+            const FlatLexNode *child = lexicon.firstChild(node)
+                + __builtin_popcount(node->child_mask & ((1u << k) - 1));
+            if(k == 'q' - 'a') {
+                child = lexicon.getChild(child, 'u');
+                if(child == NULL)
+                    continue;
+            }
+
+            uint64_t points = 0;
+            if(child->word_id >= 0 && table.counts(child->word_id))
+                points = table.points(child->word_id);
+            if(child->child_mask != 0) {
+                const std::vector<unsigned> &next = neighbours[cell];
+                for(size_t n = 0; n < next.size(); n++) {
+                    if(!(visited & ((uint64_t)1 << next[n])))
+                        points += from(next[n], child, visited | ((uint64_t)1 << next[n]));
+                }
+            }
+            best = std::max(best, points);
+        }
+        return best;
+    }
+
+    ClassSearch::ClassSearch(const BogglePlayer &source, unsigned rows, unsigned cols,
+            const ScoringRules &rules)
+            : rows(rows), cols(cols), master(new BogglePlayer()),
+              lexicon(source.getLexicon()), table(*lexicon, rules), busy(0),
+              incumbent(0), stopping(false), examined(0) {
+        master->shareLexicon(source);
+        master->setScoringRules(rules);
+    }
+
+    ClassSearch::~ClassSearch() {}
+
+    void ClassSearch::start(const BoardClass &whole, uint64_t incumbent) {
+        std::lock_guard<std::mutex> guard(lock);
+        open.assign(1, whole);
+        this->incumbent = incumbent;
+        best.clear();
+        examined = 0;
+        stopping = false;
+    }
+
+    /**
+     * Checkpoints are text: a header line, the board size and lexicon
+     * word count, the incumbent, the best board (- for none), the
+     * number of classes examined, then the open classes one per line
+     * as hex letter masks.
+     */
+    bool ClassSearch::saveCheckpoint(const std::string &filename) {
+        std::vector<BoardClass> classes;
+        uint64_t score;
+        std::string board;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            classes = open;
+            for(size_t w = 0; w < in_progress.size(); w++) {
+                if(!in_progress[w].empty())
+                    classes.push_back(in_progress[w]);
+            }
+            score = incumbent;
+            board = best;
+        }
+
+        std::string temp = filename + ".tmp";
+        {
+            std::ofstream out(temp.c_str());
+            out << CHECKPOINT_MAGIC << "\n"
+                << rows << " " << cols << " " << lexicon->wordCount() << "\n"
+                << score << "\n"
+                << (board.empty() ? "-" : board) << "\n"
+                << (uint64_t)examined << "\n"
+                << classes.size() << "\n" << std::hex;
+            for(size_t c = 0; c < classes.size(); c++) {
+                for(size_t i = 0; i < classes[c].size(); i++) {
+                    out << (i ? " " : "") << classes[c][i];
+                }
+                out << "\n";
+            }
+            out.flush();
+            if(!out)
+                return false;
+        }
+        return rename(temp.c_str(), filename.c_str()) == 0;
+    }
+
+    bool ClassSearch::resume(const std::string &filename) {
+        std::ifstream in(filename.c_str());
+        std::string magic;
+        unsigned saved_rows, saved_cols;
+        uint32_t words;
+        uint64_t score, count;
+        std::string board;
+        size_t classes;
+        if(!std::getline(in, magic) || magic != CHECKPOINT_MAGIC)
+            return false;
+        if(!(in >> saved_rows >> saved_cols >> words >> score >> board >> count >> classes))
+            return false;
+        if(saved_rows != rows || saved_cols != cols || words != lexicon->wordCount())
+            return false;
+
+        std::vector<BoardClass> loaded(classes, BoardClass(rows * cols));
+        in >> std::hex;
+        for(size_t c = 0; c < classes; c++) {
+            for(unsigned i = 0; i < rows * cols; i++) {
+                if(!(in >> loaded[c][i]))
+                    return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        open.swap(loaded);
+        incumbent = score;
+        best = board == "-" ? "" : board;
+        examined = count;
+        stopping = false;
+        return true;
+    }
+
+    void ClassSearch::run(unsigned threads, const std::string &checkpoint, unsigned interval) {
+        // with no workers nothing would ever finish, and with no
+        // interval the loop below would never wait
+        threads = std::max(threads, 1u);
+        interval = std::max(interval, 1u);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            in_progress.assign(threads, BoardClass());
+        }
+        std::vector<std::thread> workers;
+        for(unsigned w = 0; w < threads; w++) {
+            workers.push_back(std::thread(&ClassSearch::work, this, w));
+        }
+
+        std::chrono::steady_clock::time_point next_save =
+            std::chrono::steady_clock::now() + std::chrono::seconds(interval);
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                if(wake.wait_until(guard, next_save, [this] { return done(); }))
+                    break;
+            }
+            if(!checkpoint.empty())
+                saveCheckpoint(checkpoint);
+            next_save = std::chrono::steady_clock::now() + std::chrono::seconds(interval);
+        }
+
+        for(size_t w = 0; w < workers.size(); w++) {
+            workers[w].join();
+        }
+        if(!checkpoint.empty())
+            saveCheckpoint(checkpoint);
+    }
+
+    void ClassSearch::stop() {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        wake.notify_all();
+    }
+
+    bool ClassSearch::finished() {
+        std::lock_guard<std::mutex> guard(lock);
+        return open.empty() && busy == 0;
+    }
+
+    uint64_t ClassSearch::bestScore() {
+        return incumbent;
+    }
+
+    std::string ClassSearch::bestBoard() {
+        std::lock_guard<std::mutex> guard(lock);
+        return best;
+    }
+
+    size_t ClassSearch::openClasses() {
+        std::lock_guard<std::mutex> guard(lock);
+        return open.size();
+    }
+
+    /**
+     * Takes the most recently opened class, bounds or scores it, and
+     * opens its children if it may hold a board beating the incumbent.
+     */
+    void ClassSearch::work(unsigned worker) {
+        BogglePlayer player;
+        player.shareLexicon(*master);
+        player.setScoringRules(table.rules());
+        ClassBounder bounder(*lexicon, table, rows, cols);
+        std::vector<BoardClass> children;
+
+        std::unique_lock<std::mutex> guard(lock);
+        for(;;) {
+            wake.wait(guard, [this] { return !open.empty() || done(); });
+            if(open.empty() || stopping)
+                break;
+            BoardClass current;
+            current.swap(open.back());
+            open.pop_back();
+            in_progress[worker] = current;
+            busy++;
+            guard.unlock();
+
+            examined++;
+            children.clear();
+            if(isConcrete(current)) {
+                score(player, current);
+            }
+            else if(bounder.bound(current) > incumbent) {
+                // the cell with the most letters, and among those the one
+                // with the most neighbours, which tightens the bound most
+                unsigned split = 0;
+                for(unsigned i = 1; i < current.size(); i++) {
+                    int more = __builtin_popcount(current[i]) - __builtin_popcount(current[split]);
+                    if(more > 0 || (more == 0 && bounder.degree(i) > bounder.degree(split)))
+                        split = i;
+                }
+                // pushed in reverse so that the lowest letter is tried first
+                for(uint32_t options = current[split]; options != 0; options &= options - 1) {
+                    children.push_back(current);
+                    children.back()[split] = options & -options;
+                }
+                std::reverse(children.begin(), children.end());
+            }
+
+            guard.lock();
+            busy--;
+            in_progress[worker].clear();
+            for(size_t c = 0; c < children.size(); c++) {
+                open.push_back(BoardClass());
+                open.back().swap(children[c]);
+            }
+            wake.notify_all();
+        }
+        wake.notify_all();
+    }
+
+    /* Scores a concrete board exactly, raising the incumbent if it wins */
+    void ClassSearch::score(BogglePlayer &player, const BoardClass &board_class) {
+        std::vector<std::string> dice = classDice(board_class);
+        std::vector<std::string *> board_rows(rows);
+        for(unsigned r = 0; r < rows; r++) {
+            board_rows[r] = &dice[r * cols];
+        }
+        player.setBoard(rows, cols, &board_rows[0]);
+        ScoreResult result;
+        player.scoreBoard(0, SCORE_BY_POINTS, &result);
+        if(result.total <= incumbent)
+            return;
+
+        std::lock_guard<std::mutex> guard(lock);
+        if(result.total > incumbent) {
+            incumbent = result.total;
+            best = classLetters(board_class);
+        }
+    }
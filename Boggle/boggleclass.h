@@ -0,0 +1,152 @@
+#ifndef BOGGLECLASS_H
+#define BOGGLECLASS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bogglescore.h"
+#include "flatlexicon.h"
+
+class BogglePlayer;
+
+/**
+ * A class of boards: for each cell in row-major order, the set of
+ * letters it may hold, bit k standing for 'a' + k. As on real dice, q
+ * stands for the Qu face.
+ */
+typedef std::vector<uint32_t> BoardClass;
+
+/* Whether every cell of the class holds exactly one letter */
+bool isConcrete(const BoardClass &board_class);
+
+/* The dice of a concrete class, "qu" for q */
+std::vector<std::string> classDice(const BoardClass &board_class);
+
+/* The letters of a concrete class as one string, q for Qu */
+std::string classLetters(const BoardClass &board_class);
+
+/**
+ * Computes an upper bound on the score of every board in a class in
+ * one traversal of the lexicon. Each path of cells is followed once,
+ * and at every cell the search takes whichever of the cell's letters
+ * leads to the most points below it; words are counted every time a
+ * path spells them. A real board can neither choose a letter per path
+ * nor score a word twice, so none scores more than the bound.
+ */
+class ClassBounder {
+  public:
+    ClassBounder(const FlatLexicon &lexicon, const ScoreTable &table,
+            unsigned rows, unsigned cols);
+
+    uint64_t bound(const BoardClass &board_class);
+
+    /* Number of neighbours of cell */
+    unsigned degree(unsigned cell) const { return (unsigned)neighbours[cell].size(); }
+
+  private:
+    uint64_t from(unsigned cell, const FlatLexNode *node, uint64_t visited);
+
+    const FlatLexicon &lexicon;
+    const ScoreTable &table;
+    std::vector<std::vector<unsigned> > neighbours;
+
+    /* Class being bounded */
+    const uint32_t *letters;
+};
+
+/**
+ * Exhaustive branch-and-bound search for the highest scoring board of
+ * a class. Classes whose bound beats the best score found so far (the
+ * incumbent) are split on the cell with the most letters, one class
+ * per letter; the others are dropped, and concrete boards are scored
+ * exactly. Worker threads share one stack of open classes and one
+ * incumbent. The open classes can be written to a checkpoint file at
+ * any time and the search resumed from it later.
+ */
+class ClassSearch {
+  public:
+    /**
+     * A search over rows x cols boards (at most 64 cells) using
+     * source's lexicon, scoring by rules.
+     */
+    ClassSearch(const BogglePlayer &source, unsigned rows, unsigned cols,
+            const ScoringRules &rules = ScoringRules::official());
+    ~ClassSearch();
+
+    /**
+     * Starts a search of whole, looking for boards that score more than
+     * incumbent (say, the best an annealing run found).
+     */
+    void start(const BoardClass &whole, uint64_t incumbent);
+
+    /* Loads the state saved by saveCheckpoint; false if the file can
+     * not be read or was written for another board size or lexicon */
+    bool resume(const std::string &filename);
+
+    /**
+     * Writes the incumbent and every class not yet finished to
+     * filename, replacing it atomically. Safe to call while run() is
+     * running; classes being worked on are saved as open.
+     */
+    bool saveCheckpoint(const std::string &filename);
+
+    /**
+     * Searches on threads threads until every class is finished or
+     * stop() is called, saving a checkpoint to checkpoint (if not
+     * empty) every interval seconds and on return. A threads or
+     * interval of 0 is taken as 1.
+     */
+    void run(unsigned threads, const std::string &checkpoint, unsigned interval);
+
+    /* Makes run() return once the classes in progress are done; the
+     * search can go on after the next start() or resume() */
+    void stop();
+
+    /* Whether the search has finished, proving the incumbent optimal */
+    bool finished();
+
+    uint64_t bestScore();
+
+    /* The best board found, as from classLetters; empty if none has
+     * beaten the starting incumbent */
+    std::string bestBoard();
+
+    uint64_t classesExamined() { return examined; }
+    size_t openClasses();
+
+  private:
+    ClassSearch(const ClassSearch &);
+    ClassSearch &operator=(const ClassSearch &);
+
+    void work(unsigned worker);
+    void score(BogglePlayer &player, const BoardClass &board_class);
+    bool done() const { return (open.empty() && busy == 0) || stopping; }
+
+    unsigned rows, cols;
+
+    /* Holds the lexicon and scoring rules; workers share them */
+    std::unique_ptr<BogglePlayer> master;
+    std::shared_ptr<const FlatLexicon> lexicon;
+    ScoreTable table;
+
+    /* Open classes, the class each worker holds and the best board;
+     * guarded by lock. The incumbent is only written under lock but
+     * read without it. */
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<BoardClass> open;
+    std::vector<BoardClass> in_progress;
+    unsigned busy;
+    std::atomic<uint64_t> incumbent;
+    std::string best;
+    bool stopping;
+
+    std::atomic<uint64_t> examined;
+};
+
+#endif // BOGGLECLASS_H
@@ -0,0 +1,101 @@
+/**
+ * boggleconv: converts boards between the text format of README_brd and
+ * binary board streams (see bogglestream.h).
+ *
+ * With -b the text boards in the given files (or stdin) are written to
+ * stdout as a board stream. Every board must have the size of the
+ * first, and only the dice of the standard alphabet (a-z, Qu and the
+ * blank ?) are accepted; a board that breaks either rule is reported
+ * and ends the conversion.
+ *
+ * With -t the board streams given are written to stdout as text.
+ *
+ * usage: boggleconv -b [text files...] > boards.bbs
+ *        boggleconv -t board streams...
+ */
+
+#include "bogglestream.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/* Appends the text boards in in to the stream, started on the first */
+static bool toStream(std::istream &in, std::unique_ptr<BoardStreamWriter> *writer,
+        unsigned long *index) {
+    unsigned rows, cols;
+    std::vector<std::string> dice;
+    while(readTextBoard(in, &rows, &cols, &dice)) {
+        if(!*writer) {
+            writer->reset(new BoardStreamWriter(std::cout, rows, cols));
+            if(!(*writer)->good()) {
+                std::cerr << "Board " << *index << " is too large" << std::endl;
+                return false;
+            }
+        }
+        if(rows != (*writer)->rows() || cols != (*writer)->cols() || !(*writer)->add(dice)) {
+            std::cerr << "Board " << *index << " has a different size than the first"
+                " or a die outside a-z, Qu and ?" << std::endl;
+            return false;
+        }
+        (*index)++;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    char mode = 0;
+    int opt;
+    while((opt = getopt(argc, argv, "bt")) != -1) {
+        switch(opt) {
+            case 'b': mode = 'b'; break;
+            case 't': mode = 't'; break;
+            default: mode = 0; optind = argc; break;
+        }
+    }
+    if(mode == 0 || (mode == 't' && optind == argc)) {
+        std::cerr << "usage: " << argv[0] << " -b [text files...] > boards.bbs\n"
+            "       " << argv[0] << " -t board streams..." << std::endl;
+        return 1;
+    }
+
+    if(mode == 't') {
+        std::vector<std::string> dice;
+        for(int i = optind; i < argc; i++) {
+            BoardStreamReader stream;
+            if(!stream.open(argv[i])) {
+                std::cerr << "Could not map board stream " << argv[i] << std::endl;
+                return 1;
+            }
+            if(stream.truncatedBytes() != 0)
+                std::cerr << "Board stream " << argv[i] << " ends in a partial board of "
+                    << stream.truncatedBytes() << " bytes; ignored" << std::endl;
+            for(size_t b = 0; b < stream.size(); b++) {
+                stream.board(b, &dice);
+                writeTextBoard(std::cout, stream.rows(), stream.cols(), dice);
+            }
+        }
+        return std::cout.good() ? 0 : 1;
+    }
+
+    std::unique_ptr<BoardStreamWriter> writer;
+    unsigned long index = 0;
+    if(optind == argc && !toStream(std::cin, &writer, &index))
+        return 1;
+    for(int i = optind; i < argc; i++) {
+        std::ifstream in(argv[i]);
+        if(!in) {
+            std::cerr << "Could not open board file " << argv[i] << std::endl;
+            return 1;
+        }
+        if(!toStream(in, &writer, &index))
+            return 1;
+    }
+    std::cout.flush();
+    std::cerr << index << " boards" << std::endl;
+    return std::cout.good() ? 0 : 1;
+}
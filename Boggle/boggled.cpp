@@ -0,0 +1,486 @@
+/**
+ * boggled: long-running solver daemon.
+ *
+ * Loads the lexicon once, then serves boggleproto requests over a Unix
+ * domain socket or loopback TCP. One I/O thread polls every connection
+ * and queues connections that have complete request frames; a fixed
+ * pool of solver threads drains the queue. A connection is handled by
+ * at most one solver thread at a time, so pipelined requests are
+ * answered in order and each connection keeps its own board.
+ *
+ * With -c N solve results are cached for up to N boards, a rotated or
+ * mirrored copy of a board counting as the same board, and with -C
+ * FILE also in FILE across runs (see SolveCache). The stats request
+ * reports the hit rate and the solving time saved.
+ *
+ * usage: boggled [-l lexicon] [-a address] [-t threads] [-c entries] [-C file]
+ *
+ * Without -l the lexicon compiled into the program is used, if it was
+ * built with one (boggled_EMBED in the Makefile), and boglex.txt
+ * otherwise.
+ */
+
+#include "bogglecache.h"
+#include "boggleplayer.h"
+#include "boggleproto.h"
+#include "lexiconloader.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char *DEFAULTLEXFILENAME = "boglex.txt";
+static const char *DEFAULTADDRESS = "unix:/tmp/boggled.sock";
+
+/* Stop reading from a client that has this much unprocessed input */
+static const size_t MAX_PENDING_INPUT = 4 * MAX_FRAME_SIZE;
+
+/* Largest board a client may set */
+static const unsigned MAX_BOARD_CELLS = 4096;
+
+/* Cache size when only a cache file is given */
+static const size_t DEFAULTCACHEENTRIES = 10000;
+
+static std::atomic<bool> stopping(false);
+
+static void onSignal(int) {
+    stopping = true;
+}
+
+/**
+ * One client connection. inbuf and scheduled are shared between the
+ * I/O thread and the solver threads and guarded by lock; player and the
+ * board it was last given are only touched by the solver thread that
+ * has the connection scheduled.
+ */
+struct Connection {
+    int fd;
+    BogglePlayer player;
+    unsigned rows, cols;
+    std::vector<std::string> dice;
+
+    std::mutex lock;
+    std::string inbuf;
+    bool scheduled;
+
+    Connection(int fd) : fd(fd), rows(0), cols(0), scheduled(false) {}
+    ~Connection() { close(fd); }
+};
+
+typedef std::shared_ptr<Connection> ConnectionPtr;
+
+/* Per solver thread latency histograms, one per opcode */
+struct WorkerStats {
+    std::mutex lock;
+    std::map<int, LatencyHistogram> latency;
+};
+
+static const char *opName(int op) {
+    switch(op) {
+        case OP_PING: return "ping";
+        case OP_SET_BOARD: return "set_board";
+        case OP_SOLVE: return "solve";
+        case OP_SET_BOARD_SOLVE: return "set_board_solve";
+        case OP_IS_WORD: return "is_word";
+        case OP_PATH: return "path";
+        case OP_STATS: return "stats";
+    }
+    return "unknown";
+}
+
+class Server {
+  public:
+    Server(const BogglePlayer &loaded, unsigned threads, SolveCache *cache)
+        : lexicon_source(loaded), cache(cache), stats(threads) {
+        for(unsigned i = 0; i < threads; i++) {
+            stats[i].reset(new WorkerStats());
+        }
+        for(unsigned i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&Server::workerLoop, this, i));
+        }
+    }
+
+    /* Runs the I/O loop until a signal arrives */
+    void run(int listen_fd);
+
+    /* Joins the solver threads */
+    void shutdown();
+
+    /* Latency percentiles per opcode across all solver threads, and the
+     * cache's counters */
+    std::string report();
+
+  private:
+    void workerLoop(unsigned id);
+    void serve(const ConnectionPtr &conn, WorkerStats *mine);
+    bool handle(Connection &conn, FrameReader &req, uint8_t op, FrameWriter &resp);
+    bool readBoard(FrameReader &req, Connection &conn);
+    void schedule(const ConnectionPtr &conn);
+
+    const BogglePlayer &lexicon_source;
+
+    /* Shared by all solver threads; NULL without -c or -C */
+    SolveCache *cache;
+
+    std::mutex queue_lock;
+    std::condition_variable queue_ready;
+    std::deque<ConnectionPtr> queue;
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerStats> > stats;
+};
+
+    void Server::schedule(const ConnectionPtr &conn) {
+        {
+            std::lock_guard<std::mutex> guard(queue_lock);
+            queue.push_back(conn);
+        }
+        queue_ready.notify_one();
+    }
+
+    void Server::run(int listen_fd) {
+        std::vector<ConnectionPtr> conns;
+        std::vector<pollfd> fds;
+        std::vector<char> chunk(64 * 1024);
+
+        while(!stopping) {
+            fds.clear();
+            pollfd lp = { listen_fd, POLLIN, 0 };
+            fds.push_back(lp);
+            for(size_t i = 0; i < conns.size(); i++) {
+                pollfd p = { conns[i]->fd, POLLIN, 0 };
+                std::lock_guard<std::mutex> guard(conns[i]->lock);
+                if(conns[i]->inbuf.size() > MAX_PENDING_INPUT)
+                    p.events = 0;   // let the solver catch up first
+                fds.push_back(p);
+            }
+
+            if(poll(&fds[0], fds.size(), 200) <= 0)
+                continue;
+
+            if(fds[0].revents & POLLIN) {
+                int fd = accept(listen_fd, NULL, NULL);
+                if(fd >= 0) {
+                    ConnectionPtr conn = std::make_shared<Connection>(fd);
+                    conn->player.shareLexicon(lexicon_source);
+                    conns.push_back(conn);
+                }
+            }
+
+            std::vector<ConnectionPtr> alive;
+            for(size_t i = 0; i < conns.size(); i++) {
+                ConnectionPtr &conn = conns[i];
+                short ev = fds[i + 1].revents;
+                bool gone = false;
+                if(ev & (POLLIN | POLLHUP | POLLERR)) {
+                    ssize_t n = recv(conn->fd, &chunk[0], chunk.size(), 0);
+                    gone = n <= 0;
+
+                    std::lock_guard<std::mutex> guard(conn->lock);
+                    if(n > 0)
+                        conn->inbuf.append(&chunk[0], n);
+
+                    uint32_t size;
+                    bool bad = false;
+                    if(!conn->scheduled && frameComplete(conn->inbuf, &size, &bad)) {
+                        conn->scheduled = true;
+                        schedule(conn);
+                    }
+                    if(bad)
+                        gone = true;
+                }
+                if(!gone)
+                    alive.push_back(conn);
+            }
+            conns.swap(alive);
+        }
+
+        std::lock_guard<std::mutex> guard(queue_lock);
+        queue_ready.notify_all();
+    }
+
+    void Server::shutdown() {
+        for(size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+    void Server::workerLoop(unsigned id) {
+        while(true) {
+            ConnectionPtr conn;
+            {
+                std::unique_lock<std::mutex> guard(queue_lock);
+                while(queue.empty() && !stopping)
+                    queue_ready.wait(guard);
+                if(queue.empty())
+                    return;
+                conn = queue.front();
+                queue.pop_front();
+            }
+            serve(conn, stats[id].get());
+        }
+    }
+
+    /* Answers every complete frame buffered on conn, then unschedules
+     * it. Replies are flushed before the connection is given up so that
+     * the next solver thread to pick it up cannot overtake them. */
+    void Server::serve(const ConnectionPtr &conn, WorkerStats *mine) {
+        std::string payload;
+        std::string out;
+        bool broken = false;
+
+        while(true) {
+            bool have_frame = false;
+            {
+                std::lock_guard<std::mutex> guard(conn->lock);
+                uint32_t size;
+                bool bad = false;
+                if(frameComplete(conn->inbuf, &size, &bad)) {
+                    payload.assign(conn->inbuf, 4, size);
+                    conn->inbuf.erase(0, 4 + size);
+                    have_frame = true;
+                }
+                else if(out.empty()) {
+                    conn->scheduled = false;
+                    return;
+                }
+            }
+
+            if(!have_frame) {
+                // caught up with the input: flush in one syscall
+                if(!broken && !writeFull(conn->fd, out.data(), out.size())) {
+                    broken = true;
+                    ::shutdown(conn->fd, SHUT_RDWR);
+                }
+                out.clear();
+                continue;
+            }
+
+            uint64_t start = nowMicros();
+            FrameReader req(payload.data(), payload.size());
+            FrameWriter resp;
+            uint8_t op = 0xff;
+            if(!req.getU8(&op) || !handle(*conn, req, op, resp)) {
+                resp = FrameWriter();
+                resp.putU8(STATUS_BAD_REQUEST);
+            }
+            out += resp.finish();
+
+            std::lock_guard<std::mutex> guard(mine->lock);
+            mine->latency[op].record(nowMicros() - start);
+        }
+    }
+
+    /* Reads u16 rows, u16 cols and the dice, and sets them on conn's
+     * player */
+    bool Server::readBoard(FrameReader &req, Connection &conn) {
+        uint16_t rows, cols;
+        if(!req.getU16(&rows) || !req.getU16(&cols))
+            return false;
+        if(rows == 0 || cols == 0 || (unsigned)rows * cols > MAX_BOARD_CELLS)
+            return false;
+
+        std::vector<std::string> dice((unsigned)rows * cols);
+        for(size_t i = 0; i < dice.size(); i++) {
+            if(!req.getString(&dice[i]))
+                return false;
+        }
+        conn.rows = rows;
+        conn.cols = cols;
+        conn.dice = dice;
+        std::vector<std::string *> board(rows);
+        for(unsigned r = 0; r < rows; r++) {
+            board[r] = &dice[r * cols];
+        }
+        conn.player.setBoard(rows, cols, &board[0]);
+        return true;
+    }
+
+    /* Executes one request. Returns false if it was malformed. */
+    bool Server::handle(Connection &conn, FrameReader &req, uint8_t op,
+            FrameWriter &resp) {
+        BogglePlayer &player = conn.player;
+        uint16_t min_len = 0;
+        std::string word;
+
+        switch(op) {
+            case OP_PING:
+                break;
+
+            case OP_SET_BOARD:
+                if(!readBoard(req, conn))
+                    return false;
+                break;
+
+            case OP_SOLVE:
+            case OP_SET_BOARD_SOLVE: {
+                if(!req.getU16(&min_len))
+                    return false;
+                if(op == OP_SET_BOARD_SOLVE && !readBoard(req, conn))
+                    return false;
+                std::set<std::string> words;
+                bool solved = cache && !conn.dice.empty() ?
+                    cache->getAllValidWords(player, conn.rows, conn.cols, conn.dice, min_len, &words) :
+                    player.getAllValidWords(min_len, &words);
+                if(!solved) {
+                    resp.putU8(STATUS_NO_BOARD);
+                    return req.atEnd();
+                }
+                resp.putU8(STATUS_OK);
+                resp.putU32((uint32_t)words.size());
+                for(std::set<std::string>::const_iterator it = words.begin();
+                        it != words.end(); ++it) {
+                    resp.putString(*it);
+                }
+                return req.atEnd();
+            }
+
+            case OP_IS_WORD:
+                if(!req.getString(&word))
+                    return false;
+                resp.putU8(STATUS_OK);
+                resp.putU8(player.isInLexicon(player.setLowerCase(word)));
+                return req.atEnd();
+
+            case OP_PATH: {
+                if(!req.getString(&word))
+                    return false;
+                std::vector<int> path = player.isOnBoard(word);
+                resp.putU8(STATUS_OK);
+                resp.putU16((uint16_t)path.size());
+                for(size_t i = 0; i < path.size(); i++) {
+                    resp.putU16((uint16_t)path[i]);
+                }
+                return req.atEnd();
+            }
+
+            case OP_STATS:
+                resp.putU8(STATUS_OK);
+                resp.putText(report());
+                return req.atEnd();
+
+            default:
+                return false;
+        }
+
+        resp.putU8(STATUS_OK);
+        return req.atEnd();
+    }
+
+    std::string Server::report() {
+        std::map<int, LatencyHistogram> merged;
+        for(size_t i = 0; i < stats.size(); i++) {
+            std::lock_guard<std::mutex> guard(stats[i]->lock);
+            std::map<int, LatencyHistogram>::const_iterator it;
+            for(it = stats[i]->latency.begin(); it != stats[i]->latency.end(); ++it) {
+                merged[it->first].merge(it->second);
+            }
+        }
+        std::ostringstream out;
+        std::map<int, LatencyHistogram>::const_iterator it;
+        for(it = merged.begin(); it != merged.end(); ++it) {
+            out << opName(it->first) << ": " << it->second.summary() << "\n";
+        }
+        if(probesEnabled())
+            out << "probes: " << probeTotals().toJson() << "\n";
+        if(cache)
+            out << "cache: " << cache->stats().toJson() << "\n";
+        return out.str();
+    }
+
+int main(int argc, char *argv[]) {
+    const char *lexfilename = NULL;
+    std::string address = DEFAULTADDRESS;
+    unsigned threads = std::thread::hardware_concurrency();
+    if(threads == 0)
+        threads = 4;
+    size_t cache_entries = 0;
+    const char *cache_file = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "l:a:t:c:C:")) != -1) {
+        switch(opt) {
+            case 'l': lexfilename = optarg; break;
+            case 'a': address = optarg; break;
+            case 't': threads = atoi(optarg); break;
+            case 'c': cache_entries = strtoul(optarg, NULL, 10); break;
+            case 'C': cache_file = optarg; break;
+            default:
+                std::cerr << "usage: " << argv[0]
+                    << " [-l lexicon] [-a unix:PATH|tcp:PORT] [-t threads]"
+                    " [-c entries] [-C file]" << std::endl;
+                return 1;
+        }
+    }
+    if(threads == 0)
+        threads = 1;
+
+    // the lexicon is read and built exactly once; every connection's
+    // player shares this trie
+    // use the compiled-in lexicon (boggled_EMBED) unless told otherwise
+    if(lexfilename == NULL && embeddedLexicon() == NULL)
+        lexfilename = DEFAULTLEXFILENAME;
+    std::unique_ptr<BogglePlayer> player(lexfilename == NULL ?
+            new BogglePlayer(*embeddedLexicon()) : new BogglePlayer());
+    BogglePlayer &loaded = *player;
+    if(lexfilename != NULL) {
+        WordList words;
+        if(!loadWordList(lexfilename, &words)) {
+            std::cerr << "Could not read lexicon file " << lexfilename << std::endl;
+            return 1;
+        }
+        loaded.buildLexicon(words);
+        std::cout << words.size() << " distinct words read from " << lexfilename << std::endl;
+    }
+
+    std::unique_ptr<SolveCache> cache;
+    if(cache_entries > 0 || cache_file != NULL) {
+        cache.reset(new SolveCache(cache_entries > 0 ? cache_entries : DEFAULTCACHEENTRIES));
+        if(cache_file != NULL && !cache->openDisk(cache_file)) {
+            std::cerr << "Could not open cache file " << cache_file
+                << " (unreadable, not a cache file, or in use)" << std::endl;
+            return 1;
+        }
+    }
+
+    int listen_fd = listenOn(address);
+    if(listen_fd < 0)
+        return 1;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Serving " << address << " with " << threads
+        << " solver threads" << std::endl;
+
+    Server server(loaded, threads, cache.get());
+    server.run(listen_fd);
+    server.shutdown();
+    close(listen_fd);
+    if(address.compare(0, 5, "unix:") == 0)
+        unlink(address.c_str() + 5);
+
+    std::cout << server.report();
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * boggledesign: designs a board holding the given theme words.
+ *
+ * Runs BoardSynthesizer for a rows x cols board (wrapped with -w, hex
+ * with -x) on which every word given can be traced, and prints the
+ * best board found, the path of each word on it and how the search
+ * went. The dice no word needs are chosen for as many other words as
+ * possible, or with -f as few; -m sets the shortest word that counts
+ * and -L the letters they may show. The search runs on -t threads for
+ * -T seconds or -n attempts; with -T 0 and no -n it ends at the first
+ * board found, for timing that. Exits with 2 if no board was found.
+ *
+ * usage: boggledesign [-l lexicon] [-r rows] [-c cols] [-w | -x] [-f]
+ *                     [-m min_len] [-L letters] [-t threads] [-T secs]
+ *                     [-n attempts] [-s seed] word...
+ */
+
+#include "boggleplayer.h"
+#include "bogglesynth.h"
+#include "lexiconloader.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+static const char *DEFAULTLEXFILENAME = "boglex.txt";
+
+int main(int argc, char *argv[]) {
+    const char *lexfilename = DEFAULTLEXFILENAME;
+    unsigned rows = 4, cols = 4;
+    bool wrapped = false, hex = false;
+    std::string letters = "abcdefghijklmnopqrstuvwxyz";
+    SynthOptions options;
+    options.threads = std::thread::hardware_concurrency();
+
+    int opt;
+    while((opt = getopt(argc, argv, "l:r:c:wxfm:L:t:T:n:s:")) != -1) {
+        switch(opt) {
+            case 'l': lexfilename = optarg; break;
+            case 'r': rows = atoi(optarg); break;
+            case 'c': cols = atoi(optarg); break;
+            case 'w': wrapped = true; break;
+            case 'x': hex = true; break;
+            case 'f': options.goal = SYNTH_FEWEST_WORDS; break;
+            case 'm': options.rules.minimum_length = atoi(optarg); break;
+            case 'L': letters = optarg; break;
+            case 't': options.threads = atoi(optarg); break;
+            case 'T': options.seconds = atof(optarg); break;
+            case 'n': options.attempts = strtoull(optarg, NULL, 10); break;
+            case 's': options.seed = strtoull(optarg, NULL, 10); break;
+            default:
+                std::cerr << "usage: " << argv[0] << " [-l lexicon] [-r rows] [-c cols]"
+                    " [-w | -x] [-f] [-m min_len] [-L letters] [-t threads] [-T secs]"
+                    " [-n attempts] [-s seed] word..." << std::endl;
+                return 1;
+        }
+    }
+    if(optind == argc) {
+        std::cerr << "No words to place" << std::endl;
+        return 1;
+    }
+    if(rows * cols == 0 || rows * cols > 64) {
+        std::cerr << "Boards must have 1 to 64 cells" << std::endl;
+        return 1;
+    }
+    if(options.threads == 0)
+        options.threads = 1;
+
+    options.letters = 0;
+    for(size_t i = 0; i < letters.size(); i++) {
+        unsigned k = (unsigned char)(tolower((unsigned char)letters[i]) - 'a');
+        if(k < 26)
+            options.letters |= 1u << k;
+    }
+    if(options.letters == 0) {
+        std::cerr << "No letters for the free dice" << std::endl;
+        return 1;
+    }
+
+    WordList words;
+    if(!loadWordList(lexfilename, &words)) {
+        std::cerr << "Could not read lexicon file " << lexfilename << std::endl;
+        return 1;
+    }
+    BogglePlayer player;
+    player.buildLexicon(words);
+
+    BoardTopology topology = hex ? BoardTopology::hex(rows, cols)
+        : wrapped ? BoardTopology::torus(rows, cols) : BoardTopology::grid(rows, cols);
+    std::vector<std::string> targets(argv + optind, argv + argc);
+    BoardSynthesizer synthesizer(player, topology, targets, options);
+    if(!synthesizer.valid()) {
+        std::cerr << "Some word can not be spelled with dice on this board"
+            " (letters a-z only, q followed by u, at most " << rows * cols << " dice)" << std::endl;
+        return 1;
+    }
+
+    SynthResult result;
+    synthesizer.run(&result);
+    if(result.found) {
+        for(unsigned r = 0; r < rows; r++) {
+            for(unsigned c = 0; c < cols; c++) {
+                std::string die = result.dice[r * cols + c];
+                die[0] = (char)toupper((unsigned char)die[0]);
+                std::cout << (c == 0 ? "" : " ") << die;
+            }
+            std::cout << "\n";
+        }
+        std::cout << result.words << " words, " << result.points << " points\n";
+        for(size_t t = 0; t < targets.size(); t++) {
+            std::cout << "  " << targets[t] << ":";
+            for(size_t i = 0; i < result.paths[t].size(); i++)
+                std::cout << " " << result.paths[t][i];
+            std::cout << "\n";
+        }
+        std::cout << "first board after " << result.first_seconds << " s, this one after "
+            << result.best_seconds << " s\n";
+    }
+    else {
+        std::cout << (result.impossible ? "No board can hold every word\n"
+            : "No board found in time\n");
+    }
+    std::cout << result.attempts << " attempts, " << result.backtracks << " backtracks, "
+        << result.evaluations << " boards scored" << std::endl;
+    return result.found ? 0 : 2;
+}
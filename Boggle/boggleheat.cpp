@@ -0,0 +1,10 @@
+#include "boggleheat.h"
+
+    void CellHeatSink::finish() {
+        for(size_t i = 0; i < found.size(); i++) {
+            uint64_t &traced = word_cells[found[i]];
+            spread(traced, table.points(found[i]), &heat->words, &heat->points);
+            traced = 0;
+        }
+        found.clear();
+    }
@@ -0,0 +1,113 @@
+#ifndef BOGGLEHEAT_H
+#define BOGGLEHEAT_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "bogglescore.h"
+#include "flatlexicon.h"
+#include "lexiconquery.h"
+
+/**
+ * How much of a board's score runs through each die, indexed by board
+ * position. Only words that count under the scoring rules are counted,
+ * each once per die however many of its paths cross it.
+ */
+struct CellHeat {
+    /* Distinct words with some path through the die, and their points */
+    std::vector<uint32_t> words;
+    std::vector<uint64_t> points;
+
+    /* The same for the first path the search traced for each word only,
+     * so that every word is spread over exactly one path's dice. Which
+     * path comes first depends on the search (see
+     * BogglePlayer::setInterleavedCursors), not on isOnBoard. */
+    std::vector<uint32_t> first_words;
+    std::vector<uint64_t> first_points;
+
+    void assign(unsigned cells) {
+        words.assign(cells, 0);
+        points.assign(cells, 0);
+        first_words.assign(cells, 0);
+        first_points.assign(cells, 0);
+    }
+};
+
+/**
+ * ScoreCounter that also gathers a CellHeat, in the same search. The
+ * search hands it the dice of every path to a counting word as a bit
+ * mask, so boards are limited to 64 dice. The dice of all a word's
+ * paths are merged per word and only spread over the cells by
+ * finish(), so a word with many paths costs one OR per path.
+ */
+class CellHeatSink : public ScoreCounter {
+  public:
+    static const bool KEEPS_PATH = true;
+
+    /* word_cells must have an entry for every word of the lexicon, all
+     * zero; finish() leaves them zero again */
+    CellHeatSink(const ScoreTable &table, WordStamps &seen, ScoreResult *result,
+            std::vector<uint64_t> &word_cells, unsigned cells, CellHeat *heat)
+            : ScoreCounter(table, seen, result), word_cells(word_cells), heat(heat) {
+        heat->assign(cells);
+    }
+
+    void path(const FlatLexNode *node, uint64_t cells) {
+        uint64_t &traced = word_cells[node->word_id];
+        if(traced == 0) {
+            found.push_back(node->word_id);
+            spread(cells, table.points(node->word_id), &heat->first_words, &heat->first_points);
+        }
+        traced |= cells;
+    }
+
+    /* Spreads each word found over the dice of all its paths */
+    void finish();
+
+  private:
+    static void spread(uint64_t cells, unsigned points, std::vector<uint32_t> *words,
+            std::vector<uint64_t> *totals) {
+        for(; cells != 0; cells &= cells - 1) {
+            unsigned cell = __builtin_ctzll(cells);
+            (*words)[cell]++;
+            (*totals)[cell] += points;
+        }
+    }
+
+    std::vector<uint64_t> &word_cells;
+    std::vector<int32_t> found;
+    CellHeat *heat;
+};
+
+/**
+ * CellHeatSink that also hands every counting word to a callback the
+ * first time the search reaches it, so that one search both lists the
+ * board's words and gathers their heat. Once the callback returns
+ * false no further node is entered.
+ */
+class CellHeatWordSink : public CellHeatSink {
+  public:
+    static const bool KEEPS_WORD = true;
+
+    CellHeatWordSink(const ScoreTable &table, WordStamps &seen, ScoreResult *result,
+            std::vector<uint64_t> &word_cells, unsigned cells, CellHeat *heat,
+            const WordCallback &callback)
+            : CellHeatSink(table, seen, result, word_cells, cells, heat), callback(callback),
+              stopped(false) {}
+
+    bool enters(const FlatLexNode *) const { return !stopped; }
+
+    bool add(const FlatLexNode *node, const std::string &word) {
+        if(!CellHeatSink::add(node, word))
+            return false;
+        if(!stopped && !callback(word))
+            stopped = true;
+        return true;
+    }
+
+  private:
+    const WordCallback &callback;
+    bool stopped;
+};
+
+#endif // BOGGLEHEAT_H
@@ -0,0 +1,213 @@
+#ifndef BOGGLEINTERLEAVE_H
+#define BOGGLEINTERLEAVE_H
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bogglescore.h"
+#include "boggletopology.h"
+#include "boggleutil.h"
+#include "flatlexicon.h"
+
+/**
+ * Board search that runs several depth-first walks at once to overlap
+ * their trie misses. A single walk stalls on every step, since it can
+ * not know where the next node is until the current one has arrived.
+ * Here each cursor is a resumable walk with its own explicit stack:
+ * when it has worked out the address of the next node it prefetches
+ * it and yields, and the other cursors take their steps while the
+ * node comes in. Cursors take start cells from a shared counter as
+ * they run dry, so they stay busy until the board is done.
+ *
+ * Finds exactly what the recursive searches find, in a different order,
+ * and feeds the same sinks (see bogglescore.h). Boards are limited to
+ * 64 dice.
+ */
+class InterleavedSearch {
+  public:
+    static const unsigned MAX_CELLS = 64;
+
+    /* A search of a board of the given topology with the given
+     * lowercased dice, one per cell */
+    InterleavedSearch(const BoardTopology &topology, const std::vector<std::string> &dice)
+            : dice(dice), blanks(0), topology(topology) {
+        for(unsigned i = 0; i < dice.size() && i < MAX_CELLS; i++) {
+            if(isWildcardDie(dice[i]))
+                blanks |= (uint64_t)1 << i;
+        }
+    }
+
+    /* Feeds every word of lexicon on the board to sink, using the
+     * given number of cursors. The search keeps its cursors on the
+     * stack, so any number of threads may search at once. */
+    template <class Sink>
+    void search(const FlatLexicon &lexicon, unsigned cursor_count, Sink &sink) const {
+        if(dice.size() > MAX_CELLS)
+            return;
+        if(cursor_count == 0)
+            cursor_count = 1;
+        Walk walk = { &lexicon, 0, std::vector<Cursor>(cursor_count) };
+        std::vector<Cursor *> live;
+        for(unsigned i = 0; i < cursor_count; i++) {
+            walk.cursors[i].visited = 0;
+            if(step<Sink>(walk, walk.cursors[i]))
+                live.push_back(&walk.cursors[i]);
+        }
+
+        // round robin; a cursor that runs out of work is dropped by
+        // moving the last one into its place
+        while(!live.empty()) {
+            for(size_t i = 0; i < live.size(); ) {
+                arrive(walk, *live[i], sink);
+                if(step<Sink>(walk, *live[i])) {
+                    i++;
+                }
+                else {
+                    live[i] = live.back();
+                    live.pop_back();
+                }
+            }
+        }
+    }
+
+  private:
+    /* One die on a cursor's path. A frame with cell -1 stands before
+     * the first die and has only the start cell as its neighbour. */
+    struct Frame {
+        int cell;
+        int start;
+        unsigned direction;         // next neighbour to try
+        uint32_t options;           // letters left to try for a blank neighbour
+        const FlatLexNode *node;    // where the dice up to cell lead
+        size_t word_size;           // length of the word before cell
+    };
+
+    /* A resumable walk, waiting for the node of its next step */
+    struct Cursor {
+        std::vector<Frame> stack;
+        uint64_t visited;
+        std::string word;
+        WildcardLetters letters;    // for sinks that keep blanks
+        int pending_cell;
+        char pending_letter;        // letter a blank stands for, or 0
+        const FlatLexNode *pending;
+    };
+
+    /* State of one search: its cursors and the next start cell to
+     * hand out */
+    struct Walk {
+        const FlatLexicon *lexicon;
+        size_t next_start;
+        std::vector<Cursor> cursors;
+    };
+
+    unsigned degree(const Frame &frame) const {
+        return frame.cell < 0 ? 1 : topology.degree(frame.cell);
+    }
+
+    int neighbour(const Frame &frame, unsigned direction) const {
+        if(frame.cell < 0)
+            return frame.start;
+        return topology.neighbours(frame.cell)[direction];
+    }
+
+    /**
+     * Works out the cursor's next step, from the frames on its stack or
+     * a fresh start cell, prefetches the node it leads to and returns
+     * true; or returns false if the board has no work left for it.
+     */
+    template <class Sink>
+    bool step(Walk &walk, Cursor &cursor) const {
+        for(;;) {
+            if(cursor.stack.empty()) {
+                if(walk.next_start >= dice.size())
+                    return false;
+                Frame frame = { -1, (int)walk.next_start++, 0, 0, walk.lexicon->getRoot(), 0 };
+                cursor.stack.push_back(frame);
+            }
+            Frame &frame = cursor.stack.back();
+            int cell;
+            const FlatLexNode *child;
+            char letter = 0;
+            if(frame.options != 0) {
+                unsigned k = __builtin_ctz(frame.options);
+                frame.options &= frame.options - 1;
+                cell = neighbour(frame, frame.direction - 1);
+                child = walk.lexicon->firstChild(frame.node)
+                    + __builtin_popcount(frame.node->child_mask & ((1u << k) - 1));
+                letter = (char)('a' + k);
+            }
+            else if(frame.direction == degree(frame)) {
+                if(frame.cell >= 0)
+                    cursor.visited &= ~((uint64_t)1 << frame.cell);
+                if(Sink::KEEPS_WORD)
+                    cursor.word.resize(frame.word_size);
+                if(Sink::KEEPS_BLANKS && frame.cell >= 0 && ((blanks >> frame.cell) & 1))
+                    cursor.letters.pop_back();
+                cursor.stack.pop_back();
+                continue;
+            }
+            else {
+                cell = neighbour(frame, frame.direction++);
+                if((cursor.visited >> cell) & 1)
+                    continue;
+                if((blanks >> cell) & 1) {
+                    frame.options = frame.node->child_mask;
+                    continue;
+                }
+                child = walk.lexicon->getChild(frame.node, dice[cell].empty() ? 0 : dice[cell][0]);
+                if(child == NULL)
+                    continue;
+            }
+            __builtin_prefetch(child);
+            cursor.pending_cell = cell;
+            cursor.pending_letter = letter;
+            cursor.pending = child;
+            return true;
+        }
+    }
+
+    /* Takes the step step() prepared, now that its node is (likely) in
+     * cache: finishes the die, pushes its frame and emits the word */
+    template <class Sink>
+    void arrive(const Walk &walk, Cursor &cursor, Sink &sink) const {
+        int cell = cursor.pending_cell;
+        const FlatLexNode *node = cursor.pending;
+        const std::string &text = dice[cell];
+        if(cursor.pending_letter == 0) {
+            for(size_t k = 1; k < text.size() && node != NULL; k++)
+                node = walk.lexicon->getChild(node, text[k]);
+            if(node == NULL)
+                return;
+        }
+        if(!sink.enters(node))
+            return;
+
+        Frame frame = { cell, 0, 0, 0, node, cursor.word.size() };
+        if(Sink::KEEPS_WORD) {
+            if(cursor.pending_letter != 0)
+                cursor.word.push_back(cursor.pending_letter);
+            else
+                cursor.word.append(text);
+        }
+        if(Sink::KEEPS_BLANKS && cursor.pending_letter != 0)
+            cursor.letters.push_back(std::make_pair(cell, cursor.pending_letter));
+        cursor.visited |= (uint64_t)1 << cell;
+        cursor.stack.push_back(frame);
+        if(node->word_id >= 0 && sink.wants(node, cursor.word.size())) {
+            if(Sink::KEEPS_PATH)
+                sink.path(node, cursor.visited);
+            if(Sink::KEEPS_BLANKS)
+                sink.blanks(node, cursor.letters);
+            sink.add(node, cursor.word);
+        }
+    }
+
+    std::vector<std::string> dice;
+    uint64_t blanks;
+    BoardTopology topology;
+};
+
+#endif // BOGGLEINTERLEAVE_H
@@ -0,0 +1,13 @@
+#include "bogglekernel.h"
+
+    /* The board sizes that get their own kernel */
+    BoardKernel *makeBoardKernel(unsigned rows, unsigned cols,
+            const std::vector<std::string> &dice) {
+        if(rows == 4 && cols == 4)
+            return new FixedKernel<4, 4>(dice);
+        if(rows == 5 && cols == 5)
+            return new FixedKernel<5, 5>(dice);
+        if(rows == 6 && cols == 6)
+            return new FixedKernel<6, 6>(dice);
+        return NULL;
+    }
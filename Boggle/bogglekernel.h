@@ -0,0 +1,515 @@
+#ifndef BOGGLEKERNEL_H
+#define BOGGLEKERNEL_H
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "boggleheat.h"
+#include "bogglepaths.h"
+#include "boggleprobe.h"
+#include "bogglescore.h"
+#include "boggleutil.h"
+#include "flatlexicon.h"
+#include "lexiconset.h"
+
+class LexiconSetSink;
+class WildcardWordSink;
+class WordBufferSink;
+class WordCallbackSink;
+
+/**
+ * Board search specialized for one board size. BogglePlayer::setBoard
+ * picks a kernel when the board has a size with a specialization and
+ * falls back to its generic search otherwise.
+ *
+ * A kernel holds only the board; every search keeps its state on the
+ * stack and counts what it does into the caller's probes (when built
+ * with BOGGLE_PROBES), so any number of threads may search at once.
+ */
+class BoardKernel {
+  public:
+    virtual ~BoardKernel() {}
+
+    /**
+     * Adds to words every word in lexicon that can be traced on the
+     * board and has at least minimum_word_length characters.
+     */
+    virtual void getAllValidWords(const FlatLexicon &lexicon, unsigned minimum_word_length,
+            std::set<std::string> *words, ProbeSnapshot *probes) const = 0;
+
+    /**
+     * Looks for a path spelling word (already lowercased). Returns true
+     * and fills path with board indices if there is one. Keeps no state
+     * in the kernel, so any number of threads may call it at once.
+     */
+    virtual bool findWord(const std::string &word, std::vector<int> *path) const = 0;
+
+    /**
+     * Feeds every word in lexicon that can be traced on the board to
+     * the scoring sink (see bogglescore.h), which dedupes and totals
+     * them without the words being collected in a set.
+     */
+    virtual void scoreWords(const FlatLexicon &lexicon, ScoreCounter *sink,
+            ProbeSnapshot *probes) const = 0;
+    virtual void scoreWords(const FlatLexicon &lexicon, TopScorer *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /* Scores the board as scoreWords does, handing the sink the dice
+     * of every path as well (see boggleheat.h) */
+    virtual void scoreWords(const FlatLexicon &lexicon, CellHeatSink *sink,
+            ProbeSnapshot *probes) const = 0;
+    virtual void scoreWords(const FlatLexicon &lexicon, CellHeatWordSink *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /* Appends every word in lexicon that can be traced on the board to
+     * the buffer sink */
+    virtual void collectWords(const FlatLexicon &lexicon, WordBufferSink *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /* Hands every word in lexicon that can be traced on the board to
+     * the callback sink as it is found */
+    virtual void collectWords(const FlatLexicon &lexicon, WordCallbackSink *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /* Sorts every word of a merged lexicon that can be traced on the
+     * board into its lexicons' sets (see lexiconset.h) */
+    virtual void collectWords(const FlatLexicon &lexicon, LexiconSetSink *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /* Collects every word in lexicon that can be traced on the board
+     * with the letters its blank dice stand for (see WildcardWordSink) */
+    virtual void collectWords(const FlatLexicon &lexicon, WildcardWordSink *sink,
+            ProbeSnapshot *probes) const = 0;
+
+    /**
+     * Feeds every path of every word in lexicon that can be traced on
+     * the board to the path counting sink (see bogglepaths.h).
+     */
+    virtual void countPaths(const FlatLexicon &lexicon, PathCountSink *sink,
+            ProbeSnapshot *probes) const = 0;
+};
+
+/**
+ * Returns a kernel for a rows x cols board with the given lowercased
+ * dice in row-major order, or NULL if that size is not specialized.
+ * The caller owns the kernel.
+ */
+BoardKernel *makeBoardKernel(unsigned rows, unsigned cols,
+        const std::vector<std::string> &dice);
+
+/* Search sink collecting words of at least a minimum length in a set */
+class WordSetSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    WordSetSink(unsigned minimum_word_length, std::set<std::string> *words)
+        : min_length(minimum_word_length), words(words) {}
+
+    bool enters(const FlatLexNode *) const { return true; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+    bool wants(const FlatLexNode *, size_t length) const { return length >= min_length; }
+    bool add(const FlatLexNode *, const std::string &word) { return words->insert(word).second; }
+
+  private:
+    unsigned min_length;
+    std::set<std::string> *words;
+};
+
+/* Search sink collecting words of at least a minimum length, each with
+ * the letters the blank dice stand for on the first path the search
+ * traced for it */
+class WildcardWordSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = true;
+
+    WildcardWordSink(unsigned minimum_word_length,
+            std::map<std::string, WildcardLetters> *words)
+        : min_length(minimum_word_length), words(words), letters(NULL) {}
+
+    bool enters(const FlatLexNode *) const { return true; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &traced) { letters = &traced; }
+    bool wants(const FlatLexNode *, size_t length) const { return length >= min_length; }
+
+    /* Returns false if the word was already added */
+    bool add(const FlatLexNode *, const std::string &word) {
+        std::map<std::string, WildcardLetters>::iterator at = words->lower_bound(word);
+        if(at != words->end() && at->first == word)
+            return false;
+        words->insert(at, std::make_pair(word, *letters));
+        return true;
+    }
+
+  private:
+    unsigned min_length;
+    std::map<std::string, WildcardLetters> *words;
+    const WildcardLetters *letters;
+};
+
+/**
+ * Words found by a search, packed into flat arrays rather than one
+ * string each: word i is the NUL-terminated string at text +
+ * offsets[i], and ids[i] is its word id. The arrays keep their capacity
+ * when cleared, so solving board after board into one buffer stops
+ * allocating once it is big enough.
+ */
+struct WordBuffer {
+    std::vector<char> text;
+    std::vector<uint32_t> offsets;
+    std::vector<int32_t> ids;
+
+    size_t size() const { return ids.size(); }
+    const char *word(size_t i) const { return &text[offsets[i]]; }
+
+    void clear() {
+        text.clear();
+        offsets.clear();
+        ids.clear();
+    }
+};
+
+/* Search sink appending each distinct word of at least a minimum
+ * length to a WordBuffer, in the order found */
+class WordBufferSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    WordBufferSink(unsigned minimum_word_length, WordStamps &seen, WordBuffer *words)
+        : min_length(minimum_word_length), seen(seen), words(words) {}
+
+    bool enters(const FlatLexNode *) const { return true; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+    bool wants(const FlatLexNode *, size_t length) const { return length >= min_length; }
+
+    /* Returns false if the word was already added */
+    bool add(const FlatLexNode *node, const std::string &word) {
+        if(!seen.mark(node->word_id))
+            return false;
+        words->offsets.push_back((uint32_t)words->text.size());
+        words->ids.push_back(node->word_id);
+        words->text.insert(words->text.end(), word.begin(), word.end());
+        words->text.push_back('\0');
+        return true;
+    }
+
+  private:
+    unsigned min_length;
+    WordStamps &seen;
+    WordBuffer *words;
+};
+
+/* Search sink handing each distinct word of at least a minimum length
+ * to a callback as it is found; once the callback returns false no
+ * further node is entered */
+class WordCallbackSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    WordCallbackSink(unsigned minimum_word_length, WordStamps &seen, const WordCallback &callback)
+        : min_length(minimum_word_length), seen(seen), callback(callback), stopped(false) {}
+
+    bool enters(const FlatLexNode *) const { return !stopped; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+    bool wants(const FlatLexNode *, size_t length) const { return length >= min_length; }
+
+    /* Returns false if the word was already handed over */
+    bool add(const FlatLexNode *node, const std::string &word) {
+        if(!seen.mark(node->word_id))
+            return false;
+        if(!stopped && !callback(word))
+            stopped = true;
+        return true;
+    }
+
+  private:
+    unsigned min_length;
+    WordStamps &seen;
+    const WordCallback &callback;
+    bool stopped;
+};
+
+/* Compile-time index lists, used to instantiate one search step per
+ * cell */
+template <unsigned... I> struct Indices {};
+template <unsigned N, unsigned... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <unsigned... I>
+struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+/**
+ * Neighbourhood of a fixed R x C grid, computed at compile time.
+ * at(i, d) is the d-th of the eight neighbours of cell i, or -1 if it
+ * falls off the board; mask(i) has a bit set for every neighbour.
+ */
+template <unsigned R, unsigned C>
+struct GridShape {
+    static const unsigned CELLS = R * C;
+
+    static constexpr int row(unsigned i, int d) {
+        return (int)(i / C) + (d < 3 ? -1 : d < 5 ? 0 : 1);
+    }
+    static constexpr int col(unsigned i, int d) {
+        return (int)(i % C) + (d == 0 || d == 3 || d == 5 ? -1 :
+                               d == 1 || d == 6 ? 0 : 1);
+    }
+    static constexpr int at(unsigned i, int d) {
+        return row(i, d) < 0 || row(i, d) >= (int)R || col(i, d) < 0 || col(i, d) >= (int)C
+            ? -1 : row(i, d) * (int)C + col(i, d);
+    }
+    static constexpr uint64_t bit(int j) {
+        return j < 0 ? 0 : (uint64_t)1 << j;
+    }
+    static constexpr uint64_t mask(unsigned i) {
+        return bit(at(i, 0)) | bit(at(i, 1)) | bit(at(i, 2)) | bit(at(i, 3))
+             | bit(at(i, 4)) | bit(at(i, 5)) | bit(at(i, 6)) | bit(at(i, 7));
+    }
+};
+
+/* Tag naming a cell at compile time; cell -1 is off the board */
+template <int J> struct CellTag {};
+
+/**
+ * Kernel for R x C boards. The visited set is a 64 bit mask passed by
+ * value, and every cell has its own instantiation of the search step,
+ * so the eight neighbours are compile-time constants and the neighbour
+ * loop is fully unrolled, with off-board directions compiled away.
+ */
+template <unsigned R, unsigned C>
+class FixedKernel : public BoardKernel {
+  public:
+    typedef GridShape<R, C> Shape;
+    static const unsigned CELLS = R * C;
+
+    explicit FixedKernel(const std::vector<std::string> &dice) : dice(dice), blanks(0) {
+        for(unsigned i = 0; i < CELLS; i++) {
+            if(isWildcardDie(dice[i]))
+                blanks |= Shape::bit(i);
+        }
+    }
+
+    void getAllValidWords(const FlatLexicon &lexicon, unsigned minimum_word_length,
+            std::set<std::string> *words, ProbeSnapshot *probes) const {
+        WordSetSink sink(minimum_word_length, words);
+        search(lexicon, sink, probes);
+    }
+
+    void scoreWords(const FlatLexicon &lexicon, ScoreCounter *sink, ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void scoreWords(const FlatLexicon &lexicon, TopScorer *sink, ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void scoreWords(const FlatLexicon &lexicon, CellHeatSink *sink, ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void scoreWords(const FlatLexicon &lexicon, CellHeatWordSink *sink,
+            ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void collectWords(const FlatLexicon &lexicon, WordBufferSink *sink,
+            ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void collectWords(const FlatLexicon &lexicon, WordCallbackSink *sink,
+            ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void collectWords(const FlatLexicon &lexicon, LexiconSetSink *sink,
+            ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void collectWords(const FlatLexicon &lexicon, WildcardWordSink *sink,
+            ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+    void countPaths(const FlatLexicon &lexicon, PathCountSink *sink, ProbeSnapshot *probes) const {
+        search(lexicon, *sink, probes);
+    }
+
+    bool findWord(const std::string &word, std::vector<int> *path) const {
+        path->clear();
+        if(word.empty())
+            return false;
+        Match m = { &word, path };
+        return startMatch(m, typename MakeIndices<CELLS>::type());
+    }
+
+  private:
+    /* State of one findWord call: the word and the path so far */
+    struct Match {
+        const std::string *target;
+        std::vector<int> *path;
+    };
+
+    /* State of one whole-board search: the lexicon, the word spelled
+     * so far, the blank dice on the path and where to count */
+    struct Walk {
+        const FlatLexicon *lexicon;
+        std::string word;
+        WildcardLetters letters;
+        ProbeSnapshot *probes;
+    };
+
+    template <class Sink>
+    void search(const FlatLexicon &lexicon, Sink &sink, ProbeSnapshot *probes) const {
+        Walk walk = { &lexicon, std::string(), WildcardLetters(), probes };
+        startCollect(walk, sink, typename MakeIndices<CELLS>::type());
+    }
+
+    /* Tries every cell as the first die of a word */
+    template <class Sink, unsigned... I>
+    void startCollect(Walk &walk, Sink &sink, Indices<I...>) const {
+        const FlatLexNode *root = walk.lexicon->getRoot();
+        int expand[] = { (collect<I>(walk, root, Shape::bit(I), sink), 0)... };
+        (void)expand;
+    }
+
+    template <unsigned... I>
+    bool startMatch(const Match &m, Indices<I...>) const {
+        bool found = false;
+        int expand[] = { (found = found || match<I>(m, 0, Shape::bit(I)), 0)... };
+        (void)expand;
+        return found;
+    }
+
+    /* Walks die I's text down the trie, hands the sink a word if one
+     * ends there, then continues into each unvisited neighbour. A
+     * blank die instead follows every child of node in turn. The word
+     * itself, and the letters blanks stand for, are only kept for
+     * sinks that want them. */
+    template <int I, class Sink>
+    void collect(Walk &walk, const FlatLexNode *node, uint64_t visited, Sink &sink) const {
+        const std::string &text = dice[I];
+        BOGGLE_COUNT(*walk.probes, PROBE_NODES_EXPANDED);
+        if(blanks & Shape::bit(I)) {
+            const FlatLexNode *child = walk.lexicon->firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0; options &= options - 1, child++) {
+                BOGGLE_COUNT(*walk.probes, PROBE_TRIE_STEPS);
+                char letter = (char)('a' + __builtin_ctz(options));
+                if(Sink::KEEPS_WORD)
+                    walk.word.push_back(letter);
+                if(Sink::KEEPS_BLANKS)
+                    walk.letters.push_back(std::make_pair(I, letter));
+                extend<I>(walk, child, visited, sink);
+                if(Sink::KEEPS_WORD)
+                    walk.word.pop_back();
+                if(Sink::KEEPS_BLANKS)
+                    walk.letters.pop_back();
+            }
+            return;
+        }
+        for(size_t k = 0; k < text.size(); k++) {
+            BOGGLE_COUNT(*walk.probes, PROBE_TRIE_STEPS);
+            node = walk.lexicon->getChild(node, text[k]);
+            if(node == NULL) {
+                BOGGLE_COUNT(*walk.probes, PROBE_DEAD_ENDS);
+                return;
+            }
+        }
+        size_t old = walk.word.size();
+        if(Sink::KEEPS_WORD)
+            walk.word.append(text);
+        extend<I>(walk, node, visited, sink);
+        if(Sink::KEEPS_WORD)
+            walk.word.resize(old);
+    }
+
+    /* Second half of collect, once die I has brought the search to node */
+    template <int I, class Sink>
+    void extend(Walk &walk, const FlatLexNode *node, uint64_t visited, Sink &sink) const {
+        if(!sink.enters(node)) {
+            BOGGLE_COUNT(*walk.probes, PROBE_DEAD_ENDS);
+            return;
+        }
+        if(node->word_id >= 0 && sink.wants(node, walk.word.size())) {
+            BOGGLE_COUNT(*walk.probes, PROBE_WORDS_EMITTED);
+            if(Sink::KEEPS_PATH)
+                sink.path(node, visited);
+            if(Sink::KEEPS_BLANKS)
+                sink.blanks(node, walk.letters);
+            if(!sink.add(node, walk.word))
+                BOGGLE_COUNT(*walk.probes, PROBE_DUPLICATE_HITS);
+        }
+
+        collectAt(CellTag<Shape::at(I, 0)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 1)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 2)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 3)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 4)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 5)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 6)>(), walk, node, visited, sink);
+        collectAt(CellTag<Shape::at(I, 7)>(), walk, node, visited, sink);
+    }
+
+    template <int J, class Sink>
+    void collectAt(CellTag<J>, Walk &walk, const FlatLexNode *node, uint64_t visited,
+            Sink &sink) const {
+        if(!(visited & Shape::bit(J)))
+            collect<J>(walk, node, visited | Shape::bit(J), sink);
+    }
+    template <class Sink>
+    void collectAt(CellTag<-1>, Walk &, const FlatLexNode *, uint64_t, Sink &) const {}
+
+    /* Matches die I against target at pos, then tries to finish the
+     * word from each unvisited neighbour */
+    template <int I>
+    bool match(const Match &m, size_t pos, uint64_t visited) const {
+        const std::string &text = dice[I];
+        const std::string &target = *m.target;
+        if(blanks & Shape::bit(I)) {
+            if(pos >= target.size() || (unsigned char)(target[pos] - 'a') >= 26)
+                return false;
+            pos++;
+        }
+        else {
+            if(target.compare(pos, text.size(), text) != 0)
+                return false;
+            pos += text.size();
+        }
+        m.path->push_back(I);
+        if(pos == target.size())
+            return true;
+        if(!(Shape::mask(I) & ~visited)) {
+            m.path->pop_back();     // boxed in by our own path
+            return false;
+        }
+
+        if(matchAt(CellTag<Shape::at(I, 0)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 1)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 2)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 3)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 4)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 5)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 6)>(), m, pos, visited) ||
+           matchAt(CellTag<Shape::at(I, 7)>(), m, pos, visited))
+            return true;
+        m.path->pop_back();
+        return false;
+    }
+
+    template <int J>
+    bool matchAt(CellTag<J>, const Match &m, size_t pos, uint64_t visited) const {
+        return !(visited & Shape::bit(J)) && match<J>(m, pos, visited | Shape::bit(J));
+    }
+    bool matchAt(CellTag<-1>, const Match &, size_t, uint64_t) const { return false; }
+
+    /* Lowercased dice in row-major order, and a bit per blank die */
+    std::vector<std::string> dice;
+    uint64_t blanks;
+};
+
+#endif // BOGGLEKERNEL_H
@@ -0,0 +1,248 @@
+/**
+ * boggleload: load generator for the boggled daemon.
+ *
+ * Opens several connections, each driven by its own thread, and keeps
+ * up to a given number of requests in flight on every connection.
+ * Latency is measured per request from the moment it is written until
+ * its reply has been read, so it includes queueing behind pipelined
+ * requests.
+ *
+ * usage: boggleload [-a address] [-c connections] [-n requests]
+ *                   [-d depth] [-r rows] [-k cols] [-m min_len]
+ *                   [-o solve|check|path] [-S]
+ */
+
+#include "boggleproto.h"
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+static const char *DEFAULTADDRESS = "unix:/tmp/boggled.sock";
+
+struct LoadOptions {
+    std::string address;
+    unsigned connections;
+    unsigned requests;      // per connection
+    unsigned depth;         // requests in flight per connection
+    unsigned rows;
+    unsigned cols;
+    unsigned min_len;
+    std::string op;
+};
+
+/* Results of one connection's run */
+struct LoadResult {
+    LatencyHistogram latency;
+    uint64_t words;
+    unsigned errors;
+    bool failed;
+
+    LoadResult() : words(0), errors(0), failed(false) {}
+};
+
+/* Random face, using "qu" for q the way the dice do */
+static std::string randomFace(std::mt19937 &rng) {
+    std::string face(1, (char)('a' + rng() % 26));
+    if(face == "q")
+        face = "qu";
+    return face;
+}
+
+static void putBoard(FrameWriter &req, const LoadOptions &opts, std::mt19937 &rng) {
+    req.putU16((uint16_t)opts.rows);
+    req.putU16((uint16_t)opts.cols);
+    for(unsigned i = 0; i < opts.rows * opts.cols; i++) {
+        req.putString(randomFace(rng));
+    }
+}
+
+static std::string randomWord(std::mt19937 &rng) {
+    std::string word;
+    unsigned len = 3 + rng() % 6;
+    for(unsigned i = 0; i < len; i++) {
+        word += (char)('a' + rng() % 26);
+    }
+    return word;
+}
+
+/* Builds the next request frame for the selected operation */
+static std::string nextRequest(const LoadOptions &opts, std::mt19937 &rng) {
+    FrameWriter req;
+    if(opts.op == "check") {
+        req.putU8(OP_IS_WORD);
+        req.putString(randomWord(rng));
+    }
+    else if(opts.op == "path") {
+        req.putU8(OP_PATH);
+        req.putString(randomWord(rng));
+    }
+    else {
+        req.putU8(OP_SET_BOARD_SOLVE);
+        req.putU16((uint16_t)opts.min_len);
+        putBoard(req, opts, rng);
+    }
+    return req.finish();
+}
+
+static void runConnection(const LoadOptions &opts, unsigned seed, LoadResult *result) {
+    int fd = connectTo(opts.address);
+    if(fd < 0) {
+        result->failed = true;
+        return;
+    }
+    std::mt19937 rng(seed);
+
+    if(opts.op == "path") {
+        // path lookups need a board to look on
+        FrameWriter req;
+        req.putU8(OP_SET_BOARD);
+        putBoard(req, opts, rng);
+        std::string frame = req.finish();
+        std::string reply;
+        if(!writeFull(fd, frame.data(), frame.size()) || !readFrame(fd, &reply)) {
+            result->failed = true;
+            close(fd);
+            return;
+        }
+    }
+
+    std::deque<uint64_t> sent_at;
+    unsigned sent = 0;
+    unsigned received = 0;
+    std::string batch;
+    std::string reply;
+
+    while(received < opts.requests) {
+        batch.clear();
+        while(sent < opts.requests && sent_at.size() < opts.depth) {
+            batch += nextRequest(opts, rng);
+            sent_at.push_back(nowMicros());
+            sent++;
+        }
+        if(!batch.empty() && !writeFull(fd, batch.data(), batch.size())) {
+            result->failed = true;
+            break;
+        }
+
+        if(!readFrame(fd, &reply)) {
+            result->failed = true;
+            break;
+        }
+        result->latency.record(nowMicros() - sent_at.front());
+        sent_at.pop_front();
+        received++;
+
+        FrameReader r(reply.data(), reply.size());
+        uint8_t status;
+        if(!r.getU8(&status) || status != STATUS_OK) {
+            result->errors++;
+        }
+        else if(opts.op == "solve") {
+            uint32_t n;
+            if(r.getU32(&n))
+                result->words += n;
+        }
+    }
+    close(fd);
+}
+
+static bool printServerStats(const std::string &address) {
+    int fd = connectTo(address);
+    if(fd < 0)
+        return false;
+    FrameWriter req;
+    req.putU8(OP_STATS);
+    std::string frame = req.finish();
+    std::string reply, text;
+    uint8_t status;
+    bool ok = writeFull(fd, frame.data(), frame.size()) && readFrame(fd, &reply);
+    close(fd);
+    FrameReader r(reply.data(), reply.size());
+    if(!ok || !r.getU8(&status) || !r.getText(&text))
+        return false;
+    std::cout << "server service times:\n" << text;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    LoadOptions opts;
+    opts.address = DEFAULTADDRESS;
+    opts.connections = 4;
+    opts.requests = 1000;
+    opts.depth = 8;
+    opts.rows = 4;
+    opts.cols = 4;
+    opts.min_len = 3;
+    opts.op = "solve";
+    bool server_stats = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "a:c:n:d:r:k:m:o:S")) != -1) {
+        switch(opt) {
+            case 'a': opts.address = optarg; break;
+            case 'c': opts.connections = atoi(optarg); break;
+            case 'n': opts.requests = atoi(optarg); break;
+            case 'd': opts.depth = atoi(optarg); break;
+            case 'r': opts.rows = atoi(optarg); break;
+            case 'k': opts.cols = atoi(optarg); break;
+            case 'm': opts.min_len = atoi(optarg); break;
+            case 'o': opts.op = optarg; break;
+            case 'S': server_stats = true; break;
+            default:
+                std::cerr << "usage: " << argv[0] << " [-a address] [-c connections]"
+                    " [-n requests] [-d depth] [-r rows] [-k cols] [-m min_len]"
+                    " [-o solve|check|path] [-S]" << std::endl;
+                return 1;
+        }
+    }
+    if(opts.op != "solve" && opts.op != "check" && opts.op != "path") {
+        std::cerr << "Unknown operation " << opts.op << std::endl;
+        return 1;
+    }
+    if(opts.depth == 0)
+        opts.depth = 1;
+
+    std::vector<LoadResult> results(opts.connections);
+    std::vector<std::thread> threads;
+    uint64_t start = nowMicros();
+    for(unsigned i = 0; i < opts.connections; i++) {
+        threads.push_back(std::thread(runConnection, std::cref(opts), i + 1, &results[i]));
+    }
+    for(size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    uint64_t elapsed = nowMicros() - start;
+
+    LatencyHistogram total;
+    uint64_t words = 0;
+    unsigned errors = 0, failed = 0;
+    for(size_t i = 0; i < results.size(); i++) {
+        total.merge(results[i].latency);
+        words += results[i].words;
+        errors += results[i].errors;
+        failed += results[i].failed;
+    }
+
+    double secs = elapsed / 1e6;
+    std::cout << opts.op << ": " << opts.connections << " connections x "
+        << opts.requests << " requests, depth " << opts.depth << "\n"
+        << "elapsed " << secs << "s, " << (secs > 0 ? total.count() / secs : 0)
+        << " req/s\n"
+        << "latency " << total.summary() << "\n";
+    if(opts.op == "solve")
+        std::cout << "words returned " << words << "\n";
+    if(errors || failed)
+        std::cout << errors << " error replies, " << failed << " failed connections\n";
+    if(server_stats && !printServerStats(opts.address))
+        std::cerr << "Could not fetch server stats" << std::endl;
+
+    return failed ? 1 : 0;
+}
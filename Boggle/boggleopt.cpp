@@ -0,0 +1,146 @@
+/**
+ * boggleopt: proves which board of a class scores the most.
+ *
+ * Runs ClassSearch over rows x cols boards whose cells may each hold
+ * any of the given letters (q standing for Qu), on all cores. Boards
+ * only count if they beat the incumbent given with -i, so seeding it
+ * with the best score an annealing run found prunes far more. With -k
+ * the open classes are saved to a checkpoint file every -s seconds and
+ * on SIGINT/SIGTERM; -R resumes from that file instead of starting
+ * over.
+ *
+ * usage: boggleopt [-l lexicon] [-r rows] [-c cols] [-L letters]
+ *                  [-i incumbent] [-t threads] [-k checkpoint [-s secs] [-R]]
+ */
+
+#include "boggleclass.h"
+#include "boggleplayer.h"
+#include "lexiconloader.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+static const char *DEFAULTLEXFILENAME = "boglex.txt";
+
+static std::atomic<bool> stopping(false);
+
+static void onSignal(int) {
+    stopping = true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *lexfilename = DEFAULTLEXFILENAME;
+    unsigned rows = 3, cols = 3;
+    std::string letters = "abcdefghijklmnopqrstuvwxyz";
+    uint64_t incumbent = 0;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string checkpoint;
+    unsigned interval = 60;
+    bool resume = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "l:r:c:L:i:t:k:s:R")) != -1) {
+        switch(opt) {
+            case 'l': lexfilename = optarg; break;
+            case 'r': rows = atoi(optarg); break;
+            case 'c': cols = atoi(optarg); break;
+            case 'L': letters = optarg; break;
+            case 'i': incumbent = strtoull(optarg, NULL, 10); break;
+            case 't': threads = atoi(optarg); break;
+            case 'k': checkpoint = optarg; break;
+            case 's': interval = atoi(optarg); break;
+            case 'R': resume = true; break;
+            default:
+                std::cerr << "usage: " << argv[0] << " [-l lexicon] [-r rows] [-c cols]"
+                    " [-L letters] [-i incumbent] [-t threads] [-k checkpoint [-s secs] [-R]]"
+                    << std::endl;
+                return 1;
+        }
+    }
+    if(threads == 0)
+        threads = 1;
+    if(interval == 0) {
+        std::cerr << "Checkpoints must be at least 1 second apart (-s)" << std::endl;
+        return 1;
+    }
+    if(rows * cols == 0 || rows * cols > 64) {
+        std::cerr << "Boards must have 1 to 64 cells" << std::endl;
+        return 1;
+    }
+    if(resume && checkpoint.empty()) {
+        std::cerr << "-R needs a checkpoint file (-k)" << std::endl;
+        return 1;
+    }
+
+    uint32_t mask = 0;
+    for(size_t i = 0; i < letters.size(); i++) {
+        unsigned k = (unsigned char)(tolower((unsigned char)letters[i]) - 'a');
+        if(k < 26)
+            mask |= 1u << k;
+    }
+    if(mask == 0) {
+        std::cerr << "No letters to place" << std::endl;
+        return 1;
+    }
+
+    WordList words;
+    if(!loadWordList(lexfilename, &words)) {
+        std::cerr << "Could not read lexicon file " << lexfilename << std::endl;
+        return 1;
+    }
+    BogglePlayer player;
+    player.buildLexicon(words);
+
+    ClassSearch search(player, rows, cols);
+    if(resume) {
+        if(!search.resume(checkpoint)) {
+            std::cerr << "Could not resume from " << checkpoint
+                << " (missing, or written for another board size or lexicon)" << std::endl;
+            return 1;
+        }
+        std::cout << "Resuming with " << search.openClasses() << " open classes, incumbent "
+            << search.bestScore() << std::endl;
+    }
+    else {
+        search.start(BoardClass(rows * cols, mask), incumbent);
+    }
+
+    struct sigaction sa;
+    sa.sa_handler = onSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread runner(&ClassSearch::run, &search, threads, checkpoint, interval);
+    while(!search.finished() && !stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if(stopping)
+        search.stop();
+    runner.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string best = search.bestBoard();
+    std::cout << (best.empty() ? "(no board beat the incumbent)" : best) << " "
+        << search.bestScore() << "\n"
+        << search.classesExamined() << " classes examined in " << secs << " s\n";
+    if(search.finished()) {
+        std::cout << "Search complete: no " << rows << "x" << cols
+            << " board of the class scores more than " << search.bestScore() << std::endl;
+        return 0;
+    }
+    std::cout << "Stopped with " << search.openClasses() << " open classes";
+    if(!checkpoint.empty())
+        std::cout << "; resume with -k " << checkpoint << " -R";
+    std::cout << std::endl;
+    return 2;
+}
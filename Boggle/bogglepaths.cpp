@@ -0,0 +1,184 @@
+#include "bogglepaths.h"
+#include "boggleutil.h"
+
+    WordPaths::WordPaths(const BoardTopology &topology, const std::vector<std::string> &dice,
+            const std::string &word)
+        : topology(topology), cells(topology.size()), word(word), mask_words(0), next_start(0) {
+        match.assign(word.size() * cells, 0);
+        bit_of.assign(cells, -1);
+        int bits = 0;
+        for(size_t cell = 0; cell < cells; cell++) {
+            const std::string &text = dice[cell];
+            for(size_t pos = 0; pos < word.size(); pos++) {
+                size_t length = 0;
+                if(isWildcardDie(text))
+                    length = (unsigned char)(word[pos] - 'a') < 26 ? 1 : 0;
+                else if(!text.empty() && word.compare(pos, text.size(), text) == 0)
+                    length = text.size();
+                match[pos * cells + cell] = (uint8_t)length;
+                if(length > 0 && bit_of[cell] < 0)
+                    bit_of[cell] = bits++;
+            }
+        }
+
+        mask_words = (bits + 63) / 64;
+        visited.assign(mask_words, 0);
+        later.assign(word.size() + 1, std::vector<uint64_t>(mask_words, 0));
+        for(size_t pos = word.size(); pos-- > 0; ) {
+            later[pos] = later[pos + 1];
+            for(size_t cell = 0; cell < cells; cell++) {
+                if(match[pos * cells + cell])
+                    later[pos][bit_of[cell] / 64] |= (uint64_t)1 << (bit_of[cell] % 64);
+            }
+        }
+
+        if(mask_words == 1) {
+            size_t width = word.size() + 1;
+            near.assign(cells * width, 0);
+            for(size_t cell = 0; cell < cells; cell++) {
+                if(bit_of[cell] >= 0)
+                    near[cell * width] = (uint64_t)1 << bit_of[cell];
+            }
+            for(size_t steps = 1; steps < width; steps++) {
+                for(size_t cell = 0; cell < cells; cell++) {
+                    uint64_t reach = near[cell * width + steps - 1];
+                    const int *next = topology.neighbours(cell);
+                    for(unsigned n = 0; n < topology.degree(cell); n++)
+                        reach |= near[next[n] * width + steps - 1];
+                    near[cell * width + steps] = reach;
+                }
+            }
+        }
+    }
+
+    WordPaths::WordPaths(unsigned rows, unsigned cols, const std::vector<std::string> &dice,
+            const std::string &word)
+        : WordPaths(BoardTopology::grid(rows, cols), dice, word) {}
+
+    /* Characters of the word die cell matches at pos, or 0 */
+    size_t WordPaths::matchLength(int cell, size_t pos) const {
+        return match[pos * cells + cell];
+    }
+
+    /**
+     * Number of ways to finish the word after die cell (already marked
+     * visited) has matched it up to end.
+     */
+    uint64_t WordPaths::ways(int cell, size_t end) {
+        if(end == word.size())
+            return 1;
+
+        // every die left takes at least one character, so none further
+        // away than the characters left can be stepped on
+        size_t width = word.size() + 1;
+        bool memoized = mask_words == 1;
+        std::pair<uint64_t, uint64_t> here((uint64_t)cell * width + end, memoized ?
+                visited[0] & later[end][0] & near[cell * width + word.size() - end] : 0);
+        if(memoized) {
+            std::unordered_map<std::pair<uint64_t, uint64_t>, uint64_t, KeyHash>::const_iterator
+                known = memo.find(here);
+            if(known != memo.end())
+                return known->second;
+        }
+
+        uint64_t total = 0;
+        const int *neighbours = topology.neighbours(cell);
+        for(unsigned n = 0; n < topology.degree(cell); n++) {
+            int next = neighbours[n];
+            if(bit_of[next] < 0)
+                continue;
+            uint64_t bit = (uint64_t)1 << (bit_of[next] % 64);
+            uint64_t &used = visited[bit_of[next] / 64];
+            size_t length = matchLength(next, end);
+            if((used & bit) || length == 0)
+                continue;
+            used |= bit;
+            uint64_t more = ways(next, end + length);
+            used &= ~bit;
+            total = total + more < total ? UINT64_MAX : total + more;
+        }
+        if(memoized)
+            memo[here] = total;
+        return total;
+    }
+
+    uint64_t WordPaths::count() {
+        uint64_t total = 0;
+        if(word.empty())
+            return 0;
+
+        // count from scratch, even partway through an enumeration
+        std::vector<uint64_t> enumerating(mask_words, 0);
+        visited.swap(enumerating);
+        for(int cell = 0; cell < (int)cells; cell++) {
+            size_t length = matchLength(cell, 0);
+            if(length == 0)
+                continue;
+            uint64_t bit = (uint64_t)1 << (bit_of[cell] % 64);
+            visited[bit_of[cell] / 64] |= bit;
+            uint64_t more = ways(cell, length);
+            visited[bit_of[cell] / 64] &= ~bit;
+            total = total + more < total ? UINT64_MAX : total + more;
+        }
+        visited.swap(enumerating);
+        return total;
+    }
+
+    /**
+     * Pushes die cell as the next step of the path if it is free,
+     * matches the word at pos and leads to at least one path.
+     */
+    bool WordPaths::enter(int cell, size_t pos) {
+        if(bit_of[cell] < 0)
+            return false;
+        uint64_t bit = (uint64_t)1 << (bit_of[cell] % 64);
+        uint64_t &used = visited[bit_of[cell] / 64];
+        size_t length = matchLength(cell, pos);
+        if((used & bit) || length == 0)
+            return false;
+        used |= bit;
+        if(ways(cell, pos + length) == 0) {
+            used &= ~bit;
+            return false;
+        }
+        Frame frame = { cell, pos + length, 0 };
+        stack.push_back(frame);
+        return true;
+    }
+
+    void WordPaths::leave() {
+        int cell = stack.back().cell;
+        visited[bit_of[cell] / 64] &= ~((uint64_t)1 << (bit_of[cell] % 64));
+        stack.pop_back();
+    }
+
+    bool WordPaths::next(std::vector<int> *path) {
+        if(word.empty())
+            return false;
+
+        // the path given last time is finished with
+        if(!stack.empty() && stack.back().end == word.size())
+            leave();
+
+        for(;;) {
+            if(stack.empty()) {
+                if(next_start == (int)cells)
+                    return false;
+                enter(next_start++, 0);
+                continue;
+            }
+            Frame &top = stack.back();
+            if(top.end == word.size())
+                break;
+            if(top.direction == (int)topology.degree(top.cell)) {
+                leave();
+                continue;
+            }
+            enter(topology.neighbours(top.cell)[top.direction++], top.end);
+        }
+
+        path->clear();
+        for(size_t i = 0; i < stack.size(); i++)
+            path->push_back(stack[i].cell);
+        return true;
+    }
@@ -0,0 +1,126 @@
+#ifndef BOGGLEPATHS_H
+#define BOGGLEPATHS_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bogglescore.h"
+#include "boggletopology.h"
+#include "flatlexicon.h"
+
+/**
+ * The distinct paths spelling one word on a board: sequences of
+ * adjacent dice, none used twice, whose texts (a blank die standing for
+ * any one letter) spell the word.
+ *
+ * Paths are counted by a search memoized on (die, position in the
+ * word, dice used so far). Only the used dice that could still be
+ * stepped on, matching some later part of the word within reach of the
+ * letters left, are part of the key, so searches that reach the same
+ * die at the same position having used different dice for the early
+ * letters are counted once. This keeps boards with many repeated
+ * letters cheap where trying every path is not.
+ */
+class WordPaths {
+  public:
+    /* The paths of word (lowercased) on a board of the given topology
+     * with the given lowercased dice, one per cell */
+    WordPaths(const BoardTopology &topology, const std::vector<std::string> &dice,
+            const std::string &word);
+
+    /* The paths of word on a rows x cols grid, dice in row-major order */
+    WordPaths(unsigned rows, unsigned cols, const std::vector<std::string> &dice,
+            const std::string &word);
+
+    /* Number of distinct paths, saturating at UINT64_MAX */
+    uint64_t count();
+
+    /**
+     * Fills path with the board indices of the next path and returns
+     * true, or returns false once every path has been given. Paths are
+     * found one at a time as they are asked for, and the counts prune
+     * every branch that leads to none, so each costs at most the
+     * length of the word in steps.
+     */
+    bool next(std::vector<int> *path);
+
+  private:
+    struct Frame {
+        int cell;
+        size_t end;     // characters of the word matched up to and including cell
+        int direction;  // next neighbour to try
+    };
+
+    size_t matchLength(int cell, size_t pos) const;
+    uint64_t ways(int cell, size_t end);
+    bool enter(int cell, size_t pos);
+    void leave();
+
+    BoardTopology topology;
+    size_t cells;
+    std::string word;
+
+    /* match[pos * cells + cell]: characters die cell matches at pos,
+     * or 0 */
+    std::vector<uint8_t> match;
+
+    /* Dice matching somewhere in the word get a bit in the visited
+     * set; no other die is ever visited. later[pos] has the bits of the
+     * dice matching at pos or beyond. */
+    std::vector<int> bit_of;
+    size_t mask_words;
+    std::vector<std::vector<uint64_t> > later;
+    std::vector<uint64_t> visited;
+
+    /* near[cell * (word size + 1) + steps]: bits of the dice at most
+     * steps moves from cell; only kept along with the memo */
+    std::vector<uint64_t> near;
+
+    /* Completions of the word keyed by cell and end, then by the
+     * relevant part of the visited set; only kept when at most 64 dice
+     * match, which covers every board up to 8x8 */
+    struct KeyHash {
+        size_t operator()(const std::pair<uint64_t, uint64_t> &key) const {
+            return (size_t)((key.first * 0x9e3779b97f4a7c15ULL) ^ key.second);
+        }
+    };
+    std::unordered_map<std::pair<uint64_t, uint64_t>, uint64_t, KeyHash> memo;
+
+    /* State of the enumeration */
+    std::vector<Frame> stack;
+    int next_start;
+};
+
+/**
+ * Search sink counting every path of every word of at least a minimum
+ * length (see bogglescore.h for the sink interface). The board
+ * searches already walk each path once, so this costs the same as
+ * collecting the words.
+ */
+class PathCountSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    PathCountSink(unsigned minimum_word_length, std::map<std::string, uint64_t> *counts)
+        : min_length(minimum_word_length), counts(counts) {}
+
+    bool enters(const FlatLexNode *) const { return true; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+    bool wants(const FlatLexNode *, size_t length) const { return length >= min_length; }
+
+    /* Returns false if the word had been counted before */
+    bool add(const FlatLexNode *, const std::string &word) { return ++(*counts)[word] == 1; }
+
+  private:
+    unsigned min_length;
+    std::map<std::string, uint64_t> *counts;
+};
+
+#endif // BOGGLEPATHS_H
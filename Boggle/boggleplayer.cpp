@@ -1,20 +1,109 @@
 #include "boggleplayer.h"
 #include "boggleboard.h"
+#include "lexiconquery.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
 
+namespace {
+
+    /* Scratch of the whole-board solves: the words the solve has seen,
+     * and for getCellHeat the dice of every path of each word, zero
+     * between solves. Each thread reuses its own from solve to solve;
+     * a solve begun while the thread's is in use, from a callback of
+     * another solve, gets a fresh one. */
+    struct SolveScratch {
+        WordStamps seen;
+        std::vector<uint64_t> heat_cells;
+        bool busy;
+
+        SolveScratch() : busy(false) {}
+    };
+
+    class ScratchLease {
+      public:
+        explicit ScratchLease(uint32_t word_count) : heat_dirty(false) {
+            static thread_local SolveScratch mine;
+            scratch = mine.busy ? &own : &mine;
+            scratch->busy = true;
+            scratch->seen.reset(word_count);
+        }
+
+        /* Forgets the heat cells of a solve that did not get to clear
+         * them, such as one whose callback threw */
+        ~ScratchLease() {
+            if(heat_dirty)
+                scratch->heat_cells.clear();
+            scratch->busy = false;
+        }
+
+        WordStamps &seen() { return scratch->seen; }
+
+        /* The heat cells, all zero; heatCleared() must follow once the
+         * solve has zeroed them again */
+        std::vector<uint64_t> &heatCells(uint32_t word_count) {
+            if(scratch->heat_cells.size() != word_count)
+                scratch->heat_cells.assign(word_count, 0);
+            heat_dirty = true;
+            return scratch->heat_cells;
+        }
+        void heatCleared() { heat_dirty = false; }
+
+      private:
+        SolveScratch own;
+        SolveScratch *scratch;
+        bool heat_dirty;
+    };
+
+    /* Counters of the calling thread's last whole-board solve */
+    ProbeSnapshot &lastProbes() {
+        static thread_local ProbeSnapshot last;
+        return last;
+    }
+
+    /* Adds a finished solve's counters to the totals and keeps them as
+     * the calling thread's last */
+    void recordSolve(const ProbeSnapshot &probes) {
+        BOGGLE_RECORD(probes);
+        lastProbes() = probes;
+    }
+
+}
+
 /**
      * Constructs a BogglePlayer with an uninitialized board and lexicon.
      * Both must be initialized with data before use.
      */
     BogglePlayer::BogglePlayer() {
-        this->lexicon = new Lexicon();
+        this->lexicon = std::make_shared<FlatLexicon>();
         lexicon_built = false;
         board_built = false;
+        kernels_enabled = true;
+        interleave_cursors = 0;
+        scoring_rules = ScoringRules::official();
+        score_tables = std::make_shared<ScoreTables>();
+        rows = 0;
+        cols = 0;
+    }
+
+    /**
+     * Constructs a BogglePlayer that searches the image's node arrays
+     * in place.
+     */
+    BogglePlayer::BogglePlayer(const FlatLexiconImage &image) {
+        this->lexicon = std::make_shared<FlatLexicon>(image);
+        lexicon_built = true;
+        board_built = false;
+        kernels_enabled = true;
+        interleave_cursors = 0;
+        scoring_rules = ScoringRules::official();
+        score_tables = std::make_shared<ScoreTables>();
         rows = 0;
         cols = 0;
     }
@@ -23,23 +112,115 @@ using namespace std;
         return lexicon_built;
     }
 
+    /**
+     * Enables or disables the board-size specialized search kernels.
+     */
+    void BogglePlayer::setKernelsEnabled(bool enabled) {
+        kernels_enabled = enabled;
+    }
+
+    /**
+     * Sets the number of interleaved walks whole-board searches run.
+     */
+    void BogglePlayer::setInterleavedCursors(unsigned int cursors) {
+        interleave_cursors = cursors;
+    }
+
     /**
      * Initializes the BogglePlayer's Lexicon using the supplied word
      * list. Words are inserted in a case-insensitive manner.
      */
     void BogglePlayer::buildLexicon(const std::set<std::string> &word_list) {
-        
-        this->word_list = word_list;
-        // Initialize lexicon
-        if(lexicon_built) 
-            delete lexicon;
 
-        for(std::set<std::string>::const_iterator it = word_list.begin(); it != word_list.end(); ++it) {
-            lexicon->insert(*it);
-        }
+        BOGGLE_TIMED(PHASE_BUILD_LEXICON);
+
+        // Initialize lexicon; a previous (possibly shared) trie is
+        // released once its last user lets go of it
+        rejected_words.clear();
+        lexicon = std::make_shared<FlatLexicon>(word_list, &rejected_words);
         lexicon_built = true;
+        score_tables = std::make_shared<ScoreTables>();
     }
 
+    /**
+     * Initializes the BogglePlayer's Lexicon from a sorted word list
+     * produced by loadWordList, building the trie in bulk.
+     */
+    void BogglePlayer::buildLexicon(const WordList &words, unsigned threads) {
+        BOGGLE_TIMED(PHASE_BUILD_LEXICON);
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if(threads == 0)
+            threads = 1;
+
+        rejected_words.clear();
+        lexicon = std::make_shared<FlatLexicon>(words, threads);
+        lexicon_built = true;
+        score_tables = std::make_shared<ScoreTables>();
+    }
+
+    /**
+     * Makes this BogglePlayer search the lexicon already built by other
+     * instead of building its own copy.
+     */
+    void BogglePlayer::shareLexicon(const BogglePlayer &other) {
+        lexicon = other.lexicon;
+        lexicon_built = other.lexicon_built;
+        if(other.scoring_rules == scoring_rules)
+            score_tables = other.score_tables;
+        else
+            score_tables = std::make_shared<ScoreTables>();
+    }
+
+    /**
+     * Makes this BogglePlayer search snapshot.
+     */
+    void BogglePlayer::useLexicon(const std::shared_ptr<const FlatLexicon> &snapshot) {
+        if(snapshot == lexicon)
+            return;
+        lexicon = snapshot;
+        lexicon_built = true;
+        score_tables = std::make_shared<ScoreTables>();
+    }
+
+    /**
+     * Sets the rules scoreBoard scores by.
+     */
+    void BogglePlayer::setScoringRules(const ScoringRules &rules) {
+        if(rules == scoring_rules)
+            return;
+        scoring_rules = rules;
+        score_tables = std::make_shared<ScoreTables>();
+    }
+
+
+    /* The score table for the lexicon and rules, built by the first
+     * solve to need it */
+    const ScoreTable &BogglePlayer::scoreTable() const {
+        ScoreTables &tables = *score_tables;
+        std::call_once(tables.table_once, [this, &tables]() {
+            tables.table = std::make_shared<ScoreTable>(*lexicon, scoring_rules);
+        });
+        return *tables.table;
+    }
+
+    /* The node values under the score table, built by the first
+     * solveAnytime */
+    const SubtrieValues &BogglePlayer::subtrieValues() const {
+        scoreTable();
+        ScoreTables &tables = *score_tables;
+        std::call_once(tables.values_once, [this, &tables]() {
+            tables.values = std::make_shared<SubtrieValues>(*lexicon, tables.table);
+        });
+        return *tables.values;
+    }
+
+    /**
+     * Returns the counters of the calling thread's last solve.
+     */
+    const ProbeSnapshot &BogglePlayer::lastSolveProbes() {
+        return lastProbes();
+    }
 
     /**
      * Initializes the BogglePlayer's internal board representation
@@ -48,6 +229,7 @@ using namespace std;
     void BogglePlayer::setBoard(unsigned int rows, unsigned int cols,
             std::string **diceArray) {
 
+        BOGGLE_TIMED(PHASE_SET_BOARD);
         if(board_built) {
             board.clear();
         }
@@ -56,6 +238,7 @@ using namespace std;
 
         this->rows = rows;
         this->cols = cols;
+        useGrid();
 
         // convert all to lowercase and add to board vector
         for( int i = 0; i<this->rows; i++ ) {
@@ -64,6 +247,73 @@ using namespace std;
                 board.push_back(BoardPos(toAdd));
             }
         }
+        finishBoard();
+    }
+
+    /**
+     * Initializes the board from dice in row-major order.
+     */
+    void BogglePlayer::setBoard(unsigned int rows, unsigned int cols,
+            const std::vector<std::string> &dice) {
+
+        BOGGLE_TIMED(PHASE_SET_BOARD);
+        board.clear();
+        this->rows = rows;
+        this->cols = cols;
+        useGrid();
+        for(unsigned int i = 0; i < rows * cols; i++) {
+            board.push_back(BoardPos(setLowerCase(dice[i])));
+        }
+        finishBoard();
+    }
+
+    /**
+     * Initializes a board of any shape from its topology and one die
+     * per cell.
+     */
+    void BogglePlayer::setBoard(const BoardTopology &topology,
+            const std::vector<std::string> &dice) {
+
+        BOGGLE_TIMED(PHASE_SET_BOARD);
+        board.clear();
+        this->topology = topology;
+        this->rows = topology.rows();
+        this->cols = topology.cols();
+        for(unsigned int i = 0; i < topology.size(); i++) {
+            board.push_back(BoardPos(setLowerCase(dice[i])));
+        }
+        finishBoard();
+    }
+
+    /* Helper method for setBoard
+     * makes the topology the plain grid of the board's size, keeping
+     * the one there if it already is */
+    void BogglePlayer::useGrid() {
+        if(!topology.isGrid() || topology.rows() != rows || topology.cols() != cols)
+            topology = BoardTopology::grid(rows, cols);
+    }
+
+    /* Helper method for setBoard
+     * picks a specialized kernel if there is one for the board's size
+     * and marks the board built */
+    void BogglePlayer::finishBoard() {
+        kernel.reset();
+        if(kernels_enabled && topology.isGrid()) {
+            std::vector<std::string> dice;
+            for(unsigned int i = 0; i < board.size(); i++) {
+                dice.push_back(board[i].getText());
+            }
+            kernel.reset(makeBoardKernel(rows, cols, dice));
+        }
+
+        interleaved.reset();
+        if(interleave_cursors > 1 && board.size() <= InterleavedSearch::MAX_CELLS) {
+            std::vector<std::string> dice;
+            for(unsigned int i = 0; i < board.size(); i++) {
+                dice.push_back(board[i].getText());
+            }
+            interleaved.reset(new InterleavedSearch(topology, dice));
+        }
 
         board_built = true;
     }
@@ -77,79 +327,258 @@ using namespace std;
      * initialized. Returns true otherwise.
      */
     bool BogglePlayer::getAllValidWords(unsigned int minimum_word_length,
-            std::set<std::string> *words) {
+            std::set<std::string> *words) const {
 
         if(!board_built)
             return false;
         if(!lexicon_built)
             return false;
 
-        LexNode *curr = lexicon->getRoot();
-
-        for (unsigned int r = 0; r < rows; r++) {
-            for (unsigned int c = 0; c < cols; c++) {
-                
-                int i = mapIndex(r,c);
-                
-                board[i].setVisited(true);
-                //call helper function
-                getWords(r, c, curr, "", words, minimum_word_length);
-                
-                for (unsigned int i = 0; i < board.size(); i++) {
-                    board[i].setVisited(false);
-                }
-            }
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        WordSetSink sink(minimum_word_length, words);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->getAllValidWords(*lexicon, minimum_word_length, words, &probes);
+        else
+            searchBoard(sink, &probes);
+        }
+        recordSolve(probes);
 
+        return true;
+    }
+
+    /**
+     * Populates words with the same words as getAllValidWords, each
+     * with the letters the board's blank dice stand for on one path
+     * spelling it.
+     */
+    bool BogglePlayer::getAllValidWords(unsigned int minimum_word_length,
+            std::map<std::string, WildcardLetters> *words) const {
+
+        if(!board_built || !lexicon_built)
+            return false;
+
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        WildcardWordSink sink(minimum_word_length, words);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->collectWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
         }
-        
+        recordSolve(probes);
+
         return true;
     }
 
-    /* Helper function for getAllValidWords */
-    void BogglePlayer::getWords(int row, int col, LexNode *curr, std::string 
-        word_matched, std::set<std::string> *words, unsigned int minimum_word_length)
-    {
-      
-        int index = mapIndex(row, col);
-        string text = board[index].getText();
-  
-        // checks if text is in lexicon
-        for (unsigned int i = 0; i < text.size(); i++) {
-            curr = curr->getChildren(text[i]);
-            if (curr == NULL) {
-                board[index].setVisited(false);
-                return;
-            }
+    /**
+     * Scores the words on the board without collecting them; keeps the
+     * best top_k of them in the given order as well if top_k > 0.
+     */
+    bool BogglePlayer::scoreBoard(unsigned int top_k, ScoreOrder order,
+            ScoreResult *result) const {
+
+        if(!board_built || !lexicon_built)
+            return false;
+
+        const ScoreTable &table = scoreTable();
+        ScratchLease scratch(lexicon->wordCount());
+
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_SCORE_BOARD);
+        if(top_k == 0) {
+            ScoreCounter sink(table, scratch.seen(), result);
+            if(interleaved)
+                interleaved->search(*lexicon, interleave_cursors, sink);
+            else if(kernel)
+                kernel->scoreWords(*lexicon, &sink, &probes);
+            else
+                searchBoard(sink, &probes);
         }
- 
-        word_matched.append(text);
+        else {
+            TopScorer sink(table, scratch.seen(), result, top_k, order);
+            if(interleaved)
+                interleaved->search(*lexicon, interleave_cursors, sink);
+            else if(kernel)
+                kernel->scoreWords(*lexicon, &sink, &probes);
+            else
+                searchBoard(sink, &probes);
+            sink.finish();
+        }
+        }
+        recordSolve(probes);
+
+        return true;
+    }
 
-        // check if word found
-        if (curr->isEndOfWord() == true && word_matched.size() >= minimum_word_length) 
+    /**
+     * Scores the board and spreads its words over the dice they use.
+     */
+    bool BogglePlayer::getCellHeat(ScoreResult *result, CellHeat *heat) const {
+        if(!board_built || !lexicon_built || board.size() > 64)
+            return false;
+
+        const ScoreTable &table = scoreTable();
+        ScratchLease scratch(lexicon->wordCount());
+        std::vector<uint64_t> &heat_cells = scratch.heatCells(lexicon->wordCount());
+
+        ProbeSnapshot probes;
         {
-            words->insert(word_matched);
+        BOGGLE_PHASE(probes, PHASE_SCORE_BOARD);
+        CellHeatSink sink(table, scratch.seen(), result, heat_cells, board.size(), heat);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->scoreWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        sink.finish();
+        scratch.heatCleared();
         }
+        recordSolve(probes);
+
+        return true;
+    }
 
-        //loop through neighbors
-        for (int r = -1; r <= 1; r++) {
-            for (int c = -1; c <= 1; c++) {
+    /**
+     * Scores the board and spreads its words over the dice they use,
+     * handing each word to found as it turns up.
+     */
+    bool BogglePlayer::getCellHeat(ScoreResult *result, CellHeat *heat,
+            const WordCallback &found) const {
+        if(!board_built || !lexicon_built || board.size() > 64)
+            return false;
+
+        const ScoreTable &table = scoreTable();
+        ScratchLease scratch(lexicon->wordCount());
+        std::vector<uint64_t> &heat_cells = scratch.heatCells(lexicon->wordCount());
+
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_SCORE_BOARD);
+        CellHeatWordSink sink(table, scratch.seen(), result, heat_cells, board.size(), heat,
+                found);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->scoreWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        sink.finish();
+        scratch.heatCleared();
+        }
+        recordSolve(probes);
+
+        return true;
+    }
 
-                int nextR = row + r;
-                int nextC = col + c;
-      
-                if (nextR < rows && nextC < cols) {
-                    int nextI = mapIndex(nextR, nextC);
-                    if (!board[nextI].getVisited()) {
-                        //set visited true and call getWords recursively
-                        board[nextI].setVisited(true);
-                        getWords(nextR, nextC, curr, word_matched, words, minimum_word_length);
+    /* State of one generic search: the dice on the path, as flags and,
+     * for sinks that look at them, as a mask; the word spelled so far
+     * and the blank dice on the path; and where to count */
+    struct BogglePlayer::Walk {
+        std::vector<char> visited;
+        uint64_t path_cells;
+        std::string word;
+        WildcardLetters letters;
+        ProbeSnapshot *probes;
+    };
+
+    /* Generic counterpart of the kernels' search, for any board size */
+    template <class Sink>
+    void BogglePlayer::searchBoard(Sink &sink, ProbeSnapshot *probes) const {
+        Walk walk;
+        walk.visited.assign(board.size(), false);
+        walk.path_cells = 0;
+        walk.probes = probes;
+        for (unsigned int i = 0; i < board.size(); i++) {
+            walk.visited[i] = true;
+            if (Sink::KEEPS_PATH)
+                walk.path_cells = (uint64_t)1 << i;
+            searchFrom(walk, i, lexicon->getRoot(), sink);
+            walk.visited[i] = false;
+        }
+    }
 
-                    }
-                }
+    template <class Sink>
+    void BogglePlayer::searchFrom(Walk &walk, int index, const FlatLexNode *curr,
+            Sink &sink) const {
+
+        const string &text = board[index].getText();
+        BOGGLE_COUNT(*walk.probes, PROBE_NODES_EXPANDED);
+        if (board[index].isWildcard()) {
+            const FlatLexNode *child = lexicon->firstChild(curr);
+            for (uint32_t options = curr->child_mask; options != 0;
+                    options &= options - 1, child++) {
+                BOGGLE_COUNT(*walk.probes, PROBE_TRIE_STEPS);
+                char letter = (char)('a' + __builtin_ctz(options));
+                if (Sink::KEEPS_WORD)
+                    walk.word.push_back(letter);
+                if (Sink::KEEPS_BLANKS)
+                    walk.letters.push_back(make_pair(index, letter));
+                extendSearch(walk, index, child, sink);
+                if (Sink::KEEPS_WORD)
+                    walk.word.pop_back();
+                if (Sink::KEEPS_BLANKS)
+                    walk.letters.pop_back();
+            }
+            return;
+        }
+        for (unsigned int i = 0; i < text.size(); i++) {
+            BOGGLE_COUNT(*walk.probes, PROBE_TRIE_STEPS);
+            curr = lexicon->getChild(curr, text[i]);
+            if (curr == NULL) {
+                BOGGLE_COUNT(*walk.probes, PROBE_DEAD_ENDS);
+                return;
             }
+        }
 
+        size_t old = walk.word.size();
+        if (Sink::KEEPS_WORD)
+            walk.word.append(text);
+        extendSearch(walk, index, curr, sink);
+        if (Sink::KEEPS_WORD)
+            walk.word.resize(old);
+    }
+
+    /* Hands sink the word ending at die index, if any, and continues
+     * into the die's unvisited neighbours */
+    template <class Sink>
+    void BogglePlayer::extendSearch(Walk &walk, int index, const FlatLexNode *curr,
+            Sink &sink) const {
+        if (!sink.enters(curr)) {
+            BOGGLE_COUNT(*walk.probes, PROBE_DEAD_ENDS);
+            return;
+        }
+        if (curr->word_id >= 0 && sink.wants(curr, walk.word.size())) {
+            BOGGLE_COUNT(*walk.probes, PROBE_WORDS_EMITTED);
+            if (Sink::KEEPS_PATH)
+                sink.path(curr, walk.path_cells);
+            if (Sink::KEEPS_BLANKS)
+                sink.blanks(curr, walk.letters);
+            if (!sink.add(curr, walk.word))
+                BOGGLE_COUNT(*walk.probes, PROBE_DUPLICATE_HITS);
+        }
+
+        const int *neighbours = topology.neighbours(index);
+        for (unsigned int n = 0; n < topology.degree(index); n++) {
+            int next = neighbours[n];
+            if (!walk.visited[next]) {
+                walk.visited[next] = true;
+                if (Sink::KEEPS_PATH)
+                    walk.path_cells |= (uint64_t)1 << next;
+                searchFrom(walk, next, curr, sink);
+                if (Sink::KEEPS_PATH)
+                    walk.path_cells &= ~((uint64_t)1 << next);
+                walk.visited[next] = false;
+            }
         }
-        board[index].setVisited(false);
     }
 
         
@@ -159,7 +588,7 @@ using namespace std;
      *
      * Returns true if the word is in the lexicon, and false if not.
      */
-    bool BogglePlayer::isInLexicon(const std::string &word_to_check) {
+    bool BogglePlayer::isInLexicon(const std::string &word_to_check) const {
         if(lexicon_built)
             return lexicon->find(word_to_check);
 
@@ -175,26 +604,30 @@ using namespace std;
      * returns an empty vector.
      */
 
-    std::vector<int> BogglePlayer::isOnBoard(const std::string &word_to_check) {
+    std::vector<int> BogglePlayer::isOnBoard(const std::string &word_to_check) const {
 
+        BOGGLE_TIMED(PHASE_IS_ON_BOARD);
         vector<int> returnVector;
         
         string wordtoCheck = setLowerCase(word_to_check);
         if (board_built == false)
             return returnVector;
 
+        if(kernel) {
+            kernel->findWord(wordtoCheck, &returnVector);
+            return returnVector;
+        }
+
         bool found = false;
 
-        //go over all board pos with iterator and set all visited to false
-        for(auto iterator = board.begin(); iterator != board.end(); ++iterator) {
-           (*iterator).setVisited(false); 
-        }
+        // the dice on the path, per call so that threads can search at once
+        std::vector<char> visited(board.size(), false);
 
         for(unsigned int x = 0; x < rows; ++x)
         {
             for(unsigned int y = 0; y < cols; ++y)
             {
-                found = findWord(x, y, wordtoCheck, 0, &returnVector);
+                found = findWord(x, y, wordtoCheck, 0, &returnVector, &visited);
                 if(found == true) {
                     return returnVector;
                 }  
@@ -205,6 +638,201 @@ using namespace std;
 
     }
 
+    /**
+     * Fills suggestions with up to limit lexicon words near guess, the
+     * nearest and those on the board first, looking on the board for as
+     * many as seconds allows.
+     */
+    bool BogglePlayer::suggestWords(const std::string &guess, unsigned max_distance,
+            unsigned limit, bool board_only, std::vector<std::string> *suggestions,
+            double seconds) const {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        suggestions->clear();
+        if(!lexicon_built || (board_only && !board_built))
+            return false;
+
+        // (distance, off the board, word): sorting these ranks them
+        struct Candidate {
+            unsigned distance;
+            bool off_board;
+            std::string word;
+            bool operator<(const Candidate &other) const {
+                if(distance != other.distance)
+                    return distance < other.distance;
+                if(off_board != other.off_board)
+                    return !off_board;
+                return word < other.word;
+            }
+        };
+        vector<Candidate> candidates;
+        fuzzyWords(*lexicon, setLowerCase(guess), max_distance,
+                [&candidates](const string &word, unsigned distance) {
+            if(distance > 0) {
+                Candidate candidate = { distance, true, word };
+                candidates.push_back(candidate);
+            }
+            return true;
+        });
+
+        // the nearest are looked up on the board first, each one path
+        // search rather than a solve of the whole board; those the
+        // budget leaves unchecked count as off the board
+        sort(candidates.begin(), candidates.end());
+        std::chrono::duration<double> budget(seconds);
+        size_t kept = 0;
+        for(size_t i = 0; i < candidates.size(); i++) {
+            if(board_built && (seconds <= 0 || std::chrono::steady_clock::now() - start < budget))
+                candidates[i].off_board = isOnBoard(candidates[i].word).empty();
+            if(!board_only || !candidates[i].off_board)
+                candidates[kept++] = candidates[i];
+        }
+        candidates.resize(kept);
+        sort(candidates.begin(), candidates.end());
+        for(size_t i = 0; i < candidates.size() && i < limit; i++)
+            suggestions->push_back(candidates[i].word);
+        return true;
+    }
+
+    /**
+     * Fills the supplied buffer with the words on the board, packed.
+     */
+    bool BogglePlayer::getAllValidWords(unsigned int minimum_word_length, WordBuffer *words) const {
+        if(!board_built || !lexicon_built)
+            return false;
+
+        words->clear();
+        ScratchLease scratch(lexicon->wordCount());
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        WordBufferSink sink(minimum_word_length, scratch.seen(), words);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->collectWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        }
+        recordSolve(probes);
+
+        return true;
+    }
+
+    /**
+     * Hands found the words on the board as the search reaches them.
+     */
+    bool BogglePlayer::getAllValidWords(unsigned int minimum_word_length,
+            const WordCallback &found) const {
+        if(!board_built || !lexicon_built)
+            return false;
+
+        ScratchLease scratch(lexicon->wordCount());
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        WordCallbackSink sink(minimum_word_length, scratch.seen(), found);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->collectWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        }
+        recordSolve(probes);
+
+        return true;
+    }
+
+    /**
+     * Scores the board best first until the budget runs out.
+     */
+    bool BogglePlayer::solveAnytime(const SolveBudget &budget, AnytimeResult *result) const {
+        if(!board_built || !lexicon_built)
+            return false;
+
+        const SubtrieValues &values = subtrieValues();
+        ScratchLease scratch(lexicon->wordCount());
+
+        std::vector<std::string> dice;
+        for(unsigned int i = 0; i < board.size(); i++)
+            dice.push_back(board[i].getText());
+        AnytimeSearch search(topology, dice);
+        search.search(*lexicon, values, scratch.seen(), budget, result);
+        return true;
+    }
+
+    /**
+     * Sorts the words on the board into one set per lexicon of a merged
+     * lexicon, in a single search.
+     */
+    bool BogglePlayer::getAllValidWords(unsigned int minimum_word_length,
+            const LexiconSet &lexicons, uint32_t which,
+            std::vector<std::set<std::string> > *words) const {
+        if(!board_built || !lexicon_built || lexicon != lexicons.getLexicon())
+            return false;
+
+        words->assign(lexicons.size(), std::set<std::string>());
+        ScratchLease scratch(lexicon->wordCount());
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        LexiconSetSink sink(lexicons, which, minimum_word_length, scratch.seen(), words);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->collectWords(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        }
+        recordSolve(probes);
+
+        return true;
+    }
+
+    /**
+     * Counts the distinct paths spelling the given word on the board.
+     */
+    uint64_t BogglePlayer::countPaths(const std::string &word_to_check) const {
+        return wordPaths(word_to_check).count();
+    }
+
+    /**
+     * Returns the paths spelling the given word on the board.
+     */
+    WordPaths BogglePlayer::wordPaths(const std::string &word_to_check) const {
+        std::vector<std::string> dice;
+        if(!board_built)
+            return WordPaths(BoardTopology(), dice, "");
+        for(unsigned int i = 0; i < board.size(); i++)
+            dice.push_back(board[i].getText());
+        return WordPaths(topology, dice, setLowerCase(word_to_check));
+    }
+
+    /**
+     * Populates the supplied map with every word on the board and its
+     * number of paths.
+     */
+    bool BogglePlayer::getAllPathCounts(unsigned int minimum_word_length,
+            std::map<std::string, uint64_t> *counts) const {
+        if(!board_built || !lexicon_built)
+            return false;
+
+        ProbeSnapshot probes;
+        {
+        BOGGLE_PHASE(probes, PHASE_GET_ALL_VALID_WORDS);
+        PathCountSink sink(minimum_word_length, counts);
+        if(interleaved)
+            interleaved->search(*lexicon, interleave_cursors, sink);
+        else if(kernel)
+            kernel->countPaths(*lexicon, &sink, &probes);
+        else
+            searchBoard(sink, &probes);
+        }
+        recordSolve(probes);
+
+        return true;
+    }
+
     /**
      * Returns a custom board for the boggle ui. The board is loaded
      * from the file custboard.txt in the current working directory.
@@ -219,7 +847,7 @@ using namespace std;
      * sets the board diceArray to lowercase 
      * uses standard c++ function strlen */
 
-     std::string BogglePlayer::setLowerCase(std::string string) {
+     std::string BogglePlayer::setLowerCase(std::string string) const {
         std::string newString;
         int length = string.length();
         for( int i = 0; i<length; i++ ) {
@@ -230,7 +858,7 @@ using namespace std;
 
     /* Helper method to map the index of the current letter to the 
      * board vector */
-    int BogglePlayer::mapIndex(int row, int col) {
+    int BogglePlayer::mapIndex(int row, int col) const {
         if(row < 0 || col < 0 || row >= this->rows || col >= this->cols) {
             return -1;
         }
@@ -240,62 +868,70 @@ using namespace std;
     }
 
     /* Helper method used in isOnBoard to see if the word is actually there
-     * calls recursively
+     * matches the die at row, col against the word from word_letter on,
+     * then calls recursively on its unvisited neighbours
      * returns true if word is found and matches
      */
 
     bool BogglePlayer::findWord(unsigned int row, unsigned int col, const string &word_to_check, 
-            unsigned int word_letter, vector<int> *positions) 
+            unsigned int word_letter, vector<int> *positions, std::vector<char> *visited) const
     {
 
         if(row>=rows || col >= cols){
             return false;
         }
-        if (word_letter > word_to_check.length()){
+        if (word_letter >= word_to_check.length()){
             return false;
         }
+
+        int here = mapIndex(row, col);
+        if((*visited)[here]){
+            return false;
+        }
+
+        string curStr = board[here].getText();
+
+        int size = curStr.size();
+        bool matches;
+
+        // a blank die matches any one letter
+        if(board[here].isWildcard()){
+            size = 1;
+            matches = (unsigned char)(word_to_check[word_letter] - 'a') < 26;
+        }
+        else{
+            string str = word_to_check.substr(word_letter, size);
+            matches = curStr.compare(str)==0;
+        }
+        //see if string is equal
+        if(!matches){
+            return false;
+        }
+
+        (*visited)[here] = true;
+        positions->push_back(here);
+        word_letter+=size;
         if (word_letter == word_to_check.length()){
             return true;
         }
 
-        bool found = 0;
-
-        //array to go through neighbors
-        int pos[8][2] = {-1,-1,-1,0,-1,1,0,-1,0,1,1,-1,1,0,1,1};
-        for(int i = 0; i<8; i++){
+        //list to go through neighbors
+        const int *neighbours = topology.neighbours(here);
+        for(unsigned int i = 0; i < topology.degree(here); i++){
 
             //make current r and c the neighbors before calling
-            int r = row + pos[i][0];
-            int c = col + pos[i][1];
-
-            //find index
-            int index = mapIndex(r,c);
-
-            if(board[index].getVisited()==false){
-
-                string curStr = board[index].getText();
-
-                int size = curStr.size();
-
-                string str = word_to_check.substr(word_letter, size);
-                //see if string is equal
-                if(curStr.compare(str)==0){ 
-                    board[index].setVisited(true);
-                    positions->push_back(index); 
-                    word_letter+=size;
-                    found = findWord(r,c,word_to_check, word_letter, positions);
-                    if(found){
-                        return true;
-                    }
-                    else{
-                        //reset visited and pop
-                        board[index].setVisited(false);
-                        positions->pop_back();
-                        word_letter-=size;
-                    }
-                }
+            int index = neighbours[i];
+            int r = index / cols;
+            int c = index % cols;
+
+            if(findWord(r,c,word_to_check, word_letter, positions, visited)){
+                return true;
             }
         }
+
+        //reset visited and pop
+        (*visited)[here] = false;
+        positions->pop_back();
         return false;
     }
 
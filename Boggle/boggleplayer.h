@@ -3,6 +3,9 @@
 #ifndef BOGGLEPLAYER_H
 #define BOGGLEPLAYER_H
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -10,13 +13,30 @@
  * DO NOT include any GUI related files. 
  */
 #include "baseboggleplayer.h"
+#include "boggleanytime.h"
+#include "boggleheat.h"
+#include "bogglekernel.h"
+#include "bogglepaths.h"
+#include "boggleinterleave.h"
+#include "boggleprobe.h"
+#include "bogglescore.h"
+#include "boggletopology.h"
 #include "boggleutil.h"
-
+#include "flatlexicon.h"
+#include "lexiconloader.h"
+#include "lexiconset.h"
 
 /**
  * BogglePlayer class conforming to the BaseBogglePlayer interface.
  *
  * Utilizes  a simple vector for storing the board.
+ *
+ * The const queries, from isOnBoard to the whole-board searches
+ * (getAllValidWords, scoreBoard and the like), keep their scratch
+ * state on the stack or in the calling thread's own buffers, so once
+ * the lexicon and board are set any number of threads may call them
+ * at once without locking. Setting the lexicon, board or rules needs
+ * the player to itself.
  */
 class BogglePlayer : public BaseBogglePlayer {
   public:
@@ -26,18 +46,80 @@ class BogglePlayer : public BaseBogglePlayer {
      */
     BogglePlayer();
 
+    /**
+     * Constructs a BogglePlayer whose lexicon is ready to use: it
+     * searches the image's node arrays (typically the lexicon lexgen
+     * compiled into the program) in place, without reading or building
+     * anything.
+     */
+    explicit BogglePlayer(const FlatLexiconImage &image);
+
     /**
      * Initializes the BogglePlayer's Lexicon using the supplied word
-     * list. Words are inserted in a case-insensitive manner.
+     * list. Words are inserted in a case-insensitive manner; those
+     * with characters other than letters are left out and listed by
+     * getRejectedWords.
      */
     void buildLexicon(const std::set<std::string> &word_list);
 
+    /* Words the last buildLexicon call given a std::set could not
+     * store, as given */
+    const std::vector<std::string> &getRejectedWords() const { return rejected_words; }
+
+    /**
+     * Initializes the BogglePlayer's Lexicon from a sorted word list
+     * produced by loadWordList, laying out the trie in bulk on up to
+     * threads threads (0 means one per core). Unlike the std::set
+     * overload no per-word strings are created along the way.
+     */
+    void buildLexicon(const WordList &words, unsigned threads = 0);
+
+    /**
+     * Makes this BogglePlayer search the lexicon already built by other
+     * instead of building its own copy. The trie is shared, not copied;
+     * rebuilding either player's lexicon afterwards only affects that
+     * player.
+     */
+    void shareLexicon(const BogglePlayer &other);
+
+    /**
+     * Makes this BogglePlayer search snapshot, such as one pinned from
+     * LexiconVersions, which it holds until given another lexicon.
+     */
+    void useLexicon(const std::shared_ptr<const FlatLexicon> &snapshot);
+
+    /**
+     * The lexicon this BogglePlayer searches, for solvers that work on
+     * it directly (such as SlicedSolver). It stays valid while the
+     * returned pointer is held, even if the player is rebuilt.
+     */
+    std::shared_ptr<const FlatLexicon> getLexicon() const { return lexicon; }
+
     /**
      * Initializes the BogglePlayer's internal board representation
-     * using the supplied multidimentional array.
+     * using the supplied multidimentional array. A die reading
+     * WILDCARD_DIE ("?") is blank and stands for any one letter.
      */
     void setBoard(unsigned int rows, unsigned int cols,
             std::string **diceArray);
+
+    /**
+     * Initializes the board from rows * cols dice in row-major order,
+     * as a BoardStreamReader decodes them, without the array of rows.
+     */
+    void setBoard(unsigned int rows, unsigned int cols,
+            const std::vector<std::string> &dice);
+
+    /**
+     * Initializes a board of any shape: topology says which dice touch
+     * (see BoardTopology) and dice holds one die per cell. Boards that
+     * are not a plain grid use the generic search, which costs the same
+     * per step whatever the shape.
+     */
+    void setBoard(const BoardTopology &topology, const std::vector<std::string> &dice);
+
+    /* Which dice of the current board touch */
+    const BoardTopology &getTopology() const { return topology; }
     
     /**
      * Populates the supplied set with the words in the BogglePlayer's
@@ -48,11 +130,108 @@ class BogglePlayer : public BaseBogglePlayer {
      * initialized. Returns true otherwise.
      */
     bool getAllValidWords(unsigned int minimum_word_length,
-            std::set<std::string> *words);
+            std::set<std::string> *words) const;
+
+    /**
+     * Populates the supplied map with the same words as the set
+     * overload, each mapped to the letters the board's blank dice stand
+     * for on the first path the search traced for it (empty if that
+     * path uses no blanks), in the same single search.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool getAllValidWords(unsigned int minimum_word_length,
+            std::map<std::string, WildcardLetters> *words) const;
+
+    /**
+     * Fills the supplied buffer with the same words as the set
+     * overload, in the order they are found rather than sorted, packed
+     * without a string per word. The buffer is cleared first and its
+     * memory reused.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool getAllValidWords(unsigned int minimum_word_length, WordBuffer *words) const;
+
+    /**
+     * Hands found the same words as the set overload, one at a time as
+     * the search first reaches them, so that a caller can show words
+     * before the search is over. If found returns false the search
+     * stops.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool getAllValidWords(unsigned int minimum_word_length, const WordCallback &found) const;
+
+    /**
+     * Sorts the words on the board into words, which is given one set
+     * per lexicon of lexicons: each word of at least
+     * minimum_word_length characters goes into the set of every lexicon
+     * holding it whose bit is set in which (see LexiconSet::allMask).
+     * The board is searched once whatever the number of lexicons, and
+     * the parts of the trie only other lexicons reach are skipped.
+     *
+     * The player must be searching lexicons.getLexicon() (see
+     * useLexicon). Returns false if it is not, or if the board has not
+     * been initialized. Returns true otherwise.
+     */
+    bool getAllValidWords(unsigned int minimum_word_length, const LexiconSet &lexicons,
+            uint32_t which, std::vector<std::set<std::string> > *words) const;
+
+    /**
+     * Sets the rules scoreBoard scores words by; the official rules
+     * until changed.
+     */
+    void setScoringRules(const ScoringRules &rules);
+
+    /**
+     * Scores the board: fills result with the number of distinct words
+     * on it that count under the scoring rules, their total score and a
+     * count per length. With top_k > 0 the best top_k words in the given
+     * order are returned as well. No set of words is built, so this is
+     * much cheaper than getAllValidWords for counting and scoring.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool scoreBoard(unsigned int top_k, ScoreOrder order, ScoreResult *result) const;
+
+    /**
+     * Scores the board like scoreBoard with top_k 0 and, in the same
+     * search, fills heat with how many of the counting words and points
+     * use each die (see CellHeat), indexed by board position. This is
+     * what calling isOnBoard for every word would give, without the
+     * second search per word.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized, or the board has more than 64 dice. Returns true
+     * otherwise.
+     */
+    bool getCellHeat(ScoreResult *result, CellHeat *heat) const;
 
-    /* Helper function for getAllValidWords */
-    void getWords(int row, int col, LexNode *cur, std::string 
-        word_matched, std::set<std::string> *words, unsigned int minimum_word_length);
+    /**
+     * Same as getCellHeat, and hands found every word that counts the
+     * first time the search reaches it, in the order found, so that
+     * the words and their heat come from one search. If found returns
+     * false the search stops, and result and heat cover only the words
+     * found until then.
+     */
+    bool getCellHeat(ScoreResult *result, CellHeat *heat, const WordCallback &found) const;
+
+    /**
+     * Scores the board like scoreBoard, but within a budget: the most
+     * promising paths are searched first (see AnytimeSearch), and when
+     * the budget runs out the words found so far are returned, with
+     * result->complete false. Every word found is in result->found.top,
+     * best first. An empty budget searches the whole board.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool solveAnytime(const SolveBudget &budget, AnytimeResult *result) const;
 
     /**
      * Determines if the given word is in the BogglePlayer's lexicon.
@@ -60,7 +239,7 @@ class BogglePlayer : public BaseBogglePlayer {
      *
      * Returns true if the word is in the lexicon, and false if not.
      */
-    bool isInLexicon(const std::string &word_to_check);
+    bool isInLexicon(const std::string &word_to_check) const;
 
     /**
      * Determines if the given word is on the BogglePlayer's board.
@@ -70,7 +249,53 @@ class BogglePlayer : public BaseBogglePlayer {
      * that make up the word, if the word exists on the board. Otherwise,
      * returns an empty vector.
      */
-    std::vector<int> isOnBoard(const std::string &word_to_check);
+    std::vector<int> isOnBoard(const std::string &word_to_check) const;
+
+    /**
+     * Counts the distinct paths spelling the given word on the board,
+     * where isOnBoard finds only one. The board is searched in a
+     * case-insensitive fashion.
+     *
+     * Returns 0 if the word is not on the board or the board has not
+     * been initialized.
+     */
+    uint64_t countPaths(const std::string &word_to_check) const;
+
+    /**
+     * Returns the paths spelling the given word on the board, to be
+     * counted or enumerated one at a time (see WordPaths). They do not
+     * change if the board does.
+     */
+    WordPaths wordPaths(const std::string &word_to_check) const;
+
+    /**
+     * Fills suggestions with up to limit lexicon words within
+     * max_distance edits of guess (see fuzzyWords), for a guess that
+     * was turned down. The nearest come first, and among equally near
+     * words those on the board come before those that are not; ties go
+     * alphabetically. The guess itself is never suggested. With
+     * board_only, only words on the board are suggested.
+     *
+     * Candidates are looked up on the board one at a time, nearest
+     * first, until seconds have passed since the call began (0 for no
+     * limit); any left unchecked are taken to be off the board.
+     *
+     * Returns false if the lexicon has not been initialized, or
+     * board_only is asked for without a board. Returns true otherwise.
+     */
+    bool suggestWords(const std::string &guess, unsigned max_distance, unsigned limit,
+            bool board_only, std::vector<std::string> *suggestions, double seconds = 0) const;
+
+    /**
+     * Populates the supplied map with the same words as
+     * getAllValidWords, each mapped to the number of distinct paths
+     * spelling it, counted in the same single search of the board.
+     *
+     * Returns false if either the board or the lexicon has not been
+     * initialized. Returns true otherwise.
+     */
+    bool getAllPathCounts(unsigned int minimum_word_length,
+            std::map<std::string, uint64_t> *counts) const;
 
     /**
      * Returns a custom board for the boggle ui. The board is loaded
@@ -81,23 +306,48 @@ class BogglePlayer : public BaseBogglePlayer {
             unsigned int *rows, unsigned int *cols);
 
     /* Helper method used in isOnBoard to see if the word is actually there
-     * calls recursively
+     * starting from the die at row, col; calls recursively on its
+     * neighbours, marking the dice on the path in visited
      * returns true if word is found and matches
      */
     bool findWord(unsigned int row, unsigned int col, const std::string 
-        &word_to_check, unsigned int word_pos, vector<int> *returnVector2);
+        &word_to_check, unsigned int word_pos, vector<int> *returnVector2,
+        std::vector<char> *visited) const;
 
     /* Helper method to map the index of the current letter to the 
      * board vector */
-    int mapIndex(int row, int col);
+    int mapIndex(int row, int col) const;
 
     bool lexIsBuilt();
 
+    /**
+     * Enables or disables the board-size specialized search kernels
+     * (on by default). Takes effect at the next setBoard; meant for
+     * benchmarking the kernels against the generic search.
+     */
+    void setKernelsEnabled(bool enabled);
+
+    /**
+     * Makes getAllValidWords, scoreBoard and getAllPathCounts run
+     * cursors interleaved walks (see InterleavedSearch) instead of one,
+     * for boards of up to 64 dice; 0 or 1 turns it off (the default).
+     * Takes effect at the next setBoard.
+     */
+    void setInterleavedCursors(unsigned int cursors);
+
+    /**
+     * Returns what the last getAllValidWords or scoreBoard call made on
+     * the calling thread did, by any player: trie steps, cells
+     * expanded, dead ends, words emitted and its running time.
+     * All zero unless built with BOGGLE_PROBES (make PROBES=1).
+     */
+    static const ProbeSnapshot &lastSolveProbes();
+
 
     /* Helper method for setBoard
      * sets the board diceArray to lowercase 
      * uses standard c++ function strlen */
-     std::string setLowerCase(std::string string);
+     std::string setLowerCase(std::string string) const;
 
   
   private:
@@ -112,6 +362,10 @@ class BogglePlayer : public BaseBogglePlayer {
     unsigned int rows;
     unsigned int cols;
 
+    /* Neighbour lists of the board's dice, which the generic search
+     * and isOnBoard walk */
+    BoardTopology topology;
+
     /**
      * Whether the boggle board has been initialized or not.
      */
@@ -119,9 +373,50 @@ class BogglePlayer : public BaseBogglePlayer {
 
     bool lexicon_built;
 
-    /* Multiway trie representing the lexicon */
-    Lexicon * lexicon;
-    std::set<std::string> word_list;
+    /* Specialized search for the current board size, or NULL to use
+     * the generic searchBoard/findWord search */
+    std::unique_ptr<BoardKernel> kernel;
+    bool kernels_enabled;
+
+    /* Interleaved search of the current board, or NULL if off; it
+     * takes precedence over the kernel for whole-board searches */
+    std::unique_ptr<InterleavedSearch> interleaved;
+    unsigned int interleave_cursors;
+
+    /* Flat multiway trie representing the lexicon, possibly shared
+     * with other players (see shareLexicon) */
+    std::shared_ptr<const FlatLexicon> lexicon;
+
+    /* Words the last buildLexicon left out */
+    std::vector<std::string> rejected_words;
+
+    /* Lengths and points the scoring rules give every word of the
+     * lexicon, and node values under them for solveAnytime, each built
+     * once by the first solve that needs it. Replaced whenever the
+     * lexicon or the rules change; players sharing both share them. */
+    struct ScoreTables {
+        std::once_flag table_once;
+        std::once_flag values_once;
+        std::shared_ptr<const ScoreTable> table;
+        std::shared_ptr<const SubtrieValues> values;
+    };
+    ScoringRules scoring_rules;
+    std::shared_ptr<ScoreTables> score_tables;
+
+    const ScoreTable &scoreTable() const;
+    const SubtrieValues &subtrieValues() const;
+
+    /* Feeds every word on the board to sink, for boards without a
+     * kernel; each call keeps its path and word in a Walk of its own */
+    struct Walk;
+    template <class Sink> void searchBoard(Sink &sink, ProbeSnapshot *probes) const;
+    template <class Sink> void searchFrom(Walk &walk, int index, const FlatLexNode *node,
+            Sink &sink) const;
+    template <class Sink> void extendSearch(Walk &walk, int index, const FlatLexNode *node,
+            Sink &sink) const;
+
+    void useGrid();
+    void finishBoard();
 
 };
 
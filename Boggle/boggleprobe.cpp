@@ -0,0 +1,134 @@
+#include "boggleprobe.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+static const char *COUNTER_NAMES[PROBE_COUNTERS] = {
+    "trie_steps", "nodes_expanded", "dead_ends", "words_emitted", "duplicate_hits"
+};
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "buildLexicon", "setBoard", "getAllValidWords", "isOnBoard", "scoreBoard"
+};
+
+/* Number of uint64 values in a snapshot */
+static const unsigned PROBE_VALUES = PROBE_COUNTERS + 2 * PHASE_COUNT;
+
+    void ProbeSnapshot::add(const ProbeSnapshot &other) {
+        for(unsigned i = 0; i < PROBE_COUNTERS; i++) {
+            counters[i] += other.counters[i];
+        }
+        for(unsigned i = 0; i < PHASE_COUNT; i++) {
+            phase_calls[i] += other.phase_calls[i];
+            phase_ns[i] += other.phase_ns[i];
+        }
+    }
+
+    std::string ProbeSnapshot::toJson() const {
+        std::ostringstream out;
+        out << "{\"enabled\":" << (probesEnabled() ? "true" : "false");
+        for(unsigned i = 0; i < PROBE_COUNTERS; i++) {
+            out << ",\"" << COUNTER_NAMES[i] << "\":" << counters[i];
+        }
+        out << ",\"phases\":{";
+        for(unsigned i = 0; i < PHASE_COUNT; i++) {
+            out << (i ? "," : "") << "\"" << PHASE_NAMES[i] << "\":{\"calls\":"
+                << phase_calls[i] << ",\"ns\":" << phase_ns[i] << "}";
+        }
+        out << "}}";
+        return out.str();
+    }
+
+    bool probesEnabled() {
+#ifdef BOGGLE_PROBES
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * One thread's running totals. Only the owning thread writes them;
+     * the atomics (accessed relaxed, so plain loads and stores on x86)
+     * only make concurrent reads by probeTotals well defined.
+     */
+    struct ThreadProbes {
+        std::atomic<uint64_t> values[PROBE_VALUES];
+
+        ThreadProbes();
+        ~ThreadProbes();
+    };
+
+    /* Every live thread's totals, plus what exited threads left behind */
+    static std::mutex registry_lock;
+    static std::set<ThreadProbes *> registry;
+    static uint64_t retired[PROBE_VALUES];
+
+    ThreadProbes::ThreadProbes() {
+        for(unsigned i = 0; i < PROBE_VALUES; i++) {
+            values[i].store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> guard(registry_lock);
+        registry.insert(this);
+    }
+
+    ThreadProbes::~ThreadProbes() {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        for(unsigned i = 0; i < PROBE_VALUES; i++) {
+            retired[i] += values[i].load(std::memory_order_relaxed);
+        }
+        registry.erase(this);
+    }
+
+    /* Flattens a snapshot into PROBE_VALUES numbers and back */
+    static void flatten(const ProbeSnapshot &s, uint64_t *v) {
+        for(unsigned i = 0; i < PROBE_COUNTERS; i++) {
+            v[i] = s.counters[i];
+        }
+        for(unsigned i = 0; i < PHASE_COUNT; i++) {
+            v[PROBE_COUNTERS + i] = s.phase_calls[i];
+            v[PROBE_COUNTERS + PHASE_COUNT + i] = s.phase_ns[i];
+        }
+    }
+
+    static ProbeSnapshot unflatten(const uint64_t *v) {
+        ProbeSnapshot s;
+        for(unsigned i = 0; i < PROBE_COUNTERS; i++) {
+            s.counters[i] = v[i];
+        }
+        for(unsigned i = 0; i < PHASE_COUNT; i++) {
+            s.phase_calls[i] = v[PROBE_COUNTERS + i];
+            s.phase_ns[i] = v[PROBE_COUNTERS + PHASE_COUNT + i];
+        }
+        return s;
+    }
+
+    void probeRecord(const ProbeSnapshot &delta) {
+        if(!probesEnabled())
+            return;
+        static thread_local ThreadProbes mine;
+        uint64_t v[PROBE_VALUES];
+        flatten(delta, v);
+        for(unsigned i = 0; i < PROBE_VALUES; i++) {
+            if(v[i] != 0) {
+                mine.values[i].store(mine.values[i].load(std::memory_order_relaxed) + v[i],
+                        std::memory_order_relaxed);
+            }
+        }
+    }
+
+    ProbeSnapshot probeTotals() {
+        uint64_t sum[PROBE_VALUES];
+        std::lock_guard<std::mutex> guard(registry_lock);
+        for(unsigned i = 0; i < PROBE_VALUES; i++) {
+            sum[i] = retired[i];
+        }
+        for(std::set<ThreadProbes *>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+            for(unsigned i = 0; i < PROBE_VALUES; i++) {
+                sum[i] += (*it)->values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return unflatten(sum);
+    }
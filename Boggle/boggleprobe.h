@@ -0,0 +1,116 @@
+#ifndef BOGGLEPROBE_H
+#define BOGGLEPROBE_H
+
+#include <stdint.h>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/**
+ * Optional instrumentation of the solver and lexicon.
+ *
+ * Built with -DBOGGLE_PROBES (make PROBES=1) the searches count what
+ * they do into a ProbeSnapshot owned by the search, and the player
+ * times its public operations. Without it the BOGGLE_* macros expand to
+ * nothing, so the hot paths are exactly the uninstrumented code and
+ * every snapshot reads zero.
+ */
+
+/* Event counters */
+enum ProbeCounter {
+    PROBE_TRIE_STEPS,       // child lookups in the lexicon trie
+    PROBE_NODES_EXPANDED,   // board cells entered by a search
+    PROBE_DEAD_ENDS,        // lookups that found no child and pruned
+    PROBE_WORDS_EMITTED,    // words handed to the result
+    PROBE_DUPLICATE_HITS,   // of those, words the result already had
+    PROBE_COUNTERS
+};
+
+/* Timed operations */
+enum ProbePhase {
+    PHASE_BUILD_LEXICON,
+    PHASE_SET_BOARD,
+    PHASE_GET_ALL_VALID_WORDS,
+    PHASE_IS_ON_BOARD,
+    PHASE_SCORE_BOARD,
+    PHASE_COUNT
+};
+
+/**
+ * Plain counters for one search or any sum of them. Searches increment
+ * their own snapshot without synchronization and hand it to
+ * probeRecord when done.
+ */
+struct ProbeSnapshot {
+    uint64_t counters[PROBE_COUNTERS];
+    uint64_t phase_calls[PHASE_COUNT];
+    uint64_t phase_ns[PHASE_COUNT];
+
+    ProbeSnapshot() { clear(); }
+
+    void clear() {
+        for(unsigned i = 0; i < PROBE_COUNTERS; i++)
+            counters[i] = 0;
+        for(unsigned i = 0; i < PHASE_COUNT; i++)
+            phase_calls[i] = phase_ns[i] = 0;
+    }
+
+    void add(const ProbeSnapshot &other);
+
+    /* {"enabled":..,"trie_steps":..,...,"phases":{"setBoard":{...}}} */
+    std::string toJson() const;
+};
+
+/* Whether this build was compiled with BOGGLE_PROBES */
+bool probesEnabled();
+
+/**
+ * Adds a finished search's counts to the calling thread's running
+ * totals. Each thread writes only its own totals, so recording never
+ * contends with other threads.
+ */
+void probeRecord(const ProbeSnapshot &delta);
+
+/* Sum of every thread's totals, including threads that have exited */
+ProbeSnapshot probeTotals();
+
+/**
+ * Times a scope into a snapshot's phase counters, or, without a
+ * snapshot, straight into the calling thread's totals. Use through
+ * BOGGLE_PHASE and BOGGLE_TIMED.
+ */
+class ProbePhaseTimer {
+  public:
+    ProbePhaseTimer(ProbeSnapshot *snapshot, ProbePhase phase)
+        : target(snapshot ? *snapshot : own), record(snapshot == NULL), phase(phase),
+          start(std::chrono::steady_clock::now()) {}
+
+    ~ProbePhaseTimer() {
+        target.phase_calls[phase]++;
+        target.phase_ns[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        if(record)
+            probeRecord(own);
+    }
+
+  private:
+    ProbeSnapshot own;
+    ProbeSnapshot &target;
+    bool record;
+    ProbePhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef BOGGLE_PROBES
+#define BOGGLE_COUNT(snapshot, counter) ((snapshot).counters[counter]++)
+#define BOGGLE_PHASE(snapshot, phase) ProbePhaseTimer probe_phase_timer(&(snapshot), (phase))
+#define BOGGLE_TIMED(phase) ProbePhaseTimer probe_phase_timer(NULL, (phase))
+#define BOGGLE_RECORD(snapshot) probeRecord(snapshot)
+#else
+#define BOGGLE_COUNT(snapshot, counter) ((void)0)
+#define BOGGLE_PHASE(snapshot, phase) ((void)0)
+#define BOGGLE_TIMED(phase) ((void)0)
+#define BOGGLE_RECORD(snapshot) ((void)0)
+#endif
+
+#endif // BOGGLEPROBE_H
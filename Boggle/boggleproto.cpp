@@ -0,0 +1,329 @@
+#include "boggleproto.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+    FrameWriter::FrameWriter() : buf(4, '\0') {
+    }
+
+    void FrameWriter::putU8(uint8_t v) {
+        buf.push_back((char)v);
+    }
+
+    void FrameWriter::putU16(uint16_t v) {
+        putU8(v & 0xff);
+        putU8(v >> 8);
+    }
+
+    void FrameWriter::putU32(uint32_t v) {
+        putU16(v & 0xffff);
+        putU16(v >> 16);
+    }
+
+    void FrameWriter::putU64(uint64_t v) {
+        putU32((uint32_t)v);
+        putU32((uint32_t)(v >> 32));
+    }
+
+    void FrameWriter::putString(const std::string &s) {
+        size_t len = s.size() > 255 ? 255 : s.size();
+        putU8((uint8_t)len);
+        buf.append(s, 0, len);
+    }
+
+    void FrameWriter::putText(const std::string &s) {
+        putU32((uint32_t)s.size());
+        buf.append(s);
+    }
+
+    std::string FrameWriter::finish() {
+        uint32_t len = (uint32_t)(buf.size() - 4);
+        for(int i = 0; i < 4; i++) {
+            buf[i] = (char)((len >> (8 * i)) & 0xff);
+        }
+        std::string frame;
+        frame.swap(buf);
+        buf.assign(4, '\0');
+        return frame;
+    }
+
+    FrameReader::FrameReader(const char *data, size_t size)
+        : data((const unsigned char *)data), size(size), pos(0) {
+    }
+
+    bool FrameReader::getU8(uint8_t *v) {
+        if(pos + 1 > size)
+            return false;
+        *v = data[pos++];
+        return true;
+    }
+
+    bool FrameReader::getU16(uint16_t *v) {
+        if(pos + 2 > size)
+            return false;
+        *v = (uint16_t)(data[pos] | (data[pos + 1] << 8));
+        pos += 2;
+        return true;
+    }
+
+    bool FrameReader::getU32(uint32_t *v) {
+        uint16_t lo, hi;
+        if(!getU16(&lo) || !getU16(&hi))
+            return false;
+        *v = lo | ((uint32_t)hi << 16);
+        return true;
+    }
+
+    bool FrameReader::getU64(uint64_t *v) {
+        uint32_t lo, hi;
+        if(!getU32(&lo) || !getU32(&hi))
+            return false;
+        *v = lo | ((uint64_t)hi << 32);
+        return true;
+    }
+
+    bool FrameReader::getString(std::string *s) {
+        uint8_t len;
+        if(!getU8(&len) || pos + len > size)
+            return false;
+        s->assign((const char *)data + pos, len);
+        pos += len;
+        return true;
+    }
+
+    bool FrameReader::getText(std::string *s) {
+        uint32_t len;
+        if(!getU32(&len) || len > size - pos)
+            return false;
+        s->assign((const char *)data + pos, len);
+        pos += len;
+        return true;
+    }
+
+    bool FrameReader::atEnd() const {
+        return pos == size;
+    }
+
+    bool frameComplete(const std::string &buf, uint32_t *payload_size, bool *bad) {
+        *bad = false;
+        if(buf.size() < 4)
+            return false;
+        const unsigned char *p = (const unsigned char *)buf.data();
+        uint32_t len = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        if(len > MAX_FRAME_SIZE) {
+            *bad = true;
+            return false;
+        }
+        *payload_size = len;
+        return buf.size() >= 4 + (size_t)len;
+    }
+
+    bool readFull(int fd, void *data, size_t size) {
+        char *p = (char *)data;
+        while(size > 0) {
+            ssize_t n = read(fd, p, size);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool writeFull(int fd, const void *data, size_t size) {
+        const char *p = (const char *)data;
+        while(size > 0) {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool readFrame(int fd, std::string *payload) {
+        unsigned char hdr[4];
+        if(!readFull(fd, hdr, 4))
+            return false;
+        uint32_t len = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+        if(len > MAX_FRAME_SIZE)
+            return false;
+        payload->resize(len);
+        return len == 0 || readFull(fd, &(*payload)[0], len);
+    }
+
+    /* Fills in a sockaddr for address, returning its length or 0 if
+     * the address is malformed */
+    static socklen_t parseAddress(const std::string &address,
+            sockaddr_storage *storage) {
+        memset(storage, 0, sizeof(*storage));
+        if(address.compare(0, 5, "unix:") == 0) {
+            sockaddr_un *un = (sockaddr_un *)storage;
+            std::string path = address.substr(5);
+            if(path.empty() || path.size() >= sizeof(un->sun_path))
+                return 0;
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path, path.c_str(), path.size() + 1);
+            return sizeof(sockaddr_un);
+        }
+        if(address.compare(0, 4, "tcp:") == 0) {
+            sockaddr_in *in = (sockaddr_in *)storage;
+            int port = atoi(address.c_str() + 4);
+            if(port <= 0 || port > 65535)
+                return 0;
+            in->sin_family = AF_INET;
+            in->sin_port = htons((uint16_t)port);
+            in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return sizeof(sockaddr_in);
+        }
+        return 0;
+    }
+
+    int listenOn(const std::string &address) {
+        sockaddr_storage addr;
+        socklen_t len = parseAddress(address, &addr);
+        if(len == 0) {
+            fprintf(stderr, "Bad address %s (want unix:PATH or tcp:PORT)\n", address.c_str());
+            return -1;
+        }
+        int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+        if(fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        if(addr.ss_family == AF_UNIX) {
+            unlink(((sockaddr_un *)&addr)->sun_path);
+        }
+        else {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if(bind(fd, (sockaddr *)&addr, len) < 0 || listen(fd, 128) < 0) {
+            perror(address.c_str());
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int connectTo(const std::string &address) {
+        sockaddr_storage addr;
+        socklen_t len = parseAddress(address, &addr);
+        if(len == 0) {
+            fprintf(stderr, "Bad address %s (want unix:PATH or tcp:PORT)\n", address.c_str());
+            return -1;
+        }
+        int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+        if(fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        if(connect(fd, (sockaddr *)&addr, len) < 0) {
+            perror(address.c_str());
+            close(fd);
+            return -1;
+        }
+        if(addr.ss_family == AF_INET) {
+            // pipelined small frames must not wait for Nagle
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        return fd;
+    }
+
+    /* Values below 64us get a bucket each; above that every power of
+     * two is split into 32 buckets */
+    static const unsigned LINEAR_BUCKETS = 64;
+    static const unsigned SUB_BUCKETS = 32;
+
+    LatencyHistogram::LatencyHistogram()
+        : buckets(LINEAR_BUCKETS + (64 - 6) * SUB_BUCKETS, 0), samples(0), largest(0) {
+    }
+
+    unsigned LatencyHistogram::bucketOf(uint64_t usec) {
+        if(usec < LINEAR_BUCKETS)
+            return (unsigned)usec;
+        unsigned e = 63 - __builtin_clzll(usec);
+        unsigned sub = (unsigned)(usec >> (e - 5)) & (SUB_BUCKETS - 1);
+        return LINEAR_BUCKETS + (e - 6) * SUB_BUCKETS + sub;
+    }
+
+    uint64_t LatencyHistogram::bucketValue(unsigned bucket) {
+        if(bucket < LINEAR_BUCKETS)
+            return bucket;
+        unsigned e = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 6;
+        uint64_t sub = (bucket - LINEAR_BUCKETS) % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << (e - 5);
+    }
+
+    void LatencyHistogram::record(uint64_t usec) {
+        buckets[bucketOf(usec)]++;
+        samples++;
+        if(usec > largest)
+            largest = usec;
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram &other) {
+        for(size_t i = 0; i < buckets.size(); i++) {
+            buckets[i] += other.buckets[i];
+        }
+        samples += other.samples;
+        if(other.largest > largest)
+            largest = other.largest;
+    }
+
+    uint64_t LatencyHistogram::count() const {
+        return samples;
+    }
+
+    uint64_t LatencyHistogram::max() const {
+        return largest;
+    }
+
+    uint64_t LatencyHistogram::percentile(double fraction) const {
+        if(samples == 0)
+            return 0;
+        uint64_t rank = (uint64_t)(fraction * samples);
+        if(rank >= samples)
+            return largest;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if(seen > rank) {
+                uint64_t v = bucketValue((unsigned)i);
+                return v < largest ? v : largest;
+            }
+        }
+        return largest;
+    }
+
+    std::string LatencyHistogram::summary() const {
+        std::ostringstream out;
+        out << "n=" << samples
+            << " p50=" << percentile(0.50) << "us"
+            << " p90=" << percentile(0.90) << "us"
+            << " p99=" << percentile(0.99) << "us"
+            << " p99.9=" << percentile(0.999) << "us"
+            << " max=" << largest << "us";
+        return out.str();
+    }
+
+    uint64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
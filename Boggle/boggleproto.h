@@ -0,0 +1,156 @@
+/**
+ * Wire protocol shared by the boggled solver daemon and its clients.
+ *
+ * Every message is a frame: a 4 byte little-endian payload length
+ * followed by the payload. Request payloads start with a one byte
+ * opcode, response payloads with a one byte status. Strings (dice,
+ * words) are sent as a one byte length followed by the characters.
+ * Requests on a connection are answered strictly in order, so clients
+ * may pipeline as many requests as they like.
+ */
+
+#ifndef BOGGLEPROTO_H
+#define BOGGLEPROTO_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/* Request opcodes */
+enum BoggleOp {
+    OP_PING = 0,            // -> (empty)
+    OP_SET_BOARD = 1,       // u16 rows, u16 cols, rows*cols dice -> (empty)
+    OP_SOLVE = 2,           // u16 min_len -> u32 n, n words
+    OP_SET_BOARD_SOLVE = 3, // u16 min_len, then as OP_SET_BOARD -> as OP_SOLVE
+    OP_IS_WORD = 4,         // word -> u8 in_lexicon
+    OP_PATH = 5,            // word -> u16 n, n x u16 board index
+    OP_STATS = 6,           // -> u32 len, human readable report
+
+    /* Served by bogglebatch -W workers rather than boggled:
+     * u32 shard, u8 attempt, u8 flags, u16 min_len, u16 top_k,
+     * u64 first board number, u16 rows, u16 cols, u32 n, n boards of
+     * rows*cols dice -> u32 shard, u64 lexicon fingerprint, u64 boards,
+     * u64 words, u64 points, u64 solve usec, u32 len, the boards' output */
+    OP_SOLVE_SHARD = 7
+};
+
+/* Response status codes */
+enum BoggleStatus {
+    STATUS_OK = 0,
+    STATUS_BAD_REQUEST = 1,
+    STATUS_NO_BOARD = 2
+};
+
+/* Largest frame either side will accept */
+static const uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Builds one frame. The length prefix is filled in by finish().
+ */
+class FrameWriter {
+  public:
+    FrameWriter();
+
+    void putU8(uint8_t v);
+    void putU16(uint16_t v);
+    void putU32(uint32_t v);
+    void putU64(uint64_t v);
+
+    /* Strings longer than 255 characters are truncated */
+    void putString(const std::string &s);
+
+    /* Long form used for reports: u32 length then the characters */
+    void putText(const std::string &s);
+
+    /**
+     * Writes the length prefix and returns the complete frame. The
+     * writer is reset and can be reused for the next frame.
+     */
+    std::string finish();
+
+  private:
+    std::string buf;
+};
+
+/**
+ * Bounds-checked reader over one frame payload. Every getter returns
+ * false instead of reading past the end of the payload.
+ */
+class FrameReader {
+  public:
+    FrameReader(const char *data, size_t size);
+
+    bool getU8(uint8_t *v);
+    bool getU16(uint16_t *v);
+    bool getU32(uint32_t *v);
+    bool getU64(uint64_t *v);
+    bool getString(std::string *s);
+    bool getText(std::string *s);
+
+    /* True once every byte of the payload has been consumed */
+    bool atEnd() const;
+
+  private:
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+};
+
+/**
+ * If buf starts with a complete frame, stores its payload size in
+ * *payload_size and returns true. Returns false if more bytes are
+ * needed. Sets *bad when the announced length exceeds MAX_FRAME_SIZE.
+ */
+bool frameComplete(const std::string &buf, uint32_t *payload_size, bool *bad);
+
+/* Blocking helpers that retry short reads/writes and EINTR */
+bool readFull(int fd, void *data, size_t size);
+bool writeFull(int fd, const void *data, size_t size);
+
+/**
+ * Reads one whole frame from a blocking socket into *payload.
+ * Returns false on EOF, I/O error or an oversized frame.
+ */
+bool readFrame(int fd, std::string *payload);
+
+/**
+ * Socket addresses are either "unix:/path/to/socket" or "tcp:PORT";
+ * TCP sockets are bound to / connect to the loopback interface only.
+ * Both return a file descriptor, or -1 with a message on stderr.
+ */
+int listenOn(const std::string &address);
+int connectTo(const std::string &address);
+
+/**
+ * Log-linear latency histogram in microseconds, accurate to about 3%.
+ * Not thread safe; keep one per thread and merge() them for reports.
+ */
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    void record(uint64_t usec);
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const;
+    uint64_t max() const;
+
+    /* Value below which the given fraction (0..1) of samples fall */
+    uint64_t percentile(double fraction) const;
+
+    /* "n=... p50=...us p90=... p99=... p99.9=... max=..." */
+    std::string summary() const;
+
+  private:
+    static unsigned bucketOf(uint64_t usec);
+    static uint64_t bucketValue(unsigned bucket);
+
+    std::vector<uint64_t> buckets;
+    uint64_t samples;
+    uint64_t largest;
+};
+
+/* Monotonic clock in microseconds */
+uint64_t nowMicros();
+
+#endif // BOGGLEPROTO_H
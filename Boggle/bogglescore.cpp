@@ -0,0 +1,57 @@
+#include "bogglescore.h"
+
+    ScoringRules ScoringRules::official() {
+        static const unsigned POINTS[] = { 0, 0, 0, 1, 1, 2, 3, 5, 11 };
+        ScoringRules rules;
+        rules.points.assign(POINTS, POINTS + sizeof(POINTS) / sizeof(POINTS[0]));
+        rules.minimum_length = 3;
+        rules.qu_counts_two = true;
+        return rules;
+    }
+
+    /**
+     * Walks the whole trie once, measuring each word as it goes: every
+     * letter adds one to the length except a u after a q when qu counts
+     * as a single letter.
+     */
+    ScoreTable::ScoreTable(const FlatLexicon &lexicon, const ScoringRules &rules)
+            : score_rules(rules), lengths(lexicon.wordCount(), 0),
+              word_points(lexicon.wordCount(), 0) {
+        struct Visit {
+            const FlatLexNode *node;
+            unsigned length;
+            bool after_q;
+        };
+        std::vector<Visit> stack;
+        Visit root = { lexicon.getRoot(), 0, false };
+        stack.push_back(root);
+        while(!stack.empty()) {
+            Visit v = stack.back();
+            stack.pop_back();
+            if(v.node->word_id >= 0) {
+                unsigned length = std::min(v.length, 255u);
+                lengths[v.node->word_id] = (uint8_t)length;
+                word_points[v.node->word_id] = (uint16_t)std::min(rules.pointsFor(length), 65535u);
+            }
+            const FlatLexNode *child = lexicon.firstChild(v.node);
+            for(unsigned k = 0; k < 26; k++) {
+                if(!((v.node->child_mask >> k) & 1))
+                    continue;
+                bool merged = v.after_q && k == 'u' - 'a' && !rules.qu_counts_two;
+                Visit next = { child++, v.length + (merged ? 0 : 1), k == 'q' - 'a' };
+                stack.push_back(next);
+            }
+        }
+    }
+
+    void TopScorer::finish() {
+        std::sort_heap(heap.begin(), heap.end(), Weaker());
+        result->top.resize(heap.size());
+        for(size_t i = 0; i < heap.size(); i++) {
+            ScoredWord &out = result->top[i];
+            out.word.swap(heap[i].word);
+            out.length = table.length(heap[i].word_id);
+            out.points = table.points(heap[i].word_id);
+        }
+        heap.clear();
+    }
@@ -0,0 +1,243 @@
+#ifndef BOGGLESCORE_H
+#define BOGGLESCORE_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flatlexicon.h"
+
+/**
+ * How words are scored. A word's length is its number of letters, with
+ * "qu" counting as one letter unless qu_counts_two is set; words shorter
+ * than minimum_length do not count at all.
+ */
+struct ScoringRules {
+    /* points[n] is the score of a word of length n; longer words than
+     * the table covers score its last entry */
+    std::vector<unsigned> points;
+    unsigned minimum_length;
+    bool qu_counts_two;
+
+    /* The official rules: 3-4 letters 1 point, 5 2, 6 3, 7 5, 8+ 11,
+     * with Qu counting as two letters */
+    static ScoringRules official();
+
+    unsigned pointsFor(unsigned length) const {
+        if(points.empty())
+            return 0;
+        return length < points.size() ? points[length] : points.back();
+    }
+
+    bool operator==(const ScoringRules &other) const {
+        return points == other.points && minimum_length == other.minimum_length
+            && qu_counts_two == other.qu_counts_two;
+    }
+};
+
+/* Which words a top-K solve keeps */
+enum ScoreOrder {
+    SCORE_BY_POINTS,    // highest scoring, longest first among equals
+    SCORE_BY_LENGTH     // longest, highest scoring first among equals
+};
+
+/* A word kept by a top-K solve */
+struct ScoredWord {
+    std::string word;
+    unsigned length;
+    unsigned points;
+};
+
+/* What a scoring solve found */
+struct ScoreResult {
+    /* Distinct words that count under the rules, and their points */
+    uint64_t words;
+    uint64_t total;
+
+    /* by_length[n] is the number of those words of length n */
+    std::vector<uint64_t> by_length;
+
+    /* The best words in the requested order, best first; empty for a
+     * count-only solve */
+    std::vector<ScoredWord> top;
+};
+
+/**
+ * Length and points of every word of a lexicon under one set of rules,
+ * indexed by word id, so that a search can score the words it finds
+ * without looking at their letters.
+ */
+class ScoreTable {
+  public:
+    ScoreTable(const FlatLexicon &lexicon, const ScoringRules &rules);
+
+    const ScoringRules &rules() const { return score_rules; }
+
+    /* Whether the word counts at all, i.e. is long enough */
+    bool counts(int32_t word_id) const { return lengths[word_id] >= score_rules.minimum_length; }
+
+    unsigned length(int32_t word_id) const { return lengths[word_id]; }
+    unsigned points(int32_t word_id) const { return word_points[word_id]; }
+
+  private:
+    ScoringRules score_rules;
+    std::vector<uint8_t> lengths;
+    std::vector<uint16_t> word_points;
+};
+
+/**
+ * Marks word ids as seen during one search. Starting a new search only
+ * bumps a generation number, so nothing proportional to the lexicon is
+ * cleared per board.
+ */
+class WordStamps {
+  public:
+    WordStamps() : generation(0) {}
+
+    /* Forgets every mark; words must be below word_count */
+    void reset(uint32_t word_count) {
+        if(stamps.size() != word_count || ++generation == 0) {
+            stamps.assign(word_count, 0);
+            generation = 1;
+        }
+    }
+
+    /* Marks the word; returns false if it was already marked */
+    bool mark(int32_t word_id) {
+        if(stamps[word_id] == generation)
+            return false;
+        stamps[word_id] = generation;
+        return true;
+    }
+
+  private:
+    std::vector<uint32_t> stamps;
+    uint32_t generation;
+};
+
+/**
+ * The blank dice on a path spelling a word, as (board position, letter
+ * it stands for) pairs in path order.
+ */
+typedef std::vector<std::pair<int, char> > WildcardLetters;
+
+/**
+ * Search sink that totals the score of every distinct word found,
+ * without building the words. Sinks are handed to the board searches,
+ * which call enters() for every node they step to, skipping its
+ * subtrie if it returns false, and wants() for every word node they
+ * reach, calling add() when it returns true.
+ */
+class ScoreCounter {
+  public:
+    /* The search only needs to spell out words for sinks that keep
+     * some of them, and only hands over the dice a word was traced on,
+     * or the letters its blank dice stand for, to sinks that look at
+     * them */
+    static const bool KEEPS_WORD = false;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    ScoreCounter(const ScoreTable &table, WordStamps &seen, ScoreResult *result)
+            : table(table), seen(seen), result(result) {
+        result->words = 0;
+        result->total = 0;
+        result->by_length.clear();
+        result->top.clear();
+    }
+
+    bool enters(const FlatLexNode *) const { return true; }
+
+    /* Called before add() with a bit set for each die on the path that
+     * reached the word, for every path, when KEEPS_PATH is set */
+    void path(const FlatLexNode *, uint64_t) {}
+
+    /* Called before add() with the blank dice on the path that reached
+     * the word, for every path, when KEEPS_BLANKS is set */
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+
+    bool wants(const FlatLexNode *node, size_t) const {
+        return table.counts(node->word_id);
+    }
+
+    /* Returns false if the word was already counted */
+    bool add(const FlatLexNode *node, const std::string &) {
+        if(!seen.mark(node->word_id))
+            return false;
+        unsigned length = table.length(node->word_id);
+        result->words++;
+        result->total += table.points(node->word_id);
+        if(length >= result->by_length.size())
+            result->by_length.resize(length + 1, 0);
+        result->by_length[length]++;
+        return true;
+    }
+
+  protected:
+    const ScoreTable &table;
+    WordStamps &seen;
+    ScoreResult *result;
+};
+
+/**
+ * ScoreCounter that also keeps the best k words in a bounded heap. A
+ * word's string is only copied when it makes it into the heap.
+ */
+class TopScorer : public ScoreCounter {
+  public:
+    static const bool KEEPS_WORD = true;
+
+    TopScorer(const ScoreTable &table, WordStamps &seen, ScoreResult *result,
+            unsigned k, ScoreOrder order)
+        : ScoreCounter(table, seen, result), k(k), order(order) {}
+
+    bool add(const FlatLexNode *node, const std::string &word) {
+        if(!ScoreCounter::add(node, word))
+            return false;
+        if(k == 0)
+            return true;
+        uint64_t rank = rankOf(node->word_id);
+        if(heap.size() == k) {
+            if(rank <= heap.front().rank)
+                return true;
+            std::pop_heap(heap.begin(), heap.end(), Weaker());
+            heap.pop_back();
+        }
+        Entry entry = { rank, node->word_id, word };
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), Weaker());
+        return true;
+    }
+
+    /* Moves the kept words into the result, best first */
+    void finish();
+
+  private:
+    struct Entry {
+        uint64_t rank;
+        int32_t word_id;
+        std::string word;
+    };
+
+    /* Heap order putting the weakest kept word in front */
+    struct Weaker {
+        bool operator()(const Entry &a, const Entry &b) const { return a.rank > b.rank; }
+    };
+
+    /* Orders words by the primary key, then the secondary one, then
+     * alphabetically (lower word ids rank higher) */
+    uint64_t rankOf(int32_t word_id) const {
+        uint64_t length = table.length(word_id), points = table.points(word_id);
+        uint64_t primary = order == SCORE_BY_POINTS ? points : length;
+        uint64_t secondary = order == SCORE_BY_POINTS ? length : points;
+        return primary << 48 | secondary << 32 | (0xffffffffu - (uint32_t)word_id);
+    }
+
+    unsigned k;
+    ScoreOrder order;
+    std::vector<Entry> heap;
+};
+
+#endif // BOGGLESCORE_H
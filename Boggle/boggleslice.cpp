@@ -0,0 +1,378 @@
+#include "boggleslice.h"
+#include "boggleutil.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+static const unsigned LANES = SlicedSolver::MAX_BOARDS;
+
+/* Below this many boards still on a trie branch, the boards are
+ * followed one at a time rather than all 64 lanes at once */
+static const unsigned SPARSE_LANES = 12;
+
+    /**
+     * The lexicon walk behind SlicedSolver. It leaves, for every word
+     * found, the mask of boards that have it in found, and lists those
+     * words in touched (with their text if asked to spell them).
+     */
+    class SliceSearch {
+      public:
+        explicit SliceSearch(const FlatLexicon &lexicon)
+            : lexicon(lexicon), found(lexicon.wordCount(), 0) {}
+        virtual ~SliceSearch() {}
+
+        virtual void run(const std::vector<std::vector<std::string> > &boards, size_t count,
+                uint64_t accepted, unsigned min_length, bool spell) = 0;
+
+        const FlatLexicon &lexicon;
+        std::vector<uint64_t> found;
+        std::vector<std::pair<int32_t, std::string> > touched;
+    };
+
+    /**
+     * SliceSearch with Mask bitboards, one bit per cell. Lane b of every
+     * array of LANES masks belongs to board b.
+     */
+    template <class Mask>
+    class SliceSearchFor : public SliceSearch {
+      public:
+        SliceSearchFor(const FlatLexicon &lexicon, unsigned rows, unsigned cols)
+                : SliceSearch(lexicon), cols(cols), cells(rows * cols), neighbours(rows * cols) {
+            all = (Mask)~(Mask)0 >> (8 * sizeof(Mask) - cells);
+            not_first = not_last = all;
+            for(unsigned r = 0; r < rows; r++) {
+                not_first &= (Mask)~((Mask)1 << (r * cols));
+                not_last &= (Mask)~((Mask)1 << (r * cols + cols - 1));
+            }
+            for(unsigned i = 0; i < cells; i++) {
+                neighbours[i] = around((Mask)((Mask)1 << i));
+            }
+        }
+
+        void run(const std::vector<std::vector<std::string> > &boards, size_t count,
+                uint64_t accepted, unsigned min_length, bool spell) {
+            // letter planes: which cells of each board show each face
+            face_text.resize(26);
+            for(unsigned k = 0; k < 26; k++) {
+                face_text[k].assign(1, (char)('a' + k));
+            }
+            planes.assign(26 * LANES, 0);
+            std::fill(board_letters, board_letters + LANES, 0);
+            std::string text;
+            for(size_t b = 0; b < count; b++) {
+                if(!((accepted >> b) & 1))
+                    continue;
+                for(unsigned i = 0; i < cells; i++) {
+                    text.clear();
+                    for(size_t k = 0; k < boards[b][i].size(); k++) {
+                        text += (char)tolower((unsigned char)boards[b][i][k]);
+                    }
+                    if(text.empty())
+                        continue;
+                    if(isWildcardDie(text)) {
+                        // a blank shows every letter
+                        board_letters[b] |= (1u << 26) - 1;
+                        for(unsigned k = 0; k < 26; k++) {
+                            planes[k * LANES + b] |= (Mask)((Mask)1 << i);
+                        }
+                        continue;
+                    }
+                    unsigned face = (unsigned char)(text[0] - 'a');
+                    if(text.size() == 1 && face < 26) {
+                        board_letters[b] |= 1u << face;
+                    }
+                    else {
+                        face = std::find(face_text.begin(), face_text.end(), text) - face_text.begin();
+                        if(face == face_text.size()) {
+                            face_text.push_back(text);
+                            planes.resize(planes.size() + LANES, 0);
+                        }
+                    }
+                    planes[face * LANES + b] |= (Mask)((Mask)1 << i);
+                }
+            }
+
+            this->min_length = min_length;
+            this->spell = spell;
+            reach.assign(16 * LANES, 0);
+            // a rejected board's lane stays empty, so it finds nothing
+            for(size_t b = 0; b < count; b++) {
+                if((accepted >> b) & 1)
+                    reach[b] = all;
+            }
+            word.clear();
+            extend(lexicon.getRoot(), 0, 0);
+        }
+
+      private:
+        /* Cells next to a cell of m */
+        Mask around(Mask m) const {
+            Mask h = (Mask)((Mask)(m << 1) & not_first) | (Mask)((m >> 1) & not_last);
+            Mask v = m | h;
+            return (Mask)(h | (Mask)(v << cols) | (v >> cols)) & all;
+        }
+
+        Mask *reachAt(unsigned depth) { return &reach[depth * LANES]; }
+        const Mask *reachAt(unsigned depth) const { return &reach[depth * LANES]; }
+
+        /**
+         * The search has stepped through depth faces spelling the
+         * prefix of node, which is length letters long, and
+         * reachAt(depth) says where each board can be after them.
+         * Confirms the word ending at node on the boards that may have
+         * it, then steps into every child some board can continue to.
+         */
+        void extend(const FlatLexNode *node, unsigned depth, unsigned length) {
+            const Mask *here = reachAt(depth);
+            if(depth > 0) {
+                uint64_t lanes = 0;
+                for(unsigned b = 0; b < LANES; b++) {
+                    lanes |= (uint64_t)(here[b] != 0) << b;
+                }
+                if((unsigned)__builtin_popcountll(lanes) <= SPARSE_LANES) {
+                    for(; lanes != 0; lanes &= lanes - 1) {
+                        follow(__builtin_ctzll(lanes), node, depth, length);
+                    }
+                    return;
+                }
+                if(node->word_id >= 0 && length >= min_length) {
+                    for(uint64_t m = lanes; m != 0; m &= m - 1) {
+                        confirm(__builtin_ctzll(m), node, depth);
+                    }
+                }
+            }
+            if(node->child_mask == 0)
+                return;
+
+            // where each board may step next: next to where it is (the
+            // first face may go anywhere)
+            Mask spread[LANES];
+            if(depth == 0) {
+                std::copy(here, here + LANES, spread);
+            }
+            else {
+                for(unsigned b = 0; b < LANES; b++) {
+                    spread[b] = around(here[b]);
+                }
+            }
+
+            const FlatLexNode *child = lexicon.firstChild(node);
+            for(uint32_t letters = node->child_mask; letters != 0; letters &= letters - 1) {
+                step(child++, __builtin_ctz(letters), depth, length, spread);
+            }
+            for(unsigned face = 26; face < face_text.size(); face++) {
+                const FlatLexNode *end = node;
+                for(size_t k = 0; k < face_text[face].size() && end != NULL; k++) {
+                    end = lexicon.getChild(end, face_text[face][k]);
+                }
+                if(end != NULL)
+                    step(end, face, depth, length, spread);
+            }
+        }
+
+        /* Steps from depth to depth + 1 through face, reaching child */
+        void step(const FlatLexNode *child, unsigned face, unsigned depth, unsigned length,
+                const Mask *spread) {
+            reserve(depth + 1);
+            Mask *next = reachAt(depth + 1);
+            const Mask *plane = &planes[face * LANES];
+            Mask any = 0;
+            for(unsigned b = 0; b < LANES; b++) {
+                next[b] = spread[b] & plane[b];
+                any |= next[b];
+            }
+            if(any == 0)
+                return;
+
+            size_t old = word.size();
+            if(spell)
+                word.append(face_text[face]);
+            extend(child, depth + 1, length + face_text[face].size());
+            if(spell)
+                word.resize(old);
+        }
+
+        /**
+         * extend for a single board, once few boards are left on this
+         * branch: the same steps on one lane, skipping letters the
+         * board does not show at all.
+         */
+        void follow(unsigned board, const FlatLexNode *node, unsigned depth, unsigned length) {
+            if(node->word_id >= 0 && length >= min_length)
+                confirm(board, node, depth);
+            if(node->child_mask == 0)
+                return;
+
+            Mask spread = around(reachAt(depth)[board]);
+            reserve(depth + 1);
+            for(uint32_t letters = node->child_mask & board_letters[board]; letters != 0;
+                    letters &= letters - 1) {
+                unsigned k = __builtin_ctz(letters);
+                Mask next = spread & planes[k * LANES + board];
+                if(next == 0)
+                    continue;
+                reachAt(depth + 1)[board] = next;
+                const FlatLexNode *child = lexicon.firstChild(node)
+                    + __builtin_popcount(node->child_mask & ((1u << k) - 1));
+                if(spell)
+                    word.push_back((char)('a' + k));
+                follow(board, child, depth + 1, length + 1);
+                if(spell)
+                    word.resize(word.size() - 1);
+            }
+            for(unsigned face = 26; face < face_text.size(); face++) {
+                Mask next = spread & planes[face * LANES + board];
+                if(next == 0)
+                    continue;
+                const FlatLexNode *end = node;
+                for(size_t k = 0; k < face_text[face].size() && end != NULL; k++) {
+                    end = lexicon.getChild(end, face_text[face][k]);
+                }
+                if(end == NULL)
+                    continue;
+                reachAt(depth + 1)[board] = next;
+                size_t old = word.size();
+                if(spell)
+                    word.append(face_text[face]);
+                follow(board, end, depth + 1, length + face_text[face].size());
+                if(spell)
+                    word.resize(old);
+            }
+        }
+
+        /* Makes room for the reach masks of depth */
+        void reserve(unsigned depth) {
+            if(reach.size() < (depth + 1) * LANES)
+                reach.resize(2 * (depth + 1) * LANES);
+        }
+
+        /* Records the word at node on board if it has a real path there */
+        void confirm(unsigned board, const FlatLexNode *node, unsigned depth) {
+            uint64_t &mask = found[node->word_id];
+            uint64_t bit = (uint64_t)1 << board;
+            if((mask & bit) || !verify(board, depth))
+                return;
+            if(mask == 0)
+                touched.push_back(std::make_pair(node->word_id, word));
+            mask |= bit;
+        }
+
+        /* Whether board has a path using every die once for the depth
+         * faces stepped through; step pos may only use cells in
+         * reachAt(pos + 1), which rules out most dead ends at once */
+        bool verify(unsigned board, unsigned depth) const {
+            for(Mask m = reachAt(1)[board]; m != 0; m &= m - 1) {
+                unsigned i = __builtin_ctzll(m);
+                if(verifyFrom(board, i, 1, depth, (Mask)((Mask)1 << i)))
+                    return true;
+            }
+            return false;
+        }
+
+        bool verifyFrom(unsigned board, unsigned cell, unsigned pos, unsigned depth,
+                Mask visited) const {
+            if(pos == depth)
+                return true;
+            Mask options = neighbours[cell] & reachAt(pos + 1)[board] & (Mask)~visited;
+            for(; options != 0; options &= options - 1) {
+                unsigned j = __builtin_ctzll(options);
+                if(verifyFrom(board, j, pos + 1, depth, (Mask)(visited | (Mask)((Mask)1 << j))))
+                    return true;
+            }
+            return false;
+        }
+
+        unsigned cols;
+        unsigned cells;
+        Mask all, not_first, not_last;
+        std::vector<Mask> neighbours;
+
+        /* Faces 0-25 are the letters a-z; the batch's longer dice are
+         * numbered after them. planes[face * LANES + b] has the cells
+         * of board b that show face. */
+        std::vector<std::string> face_text;
+        std::vector<Mask> planes;
+
+        /* Bit k is set if board b shows letter k anywhere */
+        uint32_t board_letters[LANES];
+
+        /* State of the current run: reach masks per depth, and the text
+         * of the trie path being walked */
+        unsigned min_length;
+        bool spell;
+        std::vector<Mask> reach;
+        std::string word;
+    };
+
+    SlicedSolver::SlicedSolver(const FlatLexicon &lexicon, unsigned rows, unsigned cols)
+            : cells(rows * cols) {
+        if(cells > 0 && cells <= 16)
+            search.reset(new SliceSearchFor<uint16_t>(lexicon, rows, cols));
+        else if(cells > 0 && cells <= 32)
+            search.reset(new SliceSearchFor<uint32_t>(lexicon, rows, cols));
+        else if(cells > 0 && cells <= 64)
+            search.reset(new SliceSearchFor<uint64_t>(lexicon, rows, cols));
+    }
+
+    SlicedSolver::~SlicedSolver() {}
+
+    /* The mask of the first count lanes */
+    static uint64_t lanesBelow(size_t count) {
+        return count == LANES ? ~(uint64_t)0 : ((uint64_t)1 << count) - 1;
+    }
+
+    uint64_t SlicedSolver::acceptBoards(const std::vector<std::vector<std::string> > &boards,
+            size_t count) const {
+        uint64_t accepted = 0;
+        for(size_t b = 0; b < count; b++) {
+            if(boards[b].size() == cells)
+                accepted |= (uint64_t)1 << b;
+        }
+        return accepted;
+    }
+
+    bool SlicedSolver::solve(const std::vector<std::vector<std::string> > &boards,
+            unsigned minimum_word_length, std::vector<std::set<std::string> > *words) {
+        size_t count = std::min<size_t>(boards.size(), MAX_BOARDS);
+        words->assign(count, std::set<std::string>());
+        if(!search || count == 0)
+            return count == 0;
+
+        uint64_t accepted = acceptBoards(boards, count);
+        search->run(boards, count, accepted, minimum_word_length, true);
+        for(size_t t = 0; t < search->touched.size(); t++) {
+            uint64_t &mask = search->found[search->touched[t].first];
+            for(uint64_t m = mask; m != 0; m &= m - 1) {
+                (*words)[__builtin_ctzll(m)].insert(search->touched[t].second);
+            }
+            mask = 0;
+        }
+        search->touched.clear();
+        return accepted == lanesBelow(count);
+    }
+
+    bool SlicedSolver::solve(const std::vector<std::vector<std::string> > &boards,
+            unsigned minimum_word_length, std::vector<std::vector<int32_t> > *word_ids) {
+        size_t count = std::min<size_t>(boards.size(), MAX_BOARDS);
+        word_ids->assign(count, std::vector<int32_t>());
+        if(!search || count == 0)
+            return count == 0;
+
+        uint64_t accepted = acceptBoards(boards, count);
+        search->run(boards, count, accepted, minimum_word_length, false);
+        for(size_t t = 0; t < search->touched.size(); t++) {
+            uint64_t &mask = search->found[search->touched[t].first];
+            for(uint64_t m = mask; m != 0; m &= m - 1) {
+                (*word_ids)[__builtin_ctzll(m)].push_back(search->touched[t].first);
+            }
+            mask = 0;
+        }
+        search->touched.clear();
+        // multi-letter faces are tried after the letters, so words
+        // through them can come out of order
+        for(size_t b = 0; b < count; b++) {
+            std::sort((*word_ids)[b].begin(), (*word_ids)[b].end());
+        }
+        return accepted == lanesBelow(count);
+    }
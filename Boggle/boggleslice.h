@@ -0,0 +1,78 @@
+#ifndef BOGGLESLICE_H
+#define BOGGLESLICE_H
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "flatlexicon.h"
+
+class SliceSearch;
+
+/**
+ * Solves up to 64 boards of the same size in one walk of the lexicon.
+ *
+ * Every board is a lane of the search. For each face the batch shows
+ * (a letter, or a die like "qu") a board has a letter plane: a bitboard
+ * with a bit per cell showing that face. The trie is walked once for
+ * the whole batch, and for the current trie node each board keeps a
+ * bitboard of the cells where some walk of adjacent cells spelling the
+ * node's prefix can end. Stepping to a child dilates every board's
+ * bitboard to the neighbouring cells with a few shifts and ANDs it with
+ * the child's letter plane (a blank die is on every letter's plane);
+ * the same operations on all 64 lanes are what the compiler turns into
+ * vector instructions. A branch of the trie is dropped as soon as it is
+ * empty on every board.
+ *
+ * Those walks may use a die twice, so a word ending at a node is only
+ * a candidate on the boards whose bitboards are not empty; each one is
+ * confirmed by a search for a real path on that board, which the
+ * bitboards of the prefixes keep short.
+ */
+class SlicedSolver {
+  public:
+    static const unsigned MAX_BOARDS = 64;
+
+    /**
+     * A solver for rows x cols boards (at most 64 cells) over lexicon,
+     * which must outlive the solver.
+     */
+    SlicedSolver(const FlatLexicon &lexicon, unsigned rows, unsigned cols);
+    ~SlicedSolver();
+
+    /**
+     * Finds the words of at least minimum_word_length letters on each
+     * board, exactly as BogglePlayer::getAllValidWords would. boards
+     * holds at most MAX_BOARDS boards of rows * cols nonempty dice in
+     * row-major order, in any case; words receives one set per board.
+     * A board with any other number of dice gets no words, and false is
+     * returned; reporting it is up to the caller.
+     */
+    bool solve(const std::vector<std::vector<std::string> > &boards,
+            unsigned minimum_word_length, std::vector<std::set<std::string> > *words);
+
+    /**
+     * Same, but gives the word ids (FlatLexNode::word_id) found on each
+     * board in increasing order, without building any strings.
+     */
+    bool solve(const std::vector<std::vector<std::string> > &boards,
+            unsigned minimum_word_length, std::vector<std::vector<int32_t> > *word_ids);
+
+  private:
+    SlicedSolver(const SlicedSolver &);
+    SlicedSolver &operator=(const SlicedSolver &);
+
+    /* The mask of boards with the right number of dice */
+    uint64_t acceptBoards(const std::vector<std::vector<std::string> > &boards,
+            size_t count) const;
+
+    unsigned cells;
+
+    /* The search for this board size, with bitboards just wide enough
+     * for its cells; NULL for boards of more than 64 cells */
+    std::unique_ptr<SliceSearch> search;
+};
+
+#endif // BOGGLESLICE_H
@@ -0,0 +1,200 @@
+#include "bogglestream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char STREAM_MAGIC[8] = { 'B', 'O', 'G', 'B', 'R', 'D', 'S', '1' };
+static const size_t STREAM_HEADER_BYTES = 20;
+static const size_t MAX_TOKENS = 255;
+
+static uint16_t readU16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t readU32(const unsigned char *p) {
+    return (uint32_t)readU16(p) | (uint32_t)readU16(p + 2) << 16;
+}
+
+static void writeU16(std::string *out, uint16_t v) {
+    out->push_back((char)(v & 0xff));
+    out->push_back((char)(v >> 8));
+}
+
+static void writeU32(std::string *out, uint32_t v) {
+    writeU16(out, (uint16_t)(v & 0xffff));
+    writeU16(out, (uint16_t)(v >> 16));
+}
+
+static std::string lowered(const std::string &text) {
+    std::string result(text);
+    for(size_t i = 0; i < result.size(); i++)
+        result[i] = (char)tolower((unsigned char)result[i]);
+    return result;
+}
+
+    std::vector<std::string> standardAlphabet() {
+        std::vector<std::string> alphabet;
+        for(char c = 'a'; c <= 'z'; c++)
+            alphabet.push_back(std::string(1, c));
+        alphabet.push_back("qu");
+        alphabet.push_back("?");
+        return alphabet;
+    }
+
+    bool readTextBoard(std::istream &in, unsigned *rows, unsigned *cols,
+            std::vector<std::string> *dice) {
+        if(!(in >> *rows >> *cols))
+            return false;
+        dice->resize(*rows * *cols);
+        for(size_t i = 0; i < dice->size(); i++) {
+            if(!(in >> (*dice)[i])) {
+                std::cerr << "Board truncated after " << i << " dice" << std::endl;
+                return false;
+            }
+        }
+        return *rows > 0 && *cols > 0;
+    }
+
+    void writeTextBoard(std::ostream &out, unsigned rows, unsigned cols,
+            const std::vector<std::string> &dice) {
+        out << rows << "\n" << cols << "\n";
+        for(size_t i = 0; i < dice.size(); i++)
+            out << dice[i] << "\n";
+    }
+
+    BoardStreamWriter::BoardStreamWriter(std::ostream &out, unsigned rows, unsigned cols,
+            const std::vector<std::string> &alphabet)
+            : out(out), valid(rows > 0 && cols > 0 && rows <= 0xffff && cols <= 0xffff),
+              board_rows(rows), board_cols(cols), record(valid ? rows * cols : 0) {
+        if(!valid)
+            return;
+        for(size_t i = 0; i < alphabet.size() && i < MAX_TOKENS; i++)
+            this->alphabet.push_back(lowered(alphabet[i]).substr(0, 255));
+
+        std::string header(STREAM_MAGIC, sizeof(STREAM_MAGIC));
+        writeU16(&header, (uint16_t)rows);
+        writeU16(&header, (uint16_t)cols);
+        writeU16(&header, (uint16_t)this->alphabet.size());
+        writeU16(&header, 0);
+        size_t table = 0;
+        for(size_t i = 0; i < this->alphabet.size(); i++)
+            table += 1 + this->alphabet[i].size();
+        writeU32(&header, (uint32_t)((STREAM_HEADER_BYTES + table + 7) / 8 * 8));
+        for(size_t i = 0; i < this->alphabet.size(); i++) {
+            header.push_back((char)this->alphabet[i].size());
+            header += this->alphabet[i];
+        }
+        header.resize((header.size() + 7) / 8 * 8, '\0');
+        out.write(header.data(), header.size());
+    }
+
+    bool BoardStreamWriter::add(const std::vector<std::string> &dice) {
+        if(!valid || dice.size() != record.size())
+            return false;
+        for(size_t i = 0; i < dice.size(); i++) {
+            std::vector<std::string>::const_iterator token =
+                std::find(alphabet.begin(), alphabet.end(), lowered(dice[i]));
+            if(token == alphabet.end())
+                return false;
+            record[i] = (char)(token - alphabet.begin());
+        }
+        out.write(&record[0], record.size());
+        return out.good();
+    }
+
+    BoardStreamReader::BoardStreamReader()
+        : mapped(NULL), mapped_size(0), records(NULL), count(0), tail(0), board_rows(0),
+          board_cols(0) {}
+
+    BoardStreamReader::~BoardStreamReader() {
+        close();
+    }
+
+    void BoardStreamReader::close() {
+        if(mapped != NULL)
+            munmap(mapped, mapped_size);
+        mapped = NULL;
+        mapped_size = 0;
+        records = NULL;
+        count = 0;
+        tail = 0;
+        board_rows = board_cols = 0;
+        tokens.clear();
+    }
+
+    bool BoardStreamReader::open(const std::string &filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < STREAM_HEADER_BYTES) {
+            ::close(fd);
+            return false;
+        }
+        void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED)
+            return false;
+        mapped = (unsigned char *)base;
+        mapped_size = st.st_size;
+
+        unsigned rows = readU16(mapped + 8), cols = readU16(mapped + 10);
+        size_t token_count = readU16(mapped + 12);
+        size_t first = readU32(mapped + 16);
+        size_t record_size = (size_t)rows * cols;
+        bool valid = memcmp(mapped, STREAM_MAGIC, sizeof(STREAM_MAGIC)) == 0 &&
+            record_size > 0 && token_count <= MAX_TOKENS && first <= mapped_size;
+        size_t at = STREAM_HEADER_BYTES;
+        for(size_t i = 0; valid && i < token_count; i++) {
+            valid = at < first && at + 1 + mapped[at] <= first;
+            if(valid) {
+                tokens.push_back(std::string((const char *)mapped + at + 1, mapped[at]));
+                at += 1 + mapped[at];
+            }
+        }
+        if(!valid) {
+            close();
+            return false;
+        }
+        size_t boards = (mapped_size - first) / record_size;
+
+        // a bad token id would become a die matching nothing sensible,
+        // so every record is checked once here rather than per board
+        records = mapped + first;
+        for(size_t i = 0; i < boards * record_size; i++) {
+            if(records[i] >= token_count) {
+                close();
+                return false;
+            }
+        }
+        board_rows = rows;
+        board_cols = cols;
+        count = boards;
+        tail = mapped_size - first - boards * record_size;
+        return true;
+    }
+
+    void BoardStreamReader::board(size_t i, std::vector<std::string> *dice) const {
+        const uint8_t *ids = record(i);
+        dice->resize(board_rows * board_cols);
+        for(size_t k = 0; k < dice->size(); k++)
+            (*dice)[k] = tokens[ids[k]];
+    }
+
+    bool BoardStreamReader::sniff(const std::string &filename) {
+        char magic[sizeof(STREAM_MAGIC)];
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        bool matches = read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) &&
+            memcmp(magic, STREAM_MAGIC, sizeof(magic)) == 0;
+        ::close(fd);
+        return matches;
+    }
@@ -0,0 +1,131 @@
+#ifndef BOGGLESTREAM_H
+#define BOGGLESTREAM_H
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Board streams: a compact binary format for corpora of boards of one
+ * size, read in place through mmap.
+ *
+ * A stream starts with a header, all integers little-endian:
+ *
+ *   0   8 bytes   magic "BOGBRDS1"
+ *   8   u16       rows
+ *   10  u16       cols
+ *   12  u16       number of tokens in the alphabet (at most 255)
+ *   14  u16       reserved, 0
+ *   16  u32       offset of the first record
+ *   20  ...       the alphabet: each token as a u8 length and its
+ *                 (lowercase) characters, zero padded up to the first
+ *                 record
+ *
+ * followed by one record per board, up to the end of the file: rows x
+ * cols bytes in row-major order, each the index of the die's token in
+ * the alphabet. Records have no separators or counts, so a board is
+ * found by multiplying, and boards can be appended to a stream at will.
+ */
+
+/* a-z, "qu" and the blank die "?": every die the dice bags use */
+std::vector<std::string> standardAlphabet();
+
+/**
+ * Reads the next board in the text format of README_brd from in.
+ * Returns false at the end of the input or if the board is malformed
+ * (reported on stderr).
+ */
+bool readTextBoard(std::istream &in, unsigned *rows, unsigned *cols,
+        std::vector<std::string> *dice);
+
+/* Writes a board in the text format of README_brd */
+void writeTextBoard(std::ostream &out, unsigned rows, unsigned cols,
+        const std::vector<std::string> &dice);
+
+/**
+ * Writes boards of one size to a board stream. The header goes out as
+ * soon as the writer is made, and each board as soon as it is added;
+ * nothing is buffered, so out may be a pipe.
+ */
+class BoardStreamWriter {
+  public:
+    BoardStreamWriter(std::ostream &out, unsigned rows, unsigned cols,
+            const std::vector<std::string> &alphabet = standardAlphabet());
+
+    /**
+     * Appends a board of rows x cols dice in row-major order, in any
+     * case. Returns false, writing nothing, if it has a different
+     * number of dice or a die not in the alphabet.
+     */
+    bool add(const std::vector<std::string> &dice);
+
+    /* False if writing failed, or nothing was written because the size
+     * does not fit the header */
+    bool good() const { return valid && out.good(); }
+
+    unsigned rows() const { return board_rows; }
+    unsigned cols() const { return board_cols; }
+
+  private:
+    std::ostream &out;
+    bool valid;
+    unsigned board_rows, board_cols;
+    std::vector<std::string> alphabet;
+    std::vector<char> record;
+};
+
+/**
+ * A board stream mapped into memory. Boards are decoded straight from
+ * the mapping; the dice strings handed out are the alphabet's, so
+ * decoding a board into a reused vector allocates nothing.
+ */
+class BoardStreamReader {
+  public:
+    BoardStreamReader();
+    ~BoardStreamReader();
+
+    /**
+     * Maps filename. Returns false if it can not be read or is not a
+     * board stream, or its records hold tokens outside the alphabet.
+     * A partial record at the end, as left by a writer that was cut
+     * off, is not a board; see truncatedBytes.
+     */
+    bool open(const std::string &filename);
+
+    unsigned rows() const { return board_rows; }
+    unsigned cols() const { return board_cols; }
+
+    /* Number of boards */
+    size_t size() const { return count; }
+
+    /* Bytes of the partial record after the last board, if any */
+    size_t truncatedBytes() const { return tail; }
+
+    const std::vector<std::string> &alphabet() const { return tokens; }
+
+    /* The token ids of board i */
+    const uint8_t *record(size_t i) const { return records + i * board_rows * board_cols; }
+
+    /* Sets dice to board i's dice in row-major order */
+    void board(size_t i, std::vector<std::string> *dice) const;
+
+    /* Whether filename starts like a board stream */
+    static bool sniff(const std::string &filename);
+
+  private:
+    BoardStreamReader(const BoardStreamReader &);
+    BoardStreamReader &operator=(const BoardStreamReader &);
+
+    void close();
+
+    unsigned char *mapped;
+    size_t mapped_size;
+    const uint8_t *records;
+    size_t count;
+    size_t tail;
+    unsigned board_rows, board_cols;
+    std::vector<std::string> tokens;
+};
+
+#endif // BOGGLESTREAM_H
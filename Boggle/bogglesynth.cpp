@@ -0,0 +1,408 @@
+#include "bogglesynth.h"
+#include "boggleplayer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+/* Backtracks a thread's first attempt may make; each later attempt
+ * may make half as many again as the one before */
+static const uint64_t FIRST_BUDGET = 256;
+
+/* Paths counted per target when picking the next one to place; a
+ * target with this many is as good as unconstrained */
+static const unsigned PATH_COUNT_CAP = 32;
+
+/* Backtracks between looks at the clock */
+static const uint64_t CLOCK_INTERVAL = 1024;
+
+static const unsigned FACE_Q = 'q' - 'a';
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* The die showing face k */
+static std::string faceDie(unsigned k) {
+    return k == FACE_Q ? "qu" : std::string(1, (char)('a' + k));
+}
+
+    SynthOptions::SynthOptions()
+        : goal(SYNTH_MOST_WORDS), letters((1u << 26) - 1), threads(1), attempts(0),
+          seconds(5), seed(1), rules(ScoringRules::official()) {}
+
+    /**
+     * One attempt at placing every target: the face fixed on each die
+     * (-1 while free) and the path of each placed target. The search is
+     * complete, so an attempt that neither finds a placement nor runs
+     * out of backtracks proves there is none.
+     */
+    class TargetPacker {
+      public:
+        enum Outcome { PACKED, NO_FIT, GAVE_UP };
+
+        TargetPacker(const BoardTopology &topology,
+                const std::vector<std::vector<uint8_t> > &faces)
+            : topology(topology), faces(faces), fixed(topology.size()), placed(faces.size()),
+              paths(faces.size()), starts(topology.size()), order(topology.size()),
+              budget(0), backtracks(0), gave_up(false) {}
+
+        /**
+         * Places every target, trying dice in an order drawn from rng,
+         * unless more than budget backtracks are needed or the deadline
+         * passes.
+         */
+        Outcome pack(std::mt19937_64 &rng, uint64_t budget,
+                std::chrono::steady_clock::time_point deadline) {
+            std::fill(fixed.begin(), fixed.end(), -1);
+            std::fill(placed.begin(), placed.end(), false);
+            for(size_t t = 0; t < paths.size(); t++)
+                paths[t].clear();
+            for(unsigned c = 0; c < topology.size(); c++) {
+                starts[c] = c;
+                order[c].assign(topology.neighbours(c), topology.neighbours(c) + topology.degree(c));
+                std::shuffle(order[c].begin(), order[c].end(), rng);
+            }
+            std::shuffle(starts.begin(), starts.end(), rng);
+            this->budget = budget;
+            this->deadline = deadline;
+            backtracks = 0;
+            gave_up = false;
+            if(place(0))
+                return PACKED;
+            return gave_up ? GAVE_UP : NO_FIT;
+        }
+
+        /* The face fixed on each die, or -1 for a die no target crosses */
+        const std::vector<int> &faceOf() const { return fixed; }
+
+        const std::vector<std::vector<int> > &targetPaths() const { return paths; }
+
+        uint64_t backtrackCount() const { return backtracks; }
+
+      private:
+        bool fits(int cell, int face) const { return fixed[cell] < 0 || fixed[cell] == face; }
+
+        /* Places the targets left once depth of them are placed */
+        bool place(size_t depth) {
+            if(depth == faces.size())
+                return true;
+            if(!enoughDice())
+                return false;
+            // the target with the fewest paths left goes next, and one
+            // with none left ends this branch
+            size_t next = faces.size();
+            unsigned fewest = PATH_COUNT_CAP + 1;
+            for(size_t t = 0; t < faces.size(); t++) {
+                if(placed[t])
+                    continue;
+                unsigned ways = countPaths(t, std::min(fewest, PATH_COUNT_CAP));
+                if(ways == 0)
+                    return false;
+                if(ways < fewest) {
+                    fewest = ways;
+                    next = t;
+                }
+            }
+            placed[next] = true;
+            if(walk(next, depth, 0, -1, 0))
+                return true;
+            placed[next] = false;
+            return false;
+        }
+
+        /**
+         * Extends target's path, whose first i faces end on cell, over
+         * every die that can show the next face, and places the other
+         * targets once it is complete. Dice already showing the face
+         * are tried before free ones, so that targets share dice.
+         */
+        bool walk(size_t target, size_t depth, size_t i, int cell, uint64_t visited) {
+            const std::vector<uint8_t> &word = faces[target];
+            if(i == word.size()) {
+                if(place(depth + 1))
+                    return true;
+                backtracks++;
+                if(backtracks > budget || (backtracks % CLOCK_INTERVAL == 0 &&
+                        std::chrono::steady_clock::now() > deadline))
+                    gave_up = true;
+                return false;
+            }
+            const std::vector<int> &next = cell < 0 ? starts : order[cell];
+            for(int pass = 0; pass < 2; pass++) {
+                for(size_t n = 0; n < next.size() && !gave_up; n++) {
+                    int c = next[n];
+                    if((visited >> c) & 1)
+                        continue;
+                    if(pass == 0 ? fixed[c] != word[i] : fixed[c] >= 0)
+                        continue;
+                    fixed[c] = word[i];
+                    paths[target].push_back(c);
+                    if(walk(target, depth, i + 1, c, visited | (uint64_t)1 << c))
+                        return true;
+                    paths[target].pop_back();
+                    if(pass == 1)
+                        fixed[c] = -1;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Whether the free dice could still supply the faces the
+         * targets left need: a target needs a die of its own for every
+         * time a face appears in it, beyond the dice already fixed to
+         * that face.
+         */
+        bool enoughDice() const {
+            unsigned needed[26] = { 0 }, showing[26] = { 0 };
+            unsigned free_dice = 0;
+            for(size_t c = 0; c < fixed.size(); c++) {
+                if(fixed[c] < 0)
+                    free_dice++;
+                else
+                    showing[fixed[c]]++;
+            }
+            for(size_t t = 0; t < faces.size(); t++) {
+                if(placed[t])
+                    continue;
+                unsigned counts[26] = { 0 };
+                for(size_t i = 0; i < faces[t].size(); i++)
+                    counts[faces[t][i]]++;
+                for(unsigned k = 0; k < 26; k++)
+                    needed[k] = std::max(needed[k], counts[k]);
+            }
+            unsigned short_by = 0;
+            for(unsigned k = 0; k < 26; k++) {
+                if(needed[k] > showing[k])
+                    short_by += needed[k] - showing[k];
+            }
+            return short_by <= free_dice;
+        }
+
+        /* Paths target could take over the dice as fixed so far, up to cap */
+        unsigned countPaths(size_t target, unsigned cap) const {
+            unsigned count = 0;
+            for(unsigned c = 0; c < topology.size() && count < cap; c++) {
+                if(fits(c, faces[target][0]))
+                    count += countFrom(target, 1, c, (uint64_t)1 << c, cap - count);
+            }
+            return count;
+        }
+
+        unsigned countFrom(size_t target, size_t i, int cell, uint64_t visited, unsigned cap) const {
+            if(i == faces[target].size())
+                return 1;
+            unsigned count = 0;
+            const int *next = topology.neighbours(cell);
+            for(unsigned n = 0; n < topology.degree(cell) && count < cap; n++) {
+                int c = next[n];
+                if(!((visited >> c) & 1) && fits(c, faces[target][i]))
+                    count += countFrom(target, i + 1, c, visited | (uint64_t)1 << c, cap - count);
+            }
+            return count;
+        }
+
+        const BoardTopology &topology;
+        const std::vector<std::vector<uint8_t> > &faces;
+
+        std::vector<int> fixed;
+        std::vector<bool> placed;
+        std::vector<std::vector<int> > paths;
+
+        /* This attempt's order of the cells, and of each one's neighbours */
+        std::vector<int> starts;
+        std::vector<std::vector<int> > order;
+
+        uint64_t budget;
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t backtracks;
+        bool gave_up;
+    };
+
+    /* What the workers of one run share; result is guarded by lock */
+    struct BoardSynthesizer::Shared {
+        std::mutex lock;
+        SynthResult *result;
+        std::atomic<uint64_t> attempts;
+        std::atomic<bool> stop;
+        std::chrono::steady_clock::time_point start, deadline;
+    };
+
+    BoardSynthesizer::BoardSynthesizer(const BogglePlayer &source, const BoardTopology &topology,
+            const std::vector<std::string> &targets, const SynthOptions &options)
+            : topology(topology), options(options), faces(targets.size()),
+              targets_valid(topology.size() > 0 && topology.size() <= 64),
+              master(new BogglePlayer()) {
+        master->shareLexicon(source);
+        master->setScoringRules(options.rules);
+        for(size_t t = 0; t < targets.size(); t++) {
+            const std::string &target = targets[t];
+            for(size_t i = 0; i < target.size(); i++) {
+                unsigned k = (unsigned char)(tolower((unsigned char)target[i]) - 'a');
+                if(k >= 26 || (k == FACE_Q && (i + 1 == target.size() ||
+                        tolower((unsigned char)target[i + 1]) != 'u'))) {
+                    targets_valid = false;
+                    break;
+                }
+                if(k == FACE_Q)
+                    i++;
+                faces[t].push_back((uint8_t)k);
+            }
+            if(faces[t].empty() || faces[t].size() > topology.size())
+                targets_valid = false;
+        }
+    }
+
+    BoardSynthesizer::~BoardSynthesizer() {}
+
+    void BoardSynthesizer::run(SynthResult *result) {
+        result->found = false;
+        result->impossible = false;
+        result->dice.clear();
+        result->paths.clear();
+        result->words = result->points = 0;
+        result->first_seconds = result->best_seconds = -1;
+        result->attempts = result->backtracks = result->evaluations = 0;
+        if(!targets_valid)
+            return;
+
+        Shared shared;
+        shared.result = result;
+        shared.attempts = 0;
+        shared.stop = false;
+        shared.start = std::chrono::steady_clock::now();
+        shared.deadline = options.seconds > 0
+            ? shared.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(options.seconds))
+            : std::chrono::steady_clock::time_point::max();
+
+        unsigned threads = std::max(options.threads, 1u);
+        std::vector<std::thread> workers;
+        for(unsigned i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&BoardSynthesizer::work, this, i, &shared));
+        }
+        for(unsigned i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+        result->attempts = shared.attempts;
+        if(options.attempts != 0)
+            result->attempts = std::min(result->attempts, options.attempts);
+    }
+
+    /* Board value as the goal ranks it, higher being better */
+    static int64_t evaluate(BogglePlayer &player, const BoardTopology &topology, SynthGoal goal,
+            const std::vector<std::string> &dice, ScoreResult *score) {
+        player.setBoard(topology, dice);
+        player.scoreBoard(0, SCORE_BY_POINTS, score);
+        return goal == SYNTH_MOST_WORDS ? (int64_t)score->words : -(int64_t)score->words;
+    }
+
+    void BoardSynthesizer::work(unsigned worker, Shared *shared) {
+        BogglePlayer player;
+        player.shareLexicon(*master);
+        player.setScoringRules(options.rules);
+        std::mt19937_64 rng(options.seed + worker * 0x9e3779b97f4a7c15ull);
+        TargetPacker packer(topology, faces);
+        bool until_found = options.attempts == 0 && options.seconds <= 0;
+
+        std::vector<unsigned> letters;
+        for(unsigned k = 0; k < 26; k++) {
+            if((options.letters >> k) & 1)
+                letters.push_back(k);
+        }
+        if(letters.empty())
+            letters.push_back('e' - 'a');
+
+        uint64_t budget = FIRST_BUDGET;
+        uint64_t backtracks = 0, evaluations = 0;
+        std::vector<std::string> dice(topology.size());
+        std::vector<int> free_cells;
+        ScoreResult score;
+        while(!shared->stop && std::chrono::steady_clock::now() < shared->deadline) {
+            uint64_t attempt = shared->attempts++;
+            if(options.attempts != 0 && attempt >= options.attempts)
+                break;
+            TargetPacker::Outcome outcome = packer.pack(rng, budget, shared->deadline);
+            backtracks += packer.backtrackCount();
+            if(outcome == TargetPacker::NO_FIT) {
+                std::lock_guard<std::mutex> guard(shared->lock);
+                shared->result->impossible = true;
+                shared->stop = true;
+                break;
+            }
+            if(outcome == TargetPacker::GAVE_UP) {
+                budget += budget / 2;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> guard(shared->lock);
+                if(shared->result->first_seconds < 0)
+                    shared->result->first_seconds = secondsSince(shared->start);
+            }
+
+            // fill the free dice at random, then change one at a time
+            // for as long as some change improves the board
+            const std::vector<int> &fixed = packer.faceOf();
+            free_cells.clear();
+            for(unsigned c = 0; c < topology.size(); c++) {
+                if(fixed[c] >= 0) {
+                    dice[c] = faceDie(fixed[c]);
+                }
+                else {
+                    dice[c] = faceDie(letters[rng() % letters.size()]);
+                    free_cells.push_back(c);
+                }
+            }
+            std::shuffle(free_cells.begin(), free_cells.end(), rng);
+            int64_t value = evaluate(player, topology, options.goal, dice, &score);
+            uint64_t words = score.words, points = score.total;
+            evaluations++;
+            bool improved = !until_found;
+            while(improved && std::chrono::steady_clock::now() < shared->deadline) {
+                improved = false;
+                for(size_t f = 0; f < free_cells.size() &&
+                        std::chrono::steady_clock::now() < shared->deadline; f++) {
+                    int c = free_cells[f];
+                    std::string kept = dice[c], best = kept;
+                    for(size_t l = 0; l < letters.size(); l++) {
+                        dice[c] = faceDie(letters[l]);
+                        if(dice[c] == kept)
+                            continue;
+                        int64_t candidate = evaluate(player, topology, options.goal, dice, &score);
+                        evaluations++;
+                        if(candidate > value) {
+                            value = candidate;
+                            words = score.words;
+                            points = score.total;
+                            best = dice[c];
+                        }
+                    }
+                    dice[c] = best;
+                    improved = improved || best != kept;
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(shared->lock);
+            SynthResult *result = shared->result;
+            int64_t incumbent = options.goal == SYNTH_MOST_WORDS
+                ? (int64_t)result->words : -(int64_t)result->words;
+            if(!result->found || value > incumbent) {
+                result->found = true;
+                result->dice = dice;
+                result->paths = packer.targetPaths();
+                result->words = words;
+                result->points = points;
+                result->best_seconds = secondsSince(shared->start);
+            }
+            if(until_found)
+                shared->stop = true;
+        }
+        std::lock_guard<std::mutex> guard(shared->lock);
+        shared->result->backtracks += backtracks;
+        shared->result->evaluations += evaluations;
+    }
@@ -0,0 +1,133 @@
+#ifndef BOGGLESYNTH_H
+#define BOGGLESYNTH_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bogglescore.h"
+#include "boggletopology.h"
+
+class BogglePlayer;
+
+/* What the dice left free by the targets are chosen for */
+enum SynthGoal {
+    SYNTH_MOST_WORDS,
+    SYNTH_FEWEST_WORDS
+};
+
+/* How a BoardSynthesizer searches, and for how long */
+struct SynthOptions {
+    SynthGoal goal;
+
+    /* Letters the free dice may show, bit k standing for 'a' + k (q
+     * for the Qu face), as in a BoardClass */
+    uint32_t letters;
+
+    unsigned threads;
+
+    /* Randomized restarts in all and seconds to search, either 0 for
+     * no limit; with neither limited the search ends with the first
+     * board holding every target */
+    uint64_t attempts;
+    double seconds;
+
+    uint64_t seed;
+
+    /* Which words count towards the goal */
+    ScoringRules rules;
+
+    /* Most words, any letter, one thread, 5 seconds, official rules */
+    SynthOptions();
+};
+
+/* The best board a BoardSynthesizer found, and how the search went */
+struct SynthResult {
+    /* Whether a board holding every target was found; if not, whether
+     * the search proved that none exists */
+    bool found;
+    bool impossible;
+
+    /* The board's dice, and the board indices of one path of each
+     * target in the order given */
+    std::vector<std::string> dice;
+    std::vector<std::vector<int> > paths;
+
+    /* The words that count on the board, and their points */
+    uint64_t words;
+    uint64_t points;
+
+    /* Seconds until the first board holding every target and until
+     * this one; -1 if none was found */
+    double first_seconds;
+    double best_seconds;
+
+    uint64_t attempts;
+    uint64_t backtracks;
+
+    /* Boards solved to score free dice */
+    uint64_t evaluations;
+};
+
+/**
+ * Designs boards holding a given set of target words, each spelled
+ * along a path as isOnBoard finds them, with the remaining dice chosen
+ * to make as many or as few other words as it can.
+ *
+ * The targets are placed by a depth-first search over their paths:
+ * the target with the fewest paths left on the dice fixed so far goes
+ * next, a path may only cross a fixed die showing its letter, and every
+ * placement is checked against the targets still to place, so a dead
+ * end is dropped as soon as one of them has no path left. Each attempt
+ * tries cells in a new random order and gives up after a number of
+ * backtracks that grows from attempt to attempt; an attempt that runs
+ * to completion without finding a placement proves there is none.
+ *
+ * A placement's free dice are then filled at random and improved one
+ * die at a time, each candidate scored by a count-only solve, until no
+ * single change helps. Threads run attempts independently and keep the
+ * best board.
+ */
+class BoardSynthesizer {
+  public:
+    /**
+     * A synthesizer of boards of the given topology (at most 64 dice)
+     * holding targets, in any case, using source's lexicon.
+     */
+    BoardSynthesizer(const BogglePlayer &source, const BoardTopology &topology,
+            const std::vector<std::string> &targets,
+            const SynthOptions &options = SynthOptions());
+    ~BoardSynthesizer();
+
+    /**
+     * Whether the targets can be spelled by dice at all: a-z only,
+     * every q followed by a u, none longer than the board. run() finds
+     * nothing otherwise.
+     */
+    bool valid() const { return targets_valid; }
+
+    /* Searches until the options' attempts or time run out, or the
+     * targets are proved not to fit */
+    void run(SynthResult *result);
+
+  private:
+    BoardSynthesizer(const BoardSynthesizer &);
+    BoardSynthesizer &operator=(const BoardSynthesizer &);
+
+    struct Shared;
+
+    void work(unsigned worker, Shared *shared);
+
+    BoardTopology topology;
+    SynthOptions options;
+
+    /* Each target as die faces, k for letter 'a' + k (q for Qu) */
+    std::vector<std::vector<uint8_t> > faces;
+    bool targets_valid;
+
+    /* Holds the lexicon and rules; workers share them */
+    std::unique_ptr<BogglePlayer> master;
+};
+
+#endif // BOGGLESYNTH_H
@@ -0,0 +1,102 @@
+#include "boggletopology.h"
+
+#include <algorithm>
+
+/* Adds cell to list unless it is already there; small boards wrap
+ * onto the same die from two sides */
+static void addOnce(std::vector<int> *list, int cell) {
+    if(std::find(list->begin(), list->end(), cell) == list->end())
+        list->push_back(cell);
+}
+
+    BoardTopology::BoardTopology()
+        : offsets(1, 0), board_rows(0), board_cols(0), max_degree(0), is_grid(true) {}
+
+    BoardTopology::BoardTopology(unsigned rows, unsigned cols, bool is_grid,
+            const std::vector<std::vector<int> > &lists)
+            : offsets(1, 0), board_rows(rows), board_cols(cols), max_degree(0), is_grid(is_grid) {
+        offsets.reserve(lists.size() + 1);
+        for(size_t cell = 0; cell < lists.size(); cell++) {
+            targets.insert(targets.end(), lists[cell].begin(), lists[cell].end());
+            offsets.push_back((uint32_t)targets.size());
+            max_degree = std::max(max_degree, (unsigned)lists[cell].size());
+        }
+    }
+
+    /* Neighbours in row-major order, as the searches have always
+     * visited them */
+    BoardTopology BoardTopology::grid(unsigned rows, unsigned cols) {
+        std::vector<std::vector<int> > lists(rows * cols);
+        for(int row = 0; row < (int)rows; row++) {
+            for(int col = 0; col < (int)cols; col++) {
+                std::vector<int> &list = lists[row * cols + col];
+                for(int r = row - 1; r <= row + 1; r++) {
+                    for(int c = col - 1; c <= col + 1; c++) {
+                        if((r != row || c != col) && r >= 0 && c >= 0 &&
+                                r < (int)rows && c < (int)cols)
+                            list.push_back(r * cols + c);
+                    }
+                }
+            }
+        }
+        return BoardTopology(rows, cols, true, lists);
+    }
+
+    BoardTopology BoardTopology::torus(unsigned rows, unsigned cols) {
+        std::vector<std::vector<int> > lists(rows * cols);
+        for(int row = 0; row < (int)rows; row++) {
+            for(int col = 0; col < (int)cols; col++) {
+                int cell = row * cols + col;
+                for(int dr = -1; dr <= 1; dr++) {
+                    for(int dc = -1; dc <= 1; dc++) {
+                        int next = (row + dr + rows) % rows * cols + (col + dc + cols) % cols;
+                        if((dr != 0 || dc != 0) && next != cell)
+                            addOnce(&lists[cell], next);
+                    }
+                }
+            }
+        }
+        return BoardTopology(rows, cols, false, lists);
+    }
+
+    BoardTopology BoardTopology::hex(unsigned rows, unsigned cols) {
+        std::vector<std::vector<int> > lists(rows * cols);
+        for(int row = 0; row < (int)rows; row++) {
+            // the rows above and below reach half a cell back on even
+            // rows and half a cell on on odd ones
+            int shift = row % 2;
+            for(int col = 0; col < (int)cols; col++) {
+                std::vector<int> &list = lists[row * cols + col];
+                for(int r = row - 1; r <= row + 1; r++) {
+                    int first = r == row ? col - 1 : col - 1 + shift;
+                    int last = r == row ? col + 1 : col + shift;
+                    for(int c = first; c <= last; c++) {
+                        if((r != row || c != col) && r >= 0 && c >= 0 &&
+                                r < (int)rows && c < (int)cols)
+                            list.push_back(r * cols + c);
+                    }
+                }
+            }
+        }
+        return BoardTopology(rows, cols, false, lists);
+    }
+
+    BoardTopology BoardTopology::fromEdges(unsigned cells,
+            const std::vector<std::pair<unsigned, unsigned> > &edges) {
+        std::vector<std::vector<int> > lists(cells);
+        for(size_t i = 0; i < edges.size(); i++) {
+            unsigned a = edges[i].first, b = edges[i].second;
+            if(a >= cells || b >= cells || a == b)
+                continue;
+            addOnce(&lists[a], b);
+            addOnce(&lists[b], a);
+        }
+        for(size_t cell = 0; cell < cells; cell++)
+            std::sort(lists[cell].begin(), lists[cell].end());
+        return BoardTopology(1, cells, false, lists);
+    }
+
+    bool BoardTopology::operator==(const BoardTopology &other) const {
+        return board_rows == other.board_rows && board_cols == other.board_cols &&
+            offsets == other.offsets && targets == other.targets;
+    }
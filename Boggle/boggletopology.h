@@ -0,0 +1,68 @@
+#ifndef BOGGLETOPOLOGY_H
+#define BOGGLETOPOLOGY_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/**
+ * Which dice of a board are adjacent: a graph over the cells 0 ..
+ * size() - 1, kept in compressed sparse row form, so the neighbours of
+ * a cell are one contiguous run of cell numbers. The searches walk
+ * these runs instead of stepping around a grid, so a wrapped or hex
+ * board costs the same per step as the usual one.
+ *
+ * Cells are numbered row-major for the generated layouts; rows() x
+ * cols() always equals size(), a custom graph counting as one row.
+ */
+class BoardTopology {
+  public:
+    /* No cells */
+    BoardTopology();
+
+    /* The standard board: each die touches the up to eight around it */
+    static BoardTopology grid(unsigned rows, unsigned cols);
+
+    /* A grid whose edges wrap around, so every die has eight
+     * neighbours (fewer on boards under three dice across) */
+    static BoardTopology torus(unsigned rows, unsigned cols);
+
+    /* Hexagonal cells in offset rows, odd rows shifted half a cell to
+     * the right; each die touches the up to six around it */
+    static BoardTopology hex(unsigned rows, unsigned cols);
+
+    /* Any graph of cells dice, given as undirected edges; edges naming
+     * a missing cell, loops and repeats are dropped */
+    static BoardTopology fromEdges(unsigned cells,
+            const std::vector<std::pair<unsigned, unsigned> > &edges);
+
+    unsigned size() const { return (unsigned)offsets.size() - 1; }
+    unsigned rows() const { return board_rows; }
+    unsigned cols() const { return board_cols; }
+
+    /* Whether this is grid(rows(), cols()), which the board-size
+     * kernels and bitboard solvers assume */
+    bool isGrid() const { return is_grid; }
+
+    unsigned degree(unsigned cell) const { return offsets[cell + 1] - offsets[cell]; }
+    const int *neighbours(unsigned cell) const { return targets.data() + offsets[cell]; }
+
+    /* Most neighbours of any cell */
+    unsigned maxDegree() const { return max_degree; }
+
+    bool operator==(const BoardTopology &other) const;
+    bool operator!=(const BoardTopology &other) const { return !(*this == other); }
+
+  private:
+    /* Builds the CSR arrays from per-cell lists, which keep their order */
+    BoardTopology(unsigned rows, unsigned cols, bool is_grid,
+            const std::vector<std::vector<int> > &lists);
+
+    std::vector<uint32_t> offsets;
+    std::vector<int> targets;
+    unsigned board_rows, board_cols;
+    unsigned max_degree;
+    bool is_grid;
+};
+
+#endif // BOGGLETOPOLOGY_H
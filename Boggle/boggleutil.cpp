@@ -5,7 +5,6 @@
      * sanitized by the caller.
      */
     BoardPos::BoardPos(const std::string &text) : text(text){
-        visited = false;
     }
 
     /**
@@ -14,22 +13,14 @@
     const std::string BoardPos::getText() const {
         return text;
     }
-    
-    /**
-     * Returns whether this BoardPos has been visited or not.
-     */
-    bool BoardPos::getVisited() const {
-        return visited;
-    }
 
     /**
-     * Sets whether this BoardPos has been visited or not.
+     * Returns whether this BoardPos is a blank die.
      */
-    void BoardPos::setVisited(bool visitedd){
-        visited = visitedd;
-        return;
+    bool BoardPos::isWildcard() const {
+        return isWildcardDie(text);
     }
-
+    
     LexNode * Lexicon::getRoot() {
         return this->root;
     }
@@ -68,6 +59,10 @@
             childIterator = curr->children.find(letter);
             if(childIterator != curr->children.end()) { // if the iterator does not return end of map, the letter exists in its map
                 curr = childIterator->second;           // access the LexNode associated with that letter
+
+                // a word may end on a node created for a longer word
+                if(i == length-1)
+                    curr->end_of_word = true;
             }else{                                      // Else, the letter doesn't exist yet and we must add a lex node for it in curr's child map
                 LexNode * newLexNode = new LexNode();
 
@@ -119,19 +114,14 @@
 
     bool Lexicon::isPrefix(std::string word) {
 
-        // Iterate through each letter in word
-        // once we reach the end of word 
-
+        // Walk down the trie one letter at a time; word is a prefix
+        // as long as every letter has a node
         LexNode * curr = root;
         int length = (int)word.length();
 
         for(int i = 0; i<length; i++) {
-            char letter = word[i];
-
-            auto childIterator = curr->children.begin();
-            childIterator = curr->children.find(letter);
-
-            if(!(childIterator->first))
+            curr = curr->getChildren(word[i]);
+            if(curr == NULL)
                 return false;
         }
 
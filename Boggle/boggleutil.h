@@ -14,12 +14,22 @@
 
 using namespace std;
 
+/**
+ * Die text of a blank (wildcard) die, which stands for any one letter
+ * of a word traced through it.
+ */
+static const char WILDCARD_DIE[] = "?";
+
+inline bool isWildcardDie(const std::string &text) {
+    return text == WILDCARD_DIE;
+}
+
 /**
  * Class that represents a position on the Boggle Board.
  *
  * Each position contains its sanitized string that represents the
- * characters on that board position, as well as a boolean that
- * marks the board position as visited by a given search algorithm.
+ * characters on that board position. Searches keep track of the
+ * positions they have visited themselves.
  */
 class BoardPos {
   public:
@@ -33,27 +43,17 @@ class BoardPos {
      * Returns the characters on this BoardPos.
      */
     const std::string getText() const;
-    
-    /**
-     * Returns whether this BoardPos has been visited or not.
-     */
-    bool getVisited() const;
 
     /**
-     * Sets whether this BoardPos has been visited or not.
+     * Returns whether this BoardPos is a blank die (see WILDCARD_DIE).
      */
-    void setVisited(bool visitedd);
+    bool isWildcard() const;
 
   private:
     /**
      * The characters that this BoardPos contains.
      */
     const std::string text;
-
-    /**
-     * Whether this BoardPos has been visited or not.
-     */
-    bool visited;
 };
 
 /* Private class for a node in the Lexicon */
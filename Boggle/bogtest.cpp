@@ -3,11 +3,26 @@
  * ****************************************************/
 
 #include "baseboggleplayer.h"
+#include "boggleabi.h"
+#include "bogglecache.h"
+#include "boggleclass.h"
 #include "boggleplayer.h"
+#include "boggleslice.h"
+#include "bogglesynth.h"
+#include "bogglestream.h"
+#include "lexiconversions.h"
+#include "lexiconmap.h"
+#include "lexiconquery.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <string>
 #include <set>
+#include <thread>
 
 int main () {
 
@@ -61,6 +76,862 @@ int main () {
     return -1;
   }
 
+  // 4x4 boards go through the specialized kernel; it must agree with
+  // the generic search
+  BogglePlayer fixed, generic;
+  set<string> lex4;
+  lex4.insert("ape"); lex4.insert("pea"); lex4.insert("apex"); lex4.insert("queen");
+  lex4.insert("nab"); lex4.insert("pap");
+  fixed.buildLexicon(lex4);
+  generic.buildLexicon(lex4);
+  generic.setKernelsEnabled(false);
+  string r0[] = {"A","P","E","X"};
+  string r1[] = {"B","Qu","E","N"};
+  string r2[] = {"N","E","Z","Z"};
+  string r3[] = {"A","Z","Z","Z"};
+  string* board4[] = {r0,r1,r2,r3};
+  fixed.setBoard(4,4,board4);
+  generic.setBoard(4,4,board4);
+  set<string> fixedWords, genericWords;
+  fixed.getAllValidWords(3,&fixedWords);
+  generic.getAllValidWords(3,&genericWords);
+  if(fixedWords != genericWords || fixedWords.size() != 3 || fixedWords.count("queen") != 1) {
+    std::cerr << "Apparent problem with getAllValidWords #3." << std::endl;
+    return -1;
+  }
+  locations = fixed.isOnBoard("queen");
+  if(locations.size() != 4 || locations[0] != 5 || locations[3] != 7) {
+    std::cerr << "Apparent problem with isOnBoard #3." << std::endl;
+    return -1;
+  }
+  if(fixed.isOnBoard("pap").size() != 0) {
+    std::cerr << "Apparent problem with isOnBoard #4." << std::endl;
+    return -1;
+  }
+
+  // scoring must agree between the kernel and the generic search;
+  // ape, apex and queen score 1 + 1 + 2 under the official rules
+  ScoreResult fixedScore, genericScore;
+  if(!fixed.scoreBoard(1, SCORE_BY_POINTS, &fixedScore) ||
+     !generic.scoreBoard(1, SCORE_BY_POINTS, &genericScore) ||
+     fixedScore.words != 3 || fixedScore.total != 4 || genericScore.total != 4 ||
+     fixedScore.by_length.size() != 6 || fixedScore.by_length[5] != 1 ||
+     fixedScore.top.size() != 1 || fixedScore.top[0].word != "queen" ||
+     genericScore.top.size() != 1 || genericScore.top[0].word != "queen") {
+    std::cerr << "Apparent problem with scoreBoard #1." << std::endl;
+    return -1;
+  }
+  ScoringRules rules = ScoringRules::official();
+  rules.qu_counts_two = false;
+  rules.minimum_length = 4;
+  fixed.setScoringRules(rules);
+  fixed.scoreBoard(0, SCORE_BY_LENGTH, &fixedScore);
+  if(fixedScore.words != 2 || fixedScore.total != 2 || !fixedScore.top.empty()) {
+    std::cerr << "Apparent problem with scoreBoard #2." << std::endl;
+    return -1;
+  }
+
+  // the lockstep solver must find what the players find, board by board
+  string s0[] = {"P","A","P","E"};
+  string* board4b[] = {s0,r1,r2,r3};
+  vector<vector<string> > batch(2);
+  batch[0].insert(batch[0].end(), r0, r0 + 4);
+  batch[1].insert(batch[1].end(), s0, s0 + 4);
+  for(int b = 0; b < 2; b++) {
+    batch[b].insert(batch[b].end(), r1, r1 + 4);
+    batch[b].insert(batch[b].end(), r2, r2 + 4);
+    batch[b].insert(batch[b].end(), r3, r3 + 4);
+  }
+  SlicedSolver sliced(*fixed.getLexicon(), 4, 4);
+  vector<set<string> > slicedWords;
+  vector<vector<int32_t> > slicedIds;
+  sliced.solve(batch, 3, &slicedWords);
+  sliced.solve(batch, 3, &slicedIds);
+  set<string> secondWords;
+  generic.setBoard(4,4,board4b);
+  generic.getAllValidWords(3,&secondWords);
+  if(slicedWords.size() != 2 || slicedWords[0] != fixedWords || slicedWords[1] != secondWords ||
+     secondWords.count("pap") != 1 || slicedIds[1].size() != secondWords.size()) {
+    std::cerr << "Apparent problem with SlicedSolver #1." << std::endl;
+    return -1;
+  }
+  // a board with too few dice is refused without spoiling the others
+  vector<vector<string> > shortBatch(batch);
+  shortBatch[0].pop_back();
+  if(sliced.solve(shortBatch, 3, &slicedWords) || !sliced.solve(batch, 3, &slicedIds) ||
+     slicedWords.size() != 2 || !slicedWords[0].empty() || slicedWords[1] != secondWords) {
+    std::cerr << "Apparent problem with SlicedSolver #2." << std::endl;
+    return -1;
+  }
+
+  // a blank die stands for any letter, on every search path alike:
+  // with the X a blank, apes joins ape, apex, pea and queen
+  set<string> lexBlank(lex4);
+  lexBlank.insert("apes");
+  string b0[] = {"A","P","E","?"};
+  string* boardBlank[] = {b0,r1,r2,r3};
+  fixed.buildLexicon(lexBlank);
+  generic.buildLexicon(lexBlank);
+  fixed.setBoard(4,4,boardBlank);
+  generic.setBoard(4,4,boardBlank);
+  set<string> fixedBlank, genericBlank;
+  map<string, WildcardLetters> blankLetters, genericLetters;
+  fixed.getAllValidWords(3,&fixedBlank);
+  generic.getAllValidWords(3,&genericBlank);
+  fixed.getAllValidWords(3,&blankLetters);
+  generic.getAllValidWords(3,&genericLetters);
+  vector<vector<string> > blankBatch(1, batch[0]);
+  blankBatch[0][3] = "?";
+  // the first solver's lexicon went with the rebuild
+  SlicedSolver slicedBlank(*fixed.getLexicon(), 4, 4);
+  slicedBlank.solve(blankBatch, 3, &slicedWords);
+  if(fixedBlank != genericBlank || fixedBlank.size() != 5 || fixedBlank.count("apes") != 1 ||
+     slicedWords[0] != fixedBlank || blankLetters.size() != 5 ||
+     blankLetters["apes"].size() != 1 || blankLetters["apes"][0] != make_pair(3, 's') ||
+     !blankLetters["ape"].empty() || genericLetters != blankLetters) {
+    std::cerr << "Apparent problem with wildcard dice #1." << std::endl;
+    return -1;
+  }
+  locations = generic.isOnBoard("apex");
+  if(locations.size() != 4 || locations[3] != 3 || fixed.isOnBoard("apex") != locations ||
+     !fixed.isOnBoard("apexs").empty()) {
+    std::cerr << "Apparent problem with wildcard dice #2." << std::endl;
+    return -1;
+  }
+
+  // interleaved walks find what one walk finds, blanks included
+  BogglePlayer woven;
+  woven.setInterleavedCursors(3);
+  woven.setScoringRules(rules);
+  woven.buildLexicon(lexBlank);
+  woven.setBoard(4,4,boardBlank);
+  set<string> wovenWords;
+  ScoreResult wovenScore, blankScore;
+  map<string, uint64_t> wovenCounts, blankCounts;
+  map<string, WildcardLetters> wovenLetters;
+  woven.getAllValidWords(3,&wovenWords);
+  woven.getAllValidWords(3,&wovenLetters);
+  woven.scoreBoard(2, SCORE_BY_POINTS, &wovenScore);
+  fixed.scoreBoard(2, SCORE_BY_POINTS, &blankScore);
+  woven.getAllPathCounts(3, &wovenCounts);
+  fixed.getAllPathCounts(3, &blankCounts);
+  if(wovenWords != fixedBlank || wovenScore.total != blankScore.total ||
+     wovenScore.top.size() != 2 || wovenScore.top[0].word != blankScore.top[0].word ||
+     wovenCounts != blankCounts || wovenLetters != blankLetters) {
+    std::cerr << "Apparent problem with interleaved search #1." << std::endl;
+    return -1;
+  }
+
+  // a best-first solve finds what scoreBoard finds, best words first,
+  // and stops short when its budget runs out
+  AnytimeResult anytime, cut;
+  fixed.solveAnytime(SolveBudget(), &anytime);
+  fixed.solveAnytime(SolveBudget(0, 1), &cut);
+  bool bestFirst = anytime.complete && anytime.found.words == blankScore.words &&
+    anytime.found.total == blankScore.total && anytime.found.top.size() == anytime.found.words &&
+    anytime.found.top[0].word == blankScore.top[0].word;
+  for(size_t i = 1; i < anytime.found.top.size(); i++)
+    bestFirst = bestFirst && anytime.found.top[i].points <= anytime.found.top[i - 1].points;
+  if(!bestFirst || cut.complete || cut.expansions != 1 || cut.found.words >= anytime.found.words) {
+    std::cerr << "Apparent problem with solveAnytime #1." << std::endl;
+    return -1;
+  }
+
+  // a board's shape is just its neighbour lists: wrapped around, the T
+  // in the top row touches the S in the corner, and a line of dice
+  // spells only along the line, with or without the 4x4 kernel
+  set<string> lexShape;
+  lexShape.insert("cat");
+  lexShape.insert("cats");
+  lexShape.insert("tax");
+  string shapeDice[] = {"C","A","T","X", "X","X","X","X", "X","X","X","X", "X","X","X","S"};
+  vector<string> shape(shapeDice, shapeDice + 16);
+  vector<pair<unsigned, unsigned> > line;
+  line.push_back(make_pair(0u, 1u));
+  line.push_back(make_pair(1u, 2u));
+  line.push_back(make_pair(2u, 15u));
+  BogglePlayer shaped, shapedWoven;
+  shaped.buildLexicon(lexShape);
+  shapedWoven.shareLexicon(shaped);
+  shapedWoven.setInterleavedCursors(2);
+  set<string> gridWords, torusWords, wovenTorus, lineWords;
+  shaped.setBoard(BoardTopology::grid(4, 4), shape);
+  shaped.getAllValidWords(3, &gridWords);
+  shaped.setBoard(BoardTopology::torus(4, 4), shape);
+  shaped.getAllValidWords(3, &torusWords);
+  vector<int> wrapped = shaped.isOnBoard("cats");
+  uint64_t wrappedPaths = shaped.countPaths("cats");
+  AnytimeResult torusAnytime;
+  shaped.solveAnytime(SolveBudget(), &torusAnytime);
+  shapedWoven.setBoard(BoardTopology::torus(4, 4), shape);
+  shapedWoven.getAllValidWords(3, &wovenTorus);
+  shaped.setBoard(BoardTopology::fromEdges(16, line), shape);
+  shaped.getAllValidWords(3, &lineWords);
+  BoardTopology hex = BoardTopology::hex(4, 4);
+  if(gridWords.size() != 2 || gridWords.count("cats") || torusWords.size() != 3 ||
+     wovenTorus != torusWords || wrapped.size() != 4 || wrapped[3] != 15 || wrappedPaths != 1 ||
+     torusAnytime.found.words != 3 || lineWords.size() != 2 || lineWords.count("tax") ||
+     hex.degree(5) != 6 || hex.degree(0) != 2 || hex.neighbours(0)[1] != 4 ||
+     BoardTopology::torus(4, 4).maxDegree() != 8 || !BoardTopology::grid(4, 4).isGrid()) {
+    std::cerr << "Apparent problem with board topologies #1." << std::endl;
+    return -1;
+  }
+  // a word starts on a die, not on one of its neighbours: a die with
+  // no neighbours still spells a one-letter word
+  set<string> lexLone;
+  lexLone.insert("a");
+  lexLone.insert("tx");
+  lexLone.insert("xa");
+  BogglePlayer lone;
+  lone.buildLexicon(lexLone);
+  vector<pair<unsigned, unsigned> > oneEdge;
+  oneEdge.push_back(make_pair(0u, 1u));
+  string loneDice[] = {"T","X","A"};
+  lone.setBoard(BoardTopology::fromEdges(3, oneEdge), vector<string>(loneDice, loneDice + 3));
+  vector<int> lonePath = lone.isOnBoard("a");
+  vector<int> edgePath = lone.isOnBoard("tx");
+  if(lonePath.size() != 1 || lonePath[0] != 2 || edgePath.size() != 2 || edgePath[0] != 0 ||
+     edgePath[1] != 1 || !lone.isOnBoard("xa").empty() || lone.isOnBoard("t").size() != 1) {
+    std::cerr << "Apparent problem with board topologies #2." << std::endl;
+    return -1;
+  }
+
+  // the heat of a die is what tracing every path of every word gives,
+  // whichever search gathers it
+  ScoreResult heatScore, otherScore, allWords;
+  CellHeat heat, genericHeat, wovenHeat;
+  generic.setScoringRules(rules);
+  fixed.scoreBoard(1000, SCORE_BY_POINTS, &allWords);
+  fixed.getCellHeat(&heatScore, &heat);
+  generic.getCellHeat(&otherScore, &genericHeat);
+  woven.getCellHeat(&otherScore, &wovenHeat);
+  vector<uint32_t> traced(16, 0);
+  vector<uint64_t> tracedPoints(16, 0);
+  for(size_t i = 0; i < allWords.top.size(); i++) {
+    WordPaths paths = fixed.wordPaths(allWords.top[i].word);
+    vector<int> path;
+    uint64_t cells = 0;
+    while(paths.next(&path))
+      for(size_t k = 0; k < path.size(); k++)
+        cells |= (uint64_t)1 << path[k];
+    for(int cell = 0; cell < 16; cell++) {
+      if(cells >> cell & 1) {
+        traced[cell]++;
+        tracedPoints[cell] += allWords.top[i].points;
+      }
+    }
+  }
+  bool heatOk = heatScore.total == allWords.total && heat.words == traced &&
+    heat.points == tracedPoints && genericHeat.words == traced && wovenHeat.points == tracedPoints &&
+    heat.first_words == genericHeat.first_words;
+  uint64_t firstPoints = 0;
+  for(int cell = 0; cell < 16; cell++) {
+    heatOk = heatOk && heat.first_words[cell] <= heat.words[cell];
+    firstPoints += heat.first_points[cell];
+  }
+  if(!heatOk || allWords.words == 0 || firstPoints < allWords.total) {
+    std::cerr << "Apparent problem with getCellHeat #1." << std::endl;
+    return -1;
+  }
+  // and the same search can list the words as it goes, through the
+  // kernel and the generic search alike
+  set<string> heatWords, genericHeatWords, countedWords;
+  CellHeat listedHeat, genericListedHeat;
+  ScoreResult listedScore;
+  fixed.getCellHeat(&listedScore, &listedHeat, [&heatWords](const string &word) {
+    return heatWords.insert(word).second;
+  });
+  generic.getCellHeat(&otherScore, &genericListedHeat, [&genericHeatWords](const string &word) {
+    return genericHeatWords.insert(word).second;
+  });
+  for(size_t i = 0; i < allWords.top.size(); i++)
+    countedWords.insert(allWords.top[i].word);
+  if(heatWords != countedWords || genericHeatWords != countedWords ||
+     listedHeat.points != heat.points || genericListedHeat.first_words != heat.first_words ||
+     listedScore.total != heatScore.total) {
+    std::cerr << "Apparent problem with getCellHeat #2." << std::endl;
+    return -1;
+  }
+
+  // words can be streamed out of a plain solve too, and the stream
+  // stops when asked
+  set<string> solvedWords, streamedWords, genericStreamed, wovenStreamed;
+  fixed.getAllValidWords(3, &solvedWords);
+  fixed.getAllValidWords(3, [&streamedWords](const string &word) {
+    return streamedWords.insert(word).second;
+  });
+  generic.getAllValidWords(3, [&genericStreamed](const string &word) {
+    return genericStreamed.insert(word).second;
+  });
+  woven.getAllValidWords(3, [&wovenStreamed](const string &word) {
+    return wovenStreamed.insert(word).second;
+  });
+  size_t streamedBeforeStop = 0;
+  fixed.getAllValidWords(3, [&streamedBeforeStop](const string &) {
+    return ++streamedBeforeStop < 2;
+  });
+  if(solvedWords.empty() || streamedWords != solvedWords || genericStreamed != solvedWords ||
+     wovenStreamed != solvedWords || streamedBeforeStop != 2) {
+    std::cerr << "Apparent problem with streamed getAllValidWords #1." << std::endl;
+    return -1;
+  }
+
+  // every distinct path is counted: on a 2x2 board of A's any order of
+  // distinct dice spells a run of a's
+  BogglePlayer runs;
+  set<string> lexRuns;
+  lexRuns.insert("aa"); lexRuns.insert("aaa"); lexRuns.insert("aaaa"); lexRuns.insert("aaaaa");
+  runs.buildLexicon(lexRuns);
+  string a0[] = {"A","A"};
+  string* boardRuns[] = {a0,a0};
+  runs.setBoard(2,2,boardRuns);
+  WordPaths threes = runs.wordPaths("AAA");
+  set<vector<int> > threePaths;
+  while(threes.next(&locations)) {
+    if(locations.size() != 3)
+      threePaths.clear();
+    threePaths.insert(locations);
+  }
+  map<string, uint64_t> runCounts;
+  runs.getAllPathCounts(0, &runCounts);
+  if(runs.countPaths("aa") != 12 || runs.countPaths("aaa") != 24 || runs.countPaths("aaaa") != 24 ||
+     runs.countPaths("aaaaa") != 0 || threePaths.size() != 24 || threes.count() != 24 ||
+     runCounts.size() != 3 || runCounts["aa"] != 12 || runCounts["aaaa"] != 24) {
+    std::cerr << "Apparent problem with path counting #1." << std::endl;
+    return -1;
+  }
+
+  // the single pass counts agree with counting word by word, through
+  // the kernel and the generic search alike
+  map<string, uint64_t> fixedCounts, genericCounts;
+  fixed.getAllPathCounts(3, &fixedCounts);
+  generic.getAllPathCounts(3, &genericCounts);
+  bool countsAgree = fixedCounts == genericCounts && fixedCounts.size() == fixedBlank.size();
+  for(map<string, uint64_t>::iterator it = fixedCounts.begin(); it != fixedCounts.end(); ++it)
+    countsAgree = countsAgree && it->second > 0 && fixed.countPaths(it->first) == it->second;
+  if(!countsAgree) {
+    std::cerr << "Apparent problem with path counting #2." << std::endl;
+    return -1;
+  }
+
+  // one board serves queries from many threads at once, each getting
+  // what a lone caller gets, through the kernel and the generic search
+  // (make TSAN=1 checks this for races)
+  vector<string> guesses(fixedBlank.begin(), fixedBlank.end());
+  guesses.push_back("APEX"); guesses.push_back("apexs"); guesses.push_back("nab");
+  guesses.push_back("zzzzzz"); guesses.push_back("queens");
+  const BogglePlayer *shared[] = {&fixed, &generic};
+  vector<vector<int> > paths;
+  vector<uint64_t> pathCounts;
+  for(size_t g = 0; g < guesses.size(); g++) {
+    paths.push_back(fixed.isOnBoard(guesses[g]));
+    pathCounts.push_back(fixed.countPaths(guesses[g]));
+  }
+  vector<size_t> agreed(8, 0);
+  vector<std::thread> guessers;
+  for(int t = 0; t < 8; t++) {
+    guessers.push_back(std::thread([&, t]() {
+      const BogglePlayer &player = *shared[t % 2];
+      for(int round = 0; round < 100; round++) {
+        size_t g = (round + t) % guesses.size();
+        bool known = player.isInLexicon(guesses[g]) == fixed.isInLexicon(guesses[g]);
+        vector<int> path = player.isOnBoard(guesses[g]);
+        if(known && path.size() == paths[g].size() && player.countPaths(guesses[g]) == pathCounts[g])
+          agreed[t]++;
+      }
+    }));
+  }
+  for(int t = 0; t < 8; t++)
+    guessers[t].join();
+  if(agreed != vector<size_t>(8, 100) || paths[0].empty() || !paths[guesses.size() - 2].empty()) {
+    std::cerr << "Apparent problem with concurrent queries #1." << std::endl;
+    return -1;
+  }
+  // and so do the whole-board solves, which keep their scratch per
+  // call and build the score table once between them
+  ScoreResult loneScore;
+  CellHeat loneHeat;
+  fixed.getCellHeat(&loneScore, &loneHeat);
+  vector<size_t> solved(8, 0);
+  vector<std::thread> boardSolvers;
+  for(int t = 0; t < 8; t++) {
+    boardSolvers.push_back(std::thread([&, t]() {
+      const BogglePlayer &player = *shared[t % 2];
+      for(int round = 0; round < 20; round++) {
+        set<string> words;
+        ScoreResult score, heatScore;
+        CellHeat heat;
+        map<string, uint64_t> counts;
+        if(player.getAllValidWords(3, &words) && words == fixedBlank &&
+           player.scoreBoard(0, SCORE_BY_POINTS, &score) && score.total == loneScore.total &&
+           player.getCellHeat(&heatScore, &heat) && heat.points == loneHeat.points &&
+           player.getAllPathCounts(3, &counts) && counts == fixedCounts)
+          solved[t]++;
+      }
+    }));
+  }
+  for(int t = 0; t < 8; t++)
+    boardSolvers[t].join();
+  if(solved != vector<size_t>(8, 20) || loneScore.words == 0) {
+    std::cerr << "Apparent problem with concurrent queries #2." << std::endl;
+    return -1;
+  }
+
+  // the C interface hands out packed words from the player's buffer or
+  // copies them into the caller's
+  const char *abiWords[] = {"ape","PEA","apex","queen","nab","pap"};
+  const char *abiDice[] = {"A","P","E","X","B","Qu","E","N","N","E","Z","Z","A","Z","Z","Z"};
+  boggle_lexicon *abiLexicon = boggle_lexicon_from_words(abiWords, 6);
+  boggle_player *abiPlayer = boggle_player_new(abiLexicon);
+  boggle_words abiFound, abiCopied;
+  int abiPath[16];
+  char abiText[64];
+  uint32_t abiOffsets[8];
+  int32_t abiIds[8];
+  set<string> abiSet;
+  if(boggle_abi_version() != BOGGLE_ABI_VERSION || boggle_lexicon_word_count(abiLexicon) != 6 ||
+     !boggle_lexicon_contains(abiLexicon, "Pea") || boggle_lexicon_contains(abiLexicon, "peas") ||
+     boggle_solve(abiPlayer, 3, &abiFound) != BOGGLE_ERR_STATE ||
+     boggle_set_board(abiPlayer, 4, 4, abiDice) != BOGGLE_OK ||
+     boggle_solve(abiPlayer, 3, &abiFound) != BOGGLE_OK || abiFound.count != 3) {
+    std::cerr << "Apparent problem with the C interface #1." << std::endl;
+    return -1;
+  }
+  for(size_t i = 0; i < abiFound.count; i++)
+    abiSet.insert(abiFound.text + abiFound.offsets[i]);
+  boggle_lexicon_free(abiLexicon);
+  if(abiSet != fixedWords || !boggle_is_in_lexicon(abiPlayer, "QUEEN") ||
+     boggle_is_on_board(abiPlayer, "Queen", abiPath, 16) != 4 || abiPath[0] != 5 ||
+     boggle_is_on_board(abiPlayer, "queen", abiPath, 2) != BOGGLE_ERR_SPACE ||
+     boggle_is_on_board(abiPlayer, "pap", abiPath, 16) != 0 ||
+     boggle_solve_into(abiPlayer, 3, abiText, 4, abiOffsets, abiIds, 8, &abiCopied) != BOGGLE_ERR_SPACE ||
+     abiCopied.text_bytes != 15 || abiCopied.count != 3 ||
+     boggle_solve_into(abiPlayer, 3, abiText, sizeof(abiText), abiOffsets, abiIds, 8, &abiCopied) != BOGGLE_OK ||
+     abiCopied.text != abiText || abiSet.count(abiText + abiOffsets[2]) != 1) {
+    std::cerr << "Apparent problem with the C interface #2." << std::endl;
+    return -1;
+  }
+  boggle_player_free(abiPlayer);
+
+  // players on one lexicon solve on several threads at once
+  boggle_lexicon *sharedLexicon = boggle_lexicon_from_words(abiWords, 6);
+  vector<size_t> threadCounts(4, 0);
+  vector<std::thread> solvers;
+  for(int t = 0; t < 4; t++) {
+    solvers.push_back(std::thread([&, t]() {
+      boggle_player *mine = boggle_player_new(sharedLexicon);
+      boggle_words result;
+      for(int round = 0; round < 200; round++) {
+        boggle_set_board(mine, 4, 4, abiDice);
+        if(boggle_solve(mine, 3, &result) == BOGGLE_OK && result.count == 3)
+          threadCounts[t]++;
+      }
+      boggle_player_free(mine);
+    }));
+  }
+  for(int t = 0; t < 4; t++)
+    solvers[t].join();
+  boggle_lexicon_free(sharedLexicon);
+  if(threadCounts != vector<size_t>(4, 200)) {
+    std::cerr << "Apparent problem with the C interface #3." << std::endl;
+    return -1;
+  }
+
+  // boards survive a trip through a board stream and back to text
+  vector<string> streamDice(abiDice, abiDice + 16), blankDice(streamDice), decoded;
+  blankDice[3] = "?";
+  {
+    std::ofstream streamOut("bogtest.bbs", std::ios::binary | std::ios::trunc);
+    BoardStreamWriter writer(streamOut, 4, 4);
+    vector<string> shortBoard(streamDice.begin(), streamDice.end() - 1), oddDie(streamDice);
+    oddDie[0] = "th";
+    if(!writer.add(streamDice) || !writer.add(blankDice) || writer.add(shortBoard) ||
+       writer.add(oddDie) || !writer.good()) {
+      std::cerr << "Apparent problem with BoardStreamWriter #1." << std::endl;
+      return -1;
+    }
+  }
+  BoardStreamReader streamIn;
+  std::ostringstream streamText;
+  bool streamOk = streamIn.open("bogtest.bbs") && BoardStreamReader::sniff("bogtest.bbs") &&
+    !BoardStreamReader::sniff("brd.txt") && streamIn.size() == 2 && streamIn.rows() == 4 &&
+    streamIn.cols() == 4 && streamIn.alphabet().size() == 28 && streamIn.record(1)[3] == 27;
+  if(streamOk) {
+    streamIn.board(0, &decoded);
+    writeTextBoard(streamText, 4, 4, decoded);
+    streamIn.board(1, &decoded);
+  }
+  std::istringstream streamBack(streamText.str());
+  unsigned backRows, backCols;
+  vector<string> backDice;
+  if(!streamOk || decoded[3] != "?" || decoded[5] != "qu" ||
+     !readTextBoard(streamBack, &backRows, &backCols, &backDice) || backRows != 4 ||
+     backDice[0] != "a" || backDice[15] != "z") {
+    std::cerr << "Apparent problem with BoardStreamReader #1." << std::endl;
+    return -1;
+  }
+  fixed.setBoard(4, 4, backDice);
+  fixedBlank.clear();
+  fixed.getAllValidWords(3, &fixedBlank);
+  if(fixedBlank != fixedWords) {
+    std::cerr << "Apparent problem with BoardStreamReader #2." << std::endl;
+    return -1;
+  }
+  // a stream cut off inside a board keeps the boards before it
+  {
+    std::ofstream streamCut("bogtest.bbs", std::ios::binary | std::ios::app);
+    streamCut.write("\0\1\2\3\4", 5);
+  }
+  BoardStreamReader streamTail;
+  if(!streamTail.open("bogtest.bbs") || streamTail.size() != 2 ||
+     streamTail.truncatedBytes() != 5 || streamIn.truncatedBytes() != 0) {
+    std::cerr << "Apparent problem with BoardStreamReader #3." << std::endl;
+    return -1;
+  }
+  std::remove("bogtest.bbs");
+
+  // rotations and reflections share a canonical form and a cache entry,
+  // also across a reopened cache file
+  string c0[] = {"E","Qu","Z"}, c1[] = {"N","E","Z"};
+  vector<string> upright, turned;
+  upright.insert(upright.end(), c0, c0 + 3);
+  upright.insert(upright.end(), c1, c1 + 3);
+  string t[] = {"z","e","n","z","qu","e"};  // turned half a turn
+  turned.assign(t, t + 6);
+  CanonicalBoard canonUp = canonicalBoard(2, 3, upright);
+  CanonicalBoard canonTurned = canonicalBoard(2, 3, turned);
+  vector<int> path(1, 0);
+  if(canonUp.dice != canonTurned.dice || canonUp.rows != 2 ||
+     canonUp.dice[0] != "e" || upright[canonUp.originalPath(path)[0]] != "E" ||
+     canonTurned.originalPath(path)[0] != 5) {
+    std::cerr << "Apparent problem with canonicalBoard #1." << std::endl;
+    return -1;
+  }
+  remove("bogtest.cache");
+  set<string> cachedUp, cachedTurned, cachedAgain;
+  {
+    SolveCache cache(8, 2);
+    if(!cache.openDisk("bogtest.cache", 16, 512)) {
+      std::cerr << "Apparent problem with SolveCache #1." << std::endl;
+      return -1;
+    }
+    SolveCache rival(8);
+    bool shared = rival.openDisk("bogtest.cache");
+    cache.getAllValidWords(generic, 2, 3, upright, 3, &cachedUp);
+    cache.getAllValidWords(generic, 2, 3, turned, 3, &cachedTurned);
+    SolveCacheStats stats = cache.stats();
+    if(shared || cachedUp.size() != 1 || cachedUp.count("queen") != 1 ||
+       cachedTurned != cachedUp || stats.misses != 1 || stats.memory_hits != 1 ||
+       stats.disk_writes != 1 || generic.isOnBoard("queen").size() != 4) {
+      std::cerr << "Apparent problem with SolveCache #2." << std::endl;
+      return -1;
+    }
+  }
+  SolveCache reopened(8);
+  bool reloaded = reopened.openDisk("bogtest.cache");
+  reopened.getAllValidWords(fixed, 2, 3, turned, 3, &cachedAgain);
+  remove("bogtest.cache");
+  if(!reloaded || cachedAgain != cachedUp || reopened.stats().disk_hits != 1) {
+    std::cerr << "Apparent problem with SolveCache #3." << std::endl;
+    return -1;
+  }
+
+  // the best 2x2 board over {a,e,t,x} is two t's with an e and an a:
+  // tea, eat, ate and teat, 4 points; the search must prove it, also
+  // when resumed from a checkpoint taken before it ran
+  set<string> lexOpt;
+  lexOpt.insert("tea"); lexOpt.insert("eat"); lexOpt.insert("ate"); lexOpt.insert("teat");
+  BogglePlayer optPlayer;
+  optPlayer.buildLexicon(lexOpt);
+  uint32_t aetx = (1u << 0) | (1u << 4) | (1u << 19) | (1u << 23);
+  ClassSearch search(optPlayer, 2, 2);
+  search.start(BoardClass(4, aetx), 0);
+  if(!search.saveCheckpoint("bogtest.checkpoint")) {
+    std::cerr << "Apparent problem with ClassSearch #1." << std::endl;
+    return -1;
+  }
+  search.run(2, "", 60);
+  ClassSearch resumed(optPlayer, 2, 2);
+  bool loaded = resumed.resume("bogtest.checkpoint");
+  remove("bogtest.checkpoint");
+  if(loaded)
+    resumed.run(1, "", 60);
+  string bestBoard = search.bestBoard();
+  sort(bestBoard.begin(), bestBoard.end());
+  if(!search.finished() || search.bestScore() != 4 || bestBoard != "aett" ||
+     !loaded || !resumed.finished() || resumed.bestScore() != 4) {
+    std::cerr << "Apparent problem with ClassSearch #2." << std::endl;
+    return -1;
+  }
+
+  Lexicon trie;
+  trie.insert("abc");
+  trie.insert("ab");
+  if(!trie.find("ab") || !trie.find("abc") || trie.find("a")) {
+    std::cerr << "Apparent problem with Lexicon::insert #1." << std::endl;
+    return -1;
+  }
+  if(!trie.isPrefix("a") || !trie.isPrefix("abc") || trie.isPrefix("abd") ||
+     trie.isPrefix("b") || trie.find("abcd")) {
+    std::cerr << "Apparent problem with Lexicon::isPrefix #1." << std::endl;
+    return -1;
+  }
+
+  // a player built on another lexicon's arrays must behave the same
+  FlatLexicon flat(lex4);
+  BogglePlayer viewer(flat.image());
+  viewer.setBoard(4,4,board4);
+  set<string> viewerWords;
+  viewer.getAllValidWords(3,&viewerWords);
+  if(flat.wordCount() != 6 || !flat.find("apex") || flat.find("ap") ||
+     viewerWords != fixedWords || !viewer.isInLexicon("nab")) {
+    std::cerr << "Apparent problem with FlatLexicon #1." << std::endl;
+    return -1;
+  }
+
+  // words are lowercased, and those that still are not letters reported
+  set<string> lexMixed;
+  lexMixed.insert("Apex"); lexMixed.insert("NAB"); lexMixed.insert("nab");
+  lexMixed.insert("don't"); lexMixed.insert("pea");
+  vector<string> rejected;
+  FlatLexicon mixed(lexMixed, &rejected);
+  BogglePlayer mixedPlayer;
+  mixedPlayer.buildLexicon(lexMixed);
+  if(mixed.wordCount() != 3 || !mixed.find("apex") || !mixed.find("nab") ||
+     rejected.size() != 1 || rejected[0] != "don't" ||
+     mixedPlayer.getRejectedWords() != rejected || !mixedPlayer.isInLexicon("apex")) {
+    std::cerr << "Apparent problem with FlatLexicon #2." << std::endl;
+    return -1;
+  }
+
+  // and so must one on a mapped copy of them; a damaged map is refused
+  MappedLexicon mapped;
+  bool mapOk = writeLexiconMap(flat, "bogtest.lexmap") && MappedLexicon::sniff("bogtest.lexmap") &&
+    mapped.open("bogtest.lexmap") && mapped.fingerprint() == flat.fingerprint();
+  set<string> mappedWords;
+  if(mapOk) {
+    BogglePlayer mappedViewer(mapped.image());
+    mappedViewer.setBoard(4,4,board4);
+    mappedViewer.getAllValidWords(3,&mappedWords);
+  }
+  {
+    std::fstream damage("bogtest.lexmap", std::ios::in | std::ios::out | std::ios::binary);
+    damage.seekp(32 + 4);
+    damage.write("\xff\xff\xff\x7f", 4);
+  }
+  MappedLexicon damaged;
+  if(!mapOk || mappedWords != fixedWords || mapped.image().word_count != 6 ||
+     damaged.open("bogtest.lexmap") || MappedLexicon::sniff("bogtest.bbs")) {
+    std::cerr << "Apparent problem with MappedLexicon #1." << std::endl;
+    return -1;
+  }
+  std::remove("bogtest.lexmap");
+
+  // a pinned snapshot keeps its words while updates are published, and
+  // an updated snapshot searches like a lexicon built from scratch
+  LexiconVersions versions(flat);
+  std::shared_ptr<const FlatLexicon> before = versions.pin();
+  vector<string> adds, removes;
+  adds.push_back("Zeta"); adds.push_back("apexes"); adds.push_back("queens"); adds.push_back("ape");
+  removes.push_back("pea"); removes.push_back("apex"); removes.push_back("nope");
+  size_t changed = versions.apply(adds, removes);
+  std::shared_ptr<const FlatLexicon> after = versions.pin();
+  set<string> lexAfter(lex4);
+  lexAfter.insert("zeta"); lexAfter.insert("apexes"); lexAfter.insert("queens");
+  lexAfter.erase("pea"); lexAfter.erase("apex");
+  BogglePlayer updated, rebuilt;
+  updated.useLexicon(after);
+  rebuilt.buildLexicon(lexAfter);
+  updated.setBoard(4,4,board4);
+  rebuilt.setBoard(4,4,board4);
+  set<string> updatedWords, rebuiltWords;
+  ScoreResult updatedScore, rebuiltScore;
+  updated.getAllValidWords(3,&updatedWords);
+  rebuilt.getAllValidWords(3,&rebuiltWords);
+  updated.scoreBoard(0, SCORE_BY_POINTS, &updatedScore);
+  rebuilt.scoreBoard(0, SCORE_BY_POINTS, &rebuiltScore);
+  if(changed != 5 || versions.version() != 2 || !before->find("pea") || before->find("zeta") ||
+     !after->find("zeta") || after->find("pea") || after->find("apex") || !after->find("apexes") ||
+     before->fingerprint() != flat.fingerprint() ||
+     after->fingerprint() != rebuilt.getLexicon()->fingerprint() ||
+     updatedWords != rebuiltWords || updatedScore.total != rebuiltScore.total ||
+     updatedWords.count("queen") != 1) {
+    std::cerr << "Apparent problem with LexiconVersions #1." << std::endl;
+    return -1;
+  }
+
+  // removal leaves longer and shorter words alone, prunes branches left
+  // without words, and ignores words and prefixes that are not there
+  set<string> lexPrune;
+  lexPrune.insert("ape"); lexPrune.insert("apex"); lexPrune.insert("apexes");
+  lexPrune.insert("zeta"); lexPrune.insert("zebra");
+  LexiconVersions pruned((FlatLexicon(lexPrune)));
+  vector<string> none, gone;
+  gone.push_back("APEX"); gone.push_back("zeta"); gone.push_back("zebra");
+  gone.push_back("ap"); gone.push_back("apricot"); gone.push_back("zeta");
+  size_t removed = pruned.apply(none, gone);
+  std::shared_ptr<const FlatLexicon> prunedNow = pruned.pin();
+  set<string> lexPruned;
+  lexPruned.insert("ape"); lexPruned.insert("apexes");
+  size_t again = pruned.apply(none, gone);
+  vector<string> readd(1, "apex");
+  size_t restored = pruned.apply(readd, none);
+  if(removed != 3 || prunedNow->find("apex") || !prunedNow->find("ape") ||
+     !prunedNow->find("apexes") || prunedNow->getChild(prunedNow->getRoot(), 'z') != NULL ||
+     prunedNow->fingerprint() != FlatLexicon(lexPruned).fingerprint() ||
+     again != 0 || pruned.version() != 3 || restored != 1 || !pruned.pin()->find("apex")) {
+    std::cerr << "Apparent problem with LexiconVersions #2." << std::endl;
+    return -1;
+  }
+
+  // one search of a merged lexicon finds what a search per lexicon
+  // finds, through the kernel, the generic search and interleaved walks
+  vector<set<string> > lists(3);
+  lists[0].insert("ape"); lists[0].insert("apex"); lists[0].insert("queen"); lists[0].insert("zebra");
+  lists[1].insert("ape"); lists[1].insert("pea"); lists[1].insert("nab"); lists[1].insert("xyz");
+  lists[2].insert("queens"); lists[2].insert("zzz");
+  LexiconSet lexicons(lists);
+  bool setsAgree = lexicons.size() == 3 && lexicons.allMask() == 7;
+  for(int mode = 0; mode < 3; mode++) {
+    BogglePlayer merged;
+    merged.setKernelsEnabled(mode != 1);
+    merged.setInterleavedCursors(mode == 2 ? 2 : 0);
+    merged.useLexicon(lexicons.getLexicon());
+    merged.setBoard(4,4,board4);
+    vector<set<string> > all, some;
+    setsAgree = setsAgree && merged.getAllValidWords(3, lexicons, lexicons.allMask(), &all) &&
+      merged.getAllValidWords(3, lexicons, 5, &some) && all.size() == 3 && some.size() == 3 &&
+      some[0] == all[0] && some[1].empty() && some[2] == all[2] && all[2].size() == 1;
+    for(size_t i = 0; setsAgree && i < lists.size(); i++) {
+      BogglePlayer single;
+      single.buildLexicon(lists[i]);
+      single.setBoard(4,4,board4);
+      set<string> singleWords;
+      single.getAllValidWords(3,&singleWords);
+      setsAgree = all[i] == singleWords;
+    }
+  }
+  if(!setsAgree || fixed.getAllValidWords(3, lexicons, 7, &lists)) {
+    std::cerr << "Apparent problem with LexiconSet #1." << std::endl;
+    return -1;
+  }
+
+  // lexicon queries, checked against lex4 plus a few more words
+  set<string> lexQuery(lex4);
+  lexQuery.insert("cat"); lexQuery.insert("cot"); lexQuery.insert("coat");
+  lexQuery.insert("cute"); lexQuery.insert("act"); lexQuery.insert("taco");
+  FlatLexicon queried(lexQuery);
+  vector<string> answers;
+  WordCallback collect = [&answers](const string &word) {
+    answers.push_back(word);
+    return true;
+  };
+  prefixWords(queried, "ap", 0, 0, collect);
+  prefixWords(queried, "", 3, 2, collect);
+  string expected[] = {"ape", "apex", "cat", "coat"};
+  if(answers != vector<string>(expected, expected + 4)) {
+    std::cerr << "Apparent problem with prefixWords #1." << std::endl;
+    return -1;
+  }
+  answers.clear();
+  patternWords(queried, "c?t*", collect);
+  patternWords(queried, "**a*o", collect);
+  string expectedPattern[] = {"cat", "cot", "cute", "taco"};
+  if(answers != vector<string>(expectedPattern, expectedPattern + 4)) {
+    std::cerr << "Apparent problem with patternWords #1." << std::endl;
+    return -1;
+  }
+  answers.clear();
+  anagramWords(queried, "tac", true, collect);
+  anagramWords(queried, "oat?", false, collect);
+  string expectedAnagram[] = {"act", "cat", "act", "cat", "coat", "cot", "taco"};
+  if(answers != vector<string>(expectedAnagram, expectedAnagram + 7) ||
+     anagramWords(queried, "ocat", true, [](const string &) { return false; }) != 1) {
+    std::cerr << "Apparent problem with anagramWords #1." << std::endl;
+    return -1;
+  }
+  vector<pair<string, unsigned> > near;
+  FuzzyCallback collectNear = [&near](const string &word, unsigned distance) {
+    near.push_back(make_pair(word, distance));
+    return true;
+  };
+  fuzzyWords(queried, "cat", 1, collectNear);
+  fuzzyWords(queried, "aple", 1, collectNear);
+  fuzzyWords(queried, "kuete", 2, collectNear);
+  pair<string, unsigned> expectedNear[] = {make_pair("cat", 0u), make_pair("coat", 1u),
+    make_pair("cot", 1u), make_pair("ape", 1u), make_pair("cute", 2u)};
+  if(near != vector<pair<string, unsigned> >(expectedNear, expectedNear + 5) ||
+     fuzzyWords(queried, "cat", MAX_FUZZY_DISTANCE + 1, collectNear) != 0) {
+    std::cerr << "Apparent problem with fuzzyWords #1." << std::endl;
+    return -1;
+  }
+
+  // suggestions put the words on the board first among equally near ones
+  BogglePlayer suggester;
+  vector<string> suggested;
+  bool suggestsAgree = !suggester.suggestWords("cut", 1, 10, false, &suggested);
+  suggester.buildLexicon(lexQuery);
+  suggestsAgree = suggestsAgree && suggester.suggestWords("cut", 1, 10, false, &suggested) &&
+    !suggester.suggestWords("cut", 1, 10, true, &suggested);
+  string cute[] = {"c", "u", "t", "e"};
+  suggester.setBoard(BoardTopology::grid(2, 2), vector<string>(cute, cute + 4));
+  string expectedSuggest[] = {"cute", "cat", "cot"};
+  suggestsAgree = suggestsAgree && suggester.suggestWords("cut", 1, 10, false, &suggested) &&
+    suggested == vector<string>(expectedSuggest, expectedSuggest + 3) &&
+    suggester.suggestWords("cut", 2, 2, false, &suggested) &&
+    suggested == vector<string>(expectedSuggest, expectedSuggest + 2) &&
+    suggester.suggestWords("cut", 2, 10, true, &suggested) &&
+    suggested == vector<string>(expectedSuggest, expectedSuggest + 1) &&
+    suggester.suggestWords("cot", 1, 10, false, &suggested) && suggested.size() == 2 &&
+    suggested[0] == "cat" && suggested[1] == "coat";
+  // a new board is looked at afresh, and once the time allowed is up
+  // candidates are no longer looked for on the board
+  string cots[] = {"c", "o", "t", "x"};
+  suggester.setBoard(BoardTopology::grid(2, 2), vector<string>(cots, cots + 4));
+  suggestsAgree = suggestsAgree && suggester.suggestWords("cut", 2, 10, true, &suggested) &&
+    suggested.size() == 1 && suggested[0] == "cot" &&
+    suggester.suggestWords("cut", 2, 10, true, &suggested, 1e-9) && suggested.empty() &&
+    suggester.suggestWords("cut", 1, 10, false, &suggested, 1e-9) && suggested.size() == 3 &&
+    suggested[0] == "cat";
+  if(!suggestsAgree) {
+    std::cerr << "Apparent problem with suggestWords #1." << std::endl;
+    return -1;
+  }
+
+  // a designed board spells every theme word along the path it reports
+  string themeWords[] = {"queen", "apex", "taco"};
+  vector<string> theme(themeWords, themeWords + 3);
+  SynthOptions synthOptions;
+  synthOptions.seconds = 0;
+  synthOptions.attempts = 4;
+  BoardSynthesizer designer(suggester, BoardTopology::grid(4, 4), theme, synthOptions);
+  SynthResult designed;
+  designer.run(&designed);
+  bool designOk = designer.valid() && designed.found && designed.first_seconds >= 0 &&
+    designed.paths.size() == 3;
+  if(designOk) {
+    suggester.setBoard(BoardTopology::grid(4, 4), designed.dice);
+    for(size_t t = 0; t < theme.size(); t++) {
+      string spelled;
+      for(size_t i = 0; i < designed.paths[t].size(); i++)
+        spelled += designed.dice[designed.paths[t][i]];
+      designOk = designOk && spelled == theme[t] && !suggester.isOnBoard(theme[t]).empty();
+    }
+    ScoreResult designedScore;
+    suggester.scoreBoard(0, SCORE_BY_POINTS, &designedScore);
+    designOk = designOk && designedScore.words == designed.words && designed.words >= 3;
+  }
+  // queen and apex need seven dice, and q must come with its u
+  string crowded[] = {"queen", "apex"};
+  BoardSynthesizer tooSmall(suggester, BoardTopology::grid(2, 3),
+      vector<string>(crowded, crowded + 2), synthOptions);
+  tooSmall.run(&designed);
+  BoardSynthesizer noU(suggester, BoardTopology::grid(4, 4), vector<string>(1, "qat"), synthOptions);
+  if(!designOk || designed.found || !designed.impossible || noU.valid()) {
+    std::cerr << "Apparent problem with BoardSynthesizer #1." << std::endl;
+    return -1;
+  }
+
   delete p;
   return 0;
 
@@ -0,0 +1,261 @@
+#include "flatlexicon.h"
+#include "lexiconloader.h"
+
+#include <atomic>
+#include <cctype>
+#include <thread>
+
+/* Defined by the source lexgen generates, in programs that embed a
+ * lexicon; weak so that every other program links without one */
+extern const FlatLexiconImage EMBEDDED_LEXICON __attribute__((weak));
+
+    const FlatLexiconImage *embeddedLexicon() {
+        return &EMBEDDED_LEXICON;
+    }
+
+    /* Adapts a std::set to the indexed interface of WordList */
+    class StringRefs {
+      public:
+        explicit StringRefs(const std::set<std::string> &words) {
+            refs.reserve(words.size());
+            for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+                if(!it->empty())
+                    refs.push_back(&*it);
+            }
+        }
+        size_t size() const { return refs.size(); }
+        const char *data(size_t i) const { return refs[i]->data(); }
+        unsigned length(size_t i) const { return (unsigned)refs[i]->size(); }
+
+      private:
+        std::vector<const std::string *> refs;
+    };
+
+    /* Whether word is made of the letters a-z only */
+    static bool plainWord(const std::string &word) {
+        for(size_t i = 0; i < word.size(); i++) {
+            if((unsigned char)(word[i] - 'a') >= 26)
+                return false;
+        }
+        return true;
+    }
+
+    static FlatLexNode emptyNode() {
+        FlatLexNode node = { 0, 0, -1 };
+        return node;
+    }
+
+    /**
+     * Lays out the subtrie for words[begin, end), which are sorted and
+     * share their first depth letters, below node n of out. A node's
+     * children are appended as one block before any of their own
+     * subtries, which keeps siblings contiguous.
+     */
+    template <class Words>
+    static void layout(std::vector<FlatLexNode> &out, uint32_t n, const Words &words,
+            size_t begin, size_t end, unsigned depth) {
+
+        // the word equal to the shared prefix, if any, sorts first
+        if(begin < end && words.length(begin) == depth) {
+            out[n].word_id = 0;     // numbered once the trie is complete
+            begin++;
+        }
+
+        unsigned count = 0;
+        size_t starts[26], ends[26];
+        uint32_t mask = 0;
+        for(size_t i = begin; i < end; ) {
+            char letter = words.data(i)[depth];
+            size_t j = i + 1;
+            while(j < end && words.data(j)[depth] == letter)
+                j++;
+            unsigned k = (unsigned char)(letter - 'a');
+            if(k < 26) {
+                mask |= 1u << k;
+                starts[count] = i;
+                ends[count] = j;
+                count++;
+            }
+            i = j;
+        }
+
+        uint32_t first = (uint32_t)out.size();
+        out[n].child_mask = mask;
+        out[n].first_child = mask ? first : 0;
+        out.resize(first + count, emptyNode());
+        for(unsigned c = 0; c < count; c++) {
+            layout(out, first + c, words, starts[c], ends[c], depth + 1);
+        }
+    }
+
+    /**
+     * Builds the whole trie: each first letter's subtrie is laid out
+     * separately (in parallel when threads > 1) and the pieces are then
+     * appended behind the root's child block with their indices shifted.
+     */
+    template <class Words>
+    static void build(std::vector<FlatLexNode> &out, const Words &words, unsigned threads) {
+        std::vector<size_t> bounds;
+        std::vector<unsigned> letters;
+        for(size_t i = 0; i < words.size(); ) {
+            char letter = words.data(i)[0];
+            size_t j = i + 1;
+            while(j < words.size() && words.data(j)[0] == letter)
+                j++;
+            unsigned k = (unsigned char)(letter - 'a');
+            if(k < 26) {
+                letters.push_back(k);
+                bounds.push_back(i);
+                bounds.push_back(j);
+            }
+            i = j;
+        }
+
+        size_t runs = letters.size();
+        std::vector<std::vector<FlatLexNode> > subtries(runs);
+        std::atomic<size_t> next(0);
+        auto work = [&]() {
+            for(size_t r = next++; r < runs; r = next++) {
+                subtries[r].assign(1, emptyNode());
+                layout(subtries[r], 0, words, bounds[2 * r], bounds[2 * r + 1], 1);
+            }
+        };
+        if(threads > runs)
+            threads = (unsigned)runs;
+        std::vector<std::thread> pool;
+        for(unsigned t = 1; t < threads; t++) {
+            pool.push_back(std::thread(work));
+        }
+        work();
+        for(size_t t = 0; t < pool.size(); t++) {
+            pool[t].join();
+        }
+
+        out.assign(1 + runs, emptyNode());
+        for(size_t r = 0; r < runs; r++) {
+            out[0].child_mask |= 1u << letters[r];
+        }
+        out[0].first_child = runs ? 1 : 0;
+
+        for(size_t r = 0; r < runs; r++) {
+            std::vector<FlatLexNode> &sub = subtries[r];
+            // node i > 0 of the subtrie lands at base + i - 1
+            uint32_t base = (uint32_t)out.size();
+            for(size_t i = 0; i < sub.size(); i++) {
+                if(sub[i].child_mask)
+                    sub[i].first_child += base - 1;
+            }
+            out[1 + r] = sub[0];
+            out.insert(out.end(), sub.begin() + 1, sub.end());
+            std::vector<FlatLexNode>().swap(sub);
+        }
+    }
+
+    FlatLexicon::FlatLexicon() : storage(1, emptyNode()) {
+        nodes = storage.data();
+        root = 0;
+        node_count = 1;
+        word_count = 0;
+        ranked_ids = true;
+    }
+
+    FlatLexicon::FlatLexicon(const WordList &words, unsigned threads) {
+        build(storage, words, threads);
+        nodes = storage.data();
+        root = 0;
+        node_count = (uint32_t)storage.size();
+        numberWords();
+        ranked_ids = true;
+    }
+
+    FlatLexicon::FlatLexicon(const std::set<std::string> &words,
+            std::vector<std::string> *rejected) {
+        // a list that is already plain lowercase is laid out in place;
+        // any other is lowercased into a copy, which sorts differently
+        bool plain = true;
+        for(std::set<std::string>::const_iterator it = words.begin(); plain && it != words.end(); ++it) {
+            plain = plainWord(*it);
+        }
+        if(plain) {
+            build(storage, StringRefs(words), 1);
+        }
+        else {
+            std::set<std::string> lowered;
+            for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+                std::string word = *it;
+                for(size_t i = 0; i < word.size(); i++) {
+                    word[i] = (char)tolower((unsigned char)word[i]);
+                }
+                if(plainWord(word))
+                    lowered.insert(word);
+                else if(rejected != NULL)
+                    rejected->push_back(*it);
+            }
+            build(storage, StringRefs(lowered), 1);
+        }
+        nodes = storage.data();
+        root = 0;
+        node_count = (uint32_t)storage.size();
+        numberWords();
+        ranked_ids = true;
+    }
+
+    FlatLexicon::FlatLexicon(const FlatLexiconImage &image) {
+        nodes = image.nodes;
+        root = 0;
+        node_count = image.node_count;
+        word_count = image.word_count;
+        ranked_ids = true;
+    }
+
+    FlatLexicon::FlatLexicon(const std::shared_ptr<const FlatLexNode> &shared, uint32_t root,
+            uint32_t node_count, uint32_t word_count, bool ranked)
+            : shared(shared), nodes(shared.get()), root(root), node_count(node_count),
+              word_count(word_count), ranked_ids(ranked) {}
+
+    /* Preorder walk in letter order visits words in sorted order */
+    void FlatLexicon::numberWords() {
+        word_count = 0;
+        std::vector<uint32_t> stack(1, 0);
+        while(!stack.empty()) {
+            FlatLexNode &node = storage[stack.back()];
+            stack.pop_back();
+            if(node.word_id >= 0)
+                node.word_id = (int32_t)word_count++;
+            unsigned children = __builtin_popcount(node.child_mask);
+            for(unsigned c = children; c > 0; c--) {
+                stack.push_back(node.first_child + c - 1);
+            }
+        }
+    }
+
+    /* Hashes the shape of the trie in the preorder numberWords uses,
+     * which depends only on the words and not on the node layout */
+    uint64_t FlatLexicon::fingerprint() const {
+        uint64_t hash = 14695981039346656037ull;
+        std::vector<uint32_t> stack(1, root);
+        while(!stack.empty()) {
+            const FlatLexNode &node = nodes[stack.back()];
+            stack.pop_back();
+            uint64_t token = ((uint64_t)node.child_mask << 1) | (node.word_id >= 0);
+            hash = (hash ^ token) * 1099511628211ull;
+            unsigned children = __builtin_popcount(node.child_mask);
+            for(unsigned c = children; c > 0; c--) {
+                stack.push_back(node.first_child + c - 1);
+            }
+        }
+        return hash;
+    }
+
+    bool FlatLexicon::find(const std::string &word) const {
+        const FlatLexNode *node = getRoot();
+        for(size_t i = 0; i < word.size() && node != NULL; i++) {
+            node = getChild(node, word[i]);
+        }
+        return node != NULL && node->word_id >= 0;
+    }
+
+    FlatLexiconImage FlatLexicon::image() const {
+        FlatLexiconImage image = { nodes, node_count, word_count };
+        return image;
+    }
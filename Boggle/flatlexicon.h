@@ -0,0 +1,151 @@
+#ifndef FLATLEXICON_H
+#define FLATLEXICON_H
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class LexiconVersions;
+class WordList;
+
+/**
+ * One node of a FlatLexicon. The children of a node are stored next to
+ * each other in letter order, so a child is found from the parent's
+ * letter mask alone: the child for letter k sits at first_child plus the
+ * number of mask bits below k.
+ */
+struct FlatLexNode {
+    /* Bit k is set if there is a child for letter 'a' + k */
+    uint32_t child_mask;
+
+    /* Index of the node's first (lowest letter) child */
+    uint32_t first_child;
+
+    /* Id of the word ending at this node, or -1. The ids of a lexicon
+     * built from a word list are the words' ranks in sorted order. */
+    int32_t word_id;
+};
+
+/**
+ * The arrays of a FlatLexicon that lives outside the heap, such as one
+ * compiled into the program by lexgen (see EMBEDDED_LEXICON).
+ */
+struct FlatLexiconImage {
+    const FlatLexNode *nodes;
+    uint32_t node_count;
+    uint32_t word_count;
+};
+
+/**
+ * Read-only multiway trie over the letters a-z in one flat array of
+ * FlatLexNodes, with node 0 as the root (except in the snapshots of
+ * LexiconVersions). Lookups touch one 12 byte node per letter instead
+ * of a std::map, and the whole trie can be written out as constant data
+ * and used again without being rebuilt.
+ *
+ * Words are stored in lowercase; words containing characters other
+ * than a-z cannot be stored and are left out.
+ */
+class FlatLexicon {
+  public:
+    /* An empty lexicon */
+    FlatLexicon();
+
+    /**
+     * Builds the trie from a sorted word list. The subtries under each
+     * first letter are laid out on up to threads threads at once.
+     */
+    explicit FlatLexicon(const WordList &words, unsigned threads = 1);
+
+    /**
+     * Builds the trie from a set of words in any case. Words that still
+     * hold characters other than a-z once lowercased are left out, and
+     * appended as given to rejected if it is not NULL.
+     */
+    explicit FlatLexicon(const std::set<std::string> &words,
+            std::vector<std::string> *rejected = NULL);
+
+    /* Uses the image's arrays in place; they must outlive the lexicon */
+    explicit FlatLexicon(const FlatLexiconImage &image);
+
+    const FlatLexNode *getRoot() const { return nodes + root; }
+
+    /* Child of node for letter, or NULL */
+    const FlatLexNode *getChild(const FlatLexNode *node, char letter) const {
+        unsigned k = (unsigned char)(letter - 'a');
+        if(k >= 26 || !((node->child_mask >> k) & 1))
+            return NULL;
+        return nodes + node->first_child
+            + __builtin_popcount(node->child_mask & ((1u << k) - 1));
+    }
+
+    /* First child of node; its siblings follow in letter order */
+    const FlatLexNode *firstChild(const FlatLexNode *node) const {
+        return nodes + node->first_child;
+    }
+
+    /* Whether word (lowercase) is in the lexicon */
+    bool find(const std::string &word) const;
+
+    uint32_t nodeCount() const { return node_count; }
+
+    /* Index of node in the node array, for data kept beside the trie */
+    uint32_t indexOf(const FlatLexNode *node) const { return (uint32_t)(node - nodes); }
+
+    /**
+     * Every word id is below wordCount(). For a lexicon built from a
+     * word list that is the number of words; a snapshot updated by
+     * LexiconVersions numbers added words after the others and leaves
+     * the ids of removed ones unused.
+     */
+    uint32_t wordCount() const { return word_count; }
+
+    /* Whether word ids are exactly the ranks 0..wordCount()-1 in sorted
+     * order, as they are unless the lexicon was updated in place */
+    bool ranked() const { return ranked_ids; }
+
+    /* The arrays backing this lexicon, for writing it out; the root
+     * must be node 0, as in every lexicon that was not updated */
+    FlatLexiconImage image() const;
+
+    /**
+     * A 64 bit hash of the words in the lexicon, the same however and
+     * in whichever run the trie was built. Walks the whole trie.
+     */
+    uint64_t fingerprint() const;
+
+  private:
+    friend class LexiconVersions;
+
+    FlatLexicon(const FlatLexicon &);
+    FlatLexicon &operator=(const FlatLexicon &);
+
+    /* A view of nodes shared with other snapshots (see LexiconVersions) */
+    FlatLexicon(const std::shared_ptr<const FlatLexNode> &shared, uint32_t root,
+            uint32_t node_count, uint32_t word_count, bool ranked);
+
+    /* Gives every word node its rank in sorted order */
+    void numberWords();
+
+    /* Nodes built by this object; empty when viewing an image or
+     * shared nodes */
+    std::vector<FlatLexNode> storage;
+    std::shared_ptr<const FlatLexNode> shared;
+
+    const FlatLexNode *nodes;
+    uint32_t root;
+    uint32_t node_count;
+    uint32_t word_count;
+    bool ranked_ids;
+};
+
+/**
+ * The lexicon compiled into this program, or NULL if it has none.
+ * Targets get one by naming a word list in their _EMBED variable in the
+ * Makefile, which links in the source that lexgen generates from it.
+ */
+const FlatLexiconImage *embeddedLexicon();
+
+#endif // FLATLEXICON_H
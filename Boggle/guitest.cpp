@@ -0,0 +1,54 @@
+/******************************************************
+ * QtTest of the window's computer play, which runs without a display:
+ *   make guitest && QT_QPA_PLATFORM=offscreen ./guitest
+ * ****************************************************/
+
+#include "bogglestream.h"
+#include "mainwindow.h"
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+#include <QtWidgets/QPushButton>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// brd.txt holds 254 words of boglex.txt of at least MIN_LENGTH letters
+static const unsigned int MIN_LENGTH = 4;
+static const int BRD_WORDS = 254;
+static const int SOLVE_MSEC = 60000;
+
+class GuiTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void computerPlay();
+};
+
+void GuiTest::computerPlay() {
+  std::ifstream in("brd.txt");
+  unsigned int rows, cols;
+  std::vector<std::string> dice;
+  QVERIFY(readTextBoard(in, &rows, &cols, &dice));
+  std::vector<std::string *> board;
+  for(unsigned int r = 0; r < rows; r++)
+    board.push_back(&dice[r * cols]);
+
+  MainWindow window("boglex.txt", rows, cols, MIN_LENGTH);
+  QPushButton *play = window.findChild<QPushButton *>("computerPlayButton");
+  QVERIFY(play != NULL);
+  QSignalSpy finished(&window, &MainWindow::computerPlayFinished);
+
+  // a solve abandoned for a new board reports nothing; only the solve
+  // of the board the window ends up showing finishes
+  QTest::mouseClick(play, Qt::LeftButton);
+  window.newCustomBoard(rows, cols, &board[0]);
+  QTest::mouseClick(play, Qt::LeftButton);
+  QVERIFY(finished.wait(SOLVE_MSEC));
+  QTest::qWait(100);
+  QCOMPARE(finished.count(), 1);
+  QCOMPARE(finished.at(0).at(0).toInt(), BRD_WORDS);
+}
+
+QTEST_MAIN(GuiTest)
+#include "guitest.moc"
@@ -0,0 +1,79 @@
+/**
+ * lexgen: compiles a word list into C++ source defining EMBEDDED_LEXICON.
+ *
+ * The generated file holds the FlatLexicon node array as constant data,
+ * so it lands in .rodata and a program linked with it can construct a
+ * BogglePlayer from embeddedLexicon() without any file I/O or trie
+ * construction. The Makefile runs this for targets with an _EMBED
+ * variable.
+ *
+ * With -m the trie is written as a lexicon map instead (see
+ * lexiconmap.h), which programs map at run time; bogglebatch -L takes
+ * one.
+ *
+ * usage: lexgen [-m] WORDFILE OUTFILE
+ */
+
+#include "flatlexicon.h"
+#include "lexiconloader.h"
+#include "lexiconmap.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    bool map = argc == 4 && strcmp(argv[1], "-m") == 0;
+    if(argc != (map ? 4 : 3)) {
+        std::cerr << "usage: " << argv[0] << " [-m] WORDFILE OUTFILE" << std::endl;
+        return 1;
+    }
+    if(map)
+        argv++;
+
+    WordList words;
+    if(!loadWordList(argv[1], &words)) {
+        std::cerr << "Could not read word list " << argv[1] << std::endl;
+        return 1;
+    }
+    FlatLexicon lexicon(words);
+    FlatLexiconImage image = lexicon.image();
+
+    if(map) {
+        if(!writeLexiconMap(lexicon, argv[2])) {
+            perror(argv[2]);
+            return 1;
+        }
+        std::cout << "Mapped " << image.word_count << " words (" << image.node_count
+            << " nodes) from " << argv[1] << " in " << argv[2] << std::endl;
+        return 0;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if(out == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    fprintf(out, "// Generated by lexgen from %s; do not edit.\n"
+            "// %u words, %u nodes.\n\n"
+            "#include \"flatlexicon.h\"\n\n"
+            "static const FlatLexNode NODES[%u] = {\n",
+            argv[1], image.word_count, image.node_count, image.node_count);
+    for(uint32_t i = 0; i < image.node_count; i++) {
+        const FlatLexNode &n = image.nodes[i];
+        fprintf(out, "{0x%x,%u,%d},%s", n.child_mask, n.first_child, n.word_id,
+                i % 6 == 5 ? "\n" : "");
+    }
+    fprintf(out, "\n};\n\n"
+            "extern const FlatLexiconImage EMBEDDED_LEXICON;\n"
+            "const FlatLexiconImage EMBEDDED_LEXICON = { NODES, %uu, %uu };\n",
+            image.node_count, image.word_count);
+
+    if(fclose(out) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    std::cout << "Embedded " << image.word_count << " words (" << image.node_count
+        << " nodes) from " << argv[1] << " in " << argv[2] << std::endl;
+    return 0;
+}
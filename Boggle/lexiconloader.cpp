@@ -0,0 +1,154 @@
+#include "lexiconloader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/* Size of each read from the dictionary file */
+static const size_t CHUNK_SIZE = 1 << 20;
+
+/* Words longer than this are cut off; lengths are stored in a byte */
+static const size_t MAX_WORD_LENGTH = 255;
+
+    size_t WordList::memoryUsage() const {
+        return chars.capacity() + starts.capacity() * sizeof(uint32_t)
+            + lengths.capacity();
+    }
+
+    /* Lowercases ASCII letters in place. Written without branches so
+     * the compiler turns it into a vector loop. */
+    static void lowerCase(char *p, size_t n) {
+        for(size_t i = 0; i < n; i++) {
+            unsigned char c = (unsigned char)p[i];
+            p[i] = (char)(c + (((unsigned char)(c - 'A') < 26) << 5));
+        }
+    }
+
+    /* Orders word indices by the words they refer to */
+    struct WordLess {
+        const char *chars;
+        const uint32_t *starts;
+        const uint8_t *lengths;
+
+        int compare(uint32_t a, uint32_t b) const {
+            unsigned la = lengths[a], lb = lengths[b];
+            int c = memcmp(chars + starts[a], chars + starts[b], la < lb ? la : lb);
+            return c != 0 ? c : (int)la - (int)lb;
+        }
+        bool operator()(uint32_t a, uint32_t b) const {
+            return compare(a, b) < 0;
+        }
+    };
+
+    /* Index entry for sorting: the first eight characters packed big
+     * endian, so integer order matches string order */
+    struct SortKey {
+        uint64_t prefix;
+        uint32_t index;
+    };
+
+    static uint64_t prefixKey(const char *word, unsigned length) {
+        uint64_t key = 0;
+        for(unsigned i = 0; i < 8; i++) {
+            key = (key << 8) | (i < length ? (unsigned char)word[i] : 0);
+        }
+        return key;
+    }
+
+    bool loadWordList(const char *filename, WordList *words) {
+        FILE *in = fopen(filename, "rb");
+        if(in == NULL)
+            return false;
+
+        std::string &chars = words->chars;
+        std::vector<uint32_t> &starts = words->starts;
+        std::vector<uint8_t> &lengths = words->lengths;
+        chars.clear();
+        starts.clear();
+        lengths.clear();
+
+        // read straight into the final buffer; the line split below
+        // runs behind the reads, carrying a partial last line over
+        size_t scanned = 0;
+        size_t line_start = 0;
+        while(true) {
+            size_t old = chars.size();
+            chars.resize(old + CHUNK_SIZE);
+            size_t got = fread(&chars[old], 1, CHUNK_SIZE, in);
+            chars.resize(old + got);
+            if(chars.size() > UINT32_MAX) {
+                fclose(in);
+                return false;
+            }
+            lowerCase(&chars[old], got);
+
+            bool last = got < CHUNK_SIZE;
+            if(last && !chars.empty() && chars[chars.size() - 1] != '\n')
+                chars.push_back('\n');
+
+            const char *base = chars.data();
+            while(scanned < chars.size()) {
+                const char *nl = (const char *)memchr(base + scanned, '\n',
+                        chars.size() - scanned);
+                if(nl == NULL) {
+                    scanned = chars.size();
+                    break;
+                }
+                size_t end = nl - base;
+                size_t len = end - line_start;
+                if(len > 0 && base[end - 1] == '\r')
+                    len--;
+                if(len > 0) {
+                    starts.push_back((uint32_t)line_start);
+                    lengths.push_back((uint8_t)std::min(len, MAX_WORD_LENGTH));
+                }
+                scanned = line_start = end + 1;
+            }
+            if(last)
+                break;
+        }
+        fclose(in);
+
+        WordLess less = { chars.data(), starts.data(), lengths.data() };
+        size_t n = starts.size();
+        bool sorted = true;
+        for(size_t i = 1; i < n && sorted; i++) {
+            sorted = less.compare(i - 1, i) < 0;
+        }
+        if(sorted)
+            return true;
+
+        // sort an index keyed on each word's first eight characters so
+        // most comparisons never touch the character buffer, then
+        // rebuild the offset and length arrays in order, dropping
+        // duplicates
+        std::vector<SortKey> keys(n);
+        for(size_t i = 0; i < n; i++) {
+            keys[i].prefix = prefixKey(chars.data() + starts[i], lengths[i]);
+            keys[i].index = (uint32_t)i;
+        }
+        std::sort(keys.begin(), keys.end(), [&](const SortKey &a, const SortKey &b) {
+            if(a.prefix != b.prefix)
+                return a.prefix < b.prefix;
+            return less(a.index, b.index);
+        });
+        std::vector<uint32_t> order(n);
+        for(size_t i = 0; i < n; i++) {
+            order[i] = keys[i].index;
+        }
+        std::vector<SortKey>().swap(keys);
+
+        std::vector<uint32_t> sorted_starts;
+        std::vector<uint8_t> sorted_lengths;
+        sorted_starts.reserve(n);
+        sorted_lengths.reserve(n);
+        for(size_t i = 0; i < n; i++) {
+            if(i > 0 && less.compare(order[i - 1], order[i]) == 0)
+                continue;
+            sorted_starts.push_back(starts[order[i]]);
+            sorted_lengths.push_back(lengths[order[i]]);
+        }
+        starts.swap(sorted_starts);
+        lengths.swap(sorted_lengths);
+        return true;
+    }
@@ -0,0 +1,53 @@
+#ifndef LEXICONLOADER_H
+#define LEXICONLOADER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A sorted, duplicate free list of lowercase words packed into a single
+ * character buffer. This is what the streaming loader produces and what
+ * the FlatLexicon constructor builds from, so a dictionary file is held
+ * in memory once instead of once per std::string.
+ */
+class WordList {
+  public:
+    /* Number of distinct words */
+    size_t size() const { return starts.size(); }
+
+    /* Characters of the i-th word; not NUL terminated */
+    const char *data(size_t i) const { return &chars[starts[i]]; }
+    unsigned length(size_t i) const { return lengths[i]; }
+
+    /* Copy of the i-th word */
+    std::string word(size_t i) const {
+        return std::string(data(i), length(i));
+    }
+
+    /* Bytes held by the buffer and the index */
+    size_t memoryUsage() const;
+
+  private:
+    friend bool loadWordList(const char *filename, WordList *words);
+
+    /* File contents, lowercased, with line breaks left in place */
+    std::string chars;
+
+    /* Offset into chars and length of each word, in sorted order */
+    std::vector<uint32_t> starts;
+    std::vector<uint8_t> lengths;
+};
+
+/**
+ * Reads a one-word-per-line file into words. The file is read in large
+ * chunks straight into the WordList buffer, lowercased in place, split
+ * on line breaks (empty lines are skipped, "\r\n" is accepted) and then
+ * sorted and deduplicated. Input that is already sorted, like
+ * boglex.txt, skips the sort.
+ *
+ * Returns false if the file cannot be read or holds more than 4GB.
+ */
+bool loadWordList(const char *filename, WordList *words);
+
+#endif // LEXICONLOADER_H
@@ -0,0 +1,124 @@
+#include "lexiconmap.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAP_MAGIC[8] = { 'B', 'O', 'G', 'L', 'E', 'X', 'M', '1' };
+
+/* The header, as laid out in the file */
+struct MapHeader {
+    char magic[8];
+    uint32_t node_count;
+    uint32_t word_count;
+    uint64_t fingerprint;
+    uint32_t node_size;
+    uint32_t reserved;
+};
+
+static const size_t MAP_HEADER_BYTES = 32;
+
+    bool writeLexiconMap(const FlatLexicon &lexicon, const std::string &filename) {
+        FlatLexiconImage image = lexicon.image();
+        MapHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAP_MAGIC, sizeof(MAP_MAGIC));
+        header.node_count = image.node_count;
+        header.word_count = image.word_count;
+        header.fingerprint = lexicon.fingerprint();
+        header.node_size = sizeof(FlatLexNode);
+
+        FILE *out = fopen(filename.c_str(), "wb");
+        if(out == NULL)
+            return false;
+        bool written = fwrite(&header, MAP_HEADER_BYTES, 1, out) == 1 &&
+            fwrite(image.nodes, sizeof(FlatLexNode), image.node_count, out) == image.node_count;
+        return fclose(out) == 0 && written;
+    }
+
+    MappedLexicon::MappedLexicon() : mapped(NULL), mapped_size(0), print(0) {
+        view.nodes = NULL;
+        view.node_count = 0;
+        view.word_count = 0;
+    }
+
+    MappedLexicon::~MappedLexicon() {
+        close();
+    }
+
+    void MappedLexicon::close() {
+        if(mapped != NULL)
+            munmap(mapped, mapped_size);
+        mapped = NULL;
+        mapped_size = 0;
+        view.nodes = NULL;
+        view.node_count = 0;
+        view.word_count = 0;
+        print = 0;
+    }
+
+    bool MappedLexicon::open(const std::string &filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < MAP_HEADER_BYTES + sizeof(FlatLexNode)) {
+            ::close(fd);
+            return false;
+        }
+        // shared, so that every process mapping the file reads the
+        // same pages of the page cache
+        void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED)
+            return false;
+        mapped = base;
+        mapped_size = st.st_size;
+
+        MapHeader header;
+        memcpy(&header, mapped, MAP_HEADER_BYTES);
+        if(memcmp(header.magic, MAP_MAGIC, sizeof(MAP_MAGIC)) != 0 ||
+                header.node_size != sizeof(FlatLexNode) || header.node_count == 0 ||
+                mapped_size != MAP_HEADER_BYTES + (size_t)header.node_count * sizeof(FlatLexNode)) {
+            close();
+            return false;
+        }
+
+        // children are laid out after their parent, so checking that
+        // much once here keeps every walk of a bad file finite and
+        // inside the mapping
+        const FlatLexNode *nodes = (const FlatLexNode *)((const char *)mapped + MAP_HEADER_BYTES);
+        for(uint32_t i = 0; i < header.node_count; i++) {
+            const FlatLexNode &node = nodes[i];
+            bool valid = (node.child_mask >> 26) == 0 &&
+                (node.word_id == -1 || (node.word_id >= 0 && (uint32_t)node.word_id < header.word_count));
+            if(valid && node.child_mask != 0)
+                valid = node.first_child > i && (uint64_t)node.first_child
+                    + __builtin_popcount(node.child_mask) <= header.node_count;
+            if(!valid) {
+                close();
+                return false;
+            }
+        }
+        view.nodes = nodes;
+        view.node_count = header.node_count;
+        view.word_count = header.word_count;
+        print = header.fingerprint;
+        return true;
+    }
+
+    bool MappedLexicon::sniff(const std::string &filename) {
+        char magic[sizeof(MAP_MAGIC)];
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        bool matches = read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) &&
+            memcmp(magic, MAP_MAGIC, sizeof(magic)) == 0;
+        ::close(fd);
+        return matches;
+    }
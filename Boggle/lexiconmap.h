@@ -0,0 +1,68 @@
+#ifndef LEXICONMAP_H
+#define LEXICONMAP_H
+
+#include <stdint.h>
+#include <string>
+
+#include "flatlexicon.h"
+
+/**
+ * Lexicon maps: a FlatLexicon's node array in a file, searched in place
+ * through a read-only shared mapping. Every process mapping the same
+ * file shares one copy of the trie in the page cache, and opening a map
+ * costs no parsing or trie building.
+ *
+ * A map starts with a 32 byte header:
+ *
+ *   0   8 bytes   magic "BOGLEXM1"
+ *   8   u32       number of nodes
+ *   12  u32       number of words
+ *   16  u64       the lexicon's fingerprint (see FlatLexicon)
+ *   24  u32       size of a node in bytes, 12
+ *   28  u32       reserved, 0
+ *
+ * followed by the nodes as FlatLexNodes, root first. Header and nodes
+ * are in the byte order of the machine that wrote them; a map written
+ * on a machine of the other order fails to open.
+ */
+
+/* Writes lexicon, which must have its root at node 0 (see
+ * FlatLexicon::image), as a map in filename */
+bool writeLexiconMap(const FlatLexicon &lexicon, const std::string &filename);
+
+/**
+ * A lexicon map mapped into memory, to hand to FlatLexicon or
+ * BogglePlayer as an image. The image is valid while the map is open.
+ */
+class MappedLexicon {
+  public:
+    MappedLexicon();
+    ~MappedLexicon();
+
+    /**
+     * Maps filename. Returns false if it can not be read, is not a
+     * lexicon map, or has a node pointing outside the node array.
+     */
+    bool open(const std::string &filename);
+
+    const FlatLexiconImage &image() const { return view; }
+
+    /* The fingerprint recorded when the map was written */
+    uint64_t fingerprint() const { return print; }
+
+    /* Whether filename starts like a lexicon map */
+    static bool sniff(const std::string &filename);
+
+  private:
+    MappedLexicon(const MappedLexicon &);
+    MappedLexicon &operator=(const MappedLexicon &);
+
+    void close();
+
+    void *mapped;
+    size_t mapped_size;
+    FlatLexiconImage view;
+    uint64_t print;
+};
+
+#endif // LEXICONMAP_H
@@ -0,0 +1,305 @@
+#include "lexiconquery.h"
+
+#include <stdint.h>
+
+    /* State shared by the walks below: the path spelled so far and the
+     * callback the answers go to */
+    class QueryWalk {
+      public:
+        QueryWalk(const FlatLexicon &lexicon, const WordCallback &callback)
+            : lexicon(lexicon), callback(callback), passed(0), stopped(false) {}
+
+        void emit() {
+            passed++;
+            if(!callback(word))
+                stopped = true;
+        }
+
+        const FlatLexicon &lexicon;
+        const WordCallback &callback;
+        std::string word;
+        size_t passed;
+        bool stopped;
+    };
+
+    /* Number of words in the subtrie under node. Word ids are ranks in
+     * sorted order, which is the order of a walk of the trie, so they
+     * run without gaps from the first word of the subtrie to its last. */
+    static size_t subtrieWords(const FlatLexicon &lexicon, const FlatLexNode *node) {
+        if(node->word_id < 0 && node->child_mask == 0)
+            return 0;       // root of an empty lexicon
+        const FlatLexNode *first = node;
+        while(first->word_id < 0) {
+            first = lexicon.firstChild(first);
+        }
+        const FlatLexNode *last = node;
+        while(last->child_mask != 0) {
+            last = lexicon.firstChild(last) + __builtin_popcount(last->child_mask) - 1;
+        }
+        return (size_t)(last->word_id - first->word_id) + 1;
+    }
+
+    class PrefixWalk : public QueryWalk {
+      public:
+        PrefixWalk(const FlatLexicon &lexicon, const WordCallback &callback,
+                size_t offset, size_t limit)
+            : QueryWalk(lexicon, callback), skip(offset), limit(limit) {}
+
+        void visit(const FlatLexNode *node) {
+            if(skip > 0 && lexicon.ranked()) {
+                size_t words = subtrieWords(lexicon, node);
+                if(words <= skip) {
+                    skip -= words;
+                    return;
+                }
+            }
+            if(node->word_id >= 0) {
+                if(skip > 0) {
+                    skip--;
+                }
+                else {
+                    emit();
+                    if(limit != 0 && passed == limit)
+                        stopped = true;
+                }
+            }
+            const FlatLexNode *child = lexicon.firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0 && !stopped;
+                    options &= options - 1, child++) {
+                word.push_back((char)('a' + __builtin_ctz(options)));
+                visit(child);
+                word.pop_back();
+            }
+        }
+
+      private:
+        size_t skip, limit;
+    };
+
+    size_t prefixWords(const FlatLexicon &lexicon, const std::string &prefix,
+            size_t offset, size_t limit, const WordCallback &callback) {
+        const FlatLexNode *node = lexicon.getRoot();
+        for(size_t i = 0; i < prefix.size() && node != NULL; i++) {
+            node = lexicon.getChild(node, prefix[i]);
+        }
+        if(node == NULL)
+            return 0;
+
+        PrefixWalk walk(lexicon, callback, offset, limit);
+        walk.word = prefix;
+        walk.visit(node);
+        return walk.passed;
+    }
+
+    /**
+     * Runs the pattern as a nondeterministic automaton whose states are
+     * the pattern positions, bit p of a state set meaning that the
+     * first p pattern characters have been matched.
+     */
+    class PatternWalk : public QueryWalk {
+      public:
+        PatternWalk(const FlatLexicon &lexicon, const WordCallback &callback,
+                const std::string &pattern)
+            : QueryWalk(lexicon, callback), stars(0), accept((uint64_t)1 << pattern.size()) {
+            for(unsigned k = 0; k < 26; k++) {
+                advance[k] = 0;
+            }
+            for(size_t p = 0; p < pattern.size(); p++) {
+                uint64_t bit = (uint64_t)1 << p;
+                unsigned k = (unsigned char)(pattern[p] - 'a');
+                if(pattern[p] == '*')
+                    stars |= bit;
+                else if(pattern[p] == '?') {
+                    for(unsigned j = 0; j < 26; j++) {
+                        advance[j] |= bit;
+                    }
+                }
+                else if(k < 26)
+                    advance[k] |= bit;
+            }
+        }
+
+        /* Adds the positions reached by letting stars match nothing */
+        uint64_t closure(uint64_t states) const {
+            for(;;) {
+                uint64_t more = states | ((states & stars) << 1);
+                if(more == states)
+                    return states;
+                states = more;
+            }
+        }
+
+        void visit(const FlatLexNode *node, uint64_t states) {
+            if(node->word_id >= 0 && (states & accept))
+                emit();
+            const FlatLexNode *child = lexicon.firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0 && !stopped;
+                    options &= options - 1, child++) {
+                unsigned k = __builtin_ctz(options);
+                uint64_t next = closure(((states & advance[k]) << 1) | (states & stars));
+                if(next == 0)
+                    continue;
+                word.push_back((char)('a' + k));
+                visit(child, next);
+                word.pop_back();
+            }
+        }
+
+      private:
+        /* Positions holding a star, and those a letter can step past */
+        uint64_t stars;
+        uint64_t advance[26];
+        uint64_t accept;
+    };
+
+    size_t patternWords(const FlatLexicon &lexicon, const std::string &pattern,
+            const WordCallback &callback) {
+        if(pattern.size() > 63)
+            return 0;
+        PatternWalk walk(lexicon, callback, pattern);
+        walk.visit(lexicon.getRoot(), walk.closure(1));
+        return walk.passed;
+    }
+
+    class AnagramWalk : public QueryWalk {
+      public:
+        AnagramWalk(const FlatLexicon &lexicon, const WordCallback &callback,
+                const std::string &tiles, bool use_all)
+            : QueryWalk(lexicon, callback), blanks(0), left(0), use_all(use_all) {
+            for(unsigned k = 0; k < 26; k++) {
+                counts[k] = 0;
+            }
+            for(size_t i = 0; i < tiles.size(); i++) {
+                unsigned k = (unsigned char)(tiles[i] - 'a');
+                if(tiles[i] == '?')
+                    blanks++;
+                else if(k < 26)
+                    counts[k]++;
+                else
+                    continue;
+                left++;
+            }
+        }
+
+        void visit(const FlatLexNode *node) {
+            if(node->word_id >= 0 && (!use_all || left == 0))
+                emit();
+            if(left == 0)
+                return;
+            const FlatLexNode *child = lexicon.firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0 && !stopped;
+                    options &= options - 1, child++) {
+                unsigned k = __builtin_ctz(options);
+                // a letter's own tile is always at least as good as a
+                // blank, so blanks are only spent on missing letters
+                unsigned &pool = counts[k] > 0 ? counts[k] : blanks;
+                if(pool == 0)
+                    continue;
+                pool--;
+                left--;
+                word.push_back((char)('a' + k));
+                visit(child);
+                word.pop_back();
+                left++;
+                pool++;
+            }
+        }
+
+      private:
+        unsigned counts[26];
+        unsigned blanks;
+        size_t left;
+        bool use_all;
+    };
+
+    size_t anagramWords(const FlatLexicon &lexicon, const std::string &tiles, bool use_all,
+            const WordCallback &callback) {
+        AnagramWalk walk(lexicon, callback, tiles, use_all);
+        walk.visit(lexicon.getRoot());
+        return walk.passed;
+    }
+
+    /**
+     * The bit-parallel Levenshtein automaton: states[d] has bit p set
+     * if the trie path so far can be turned into the first p
+     * characters of the query with d edits. Its answers carry a
+     * distance, so it keeps its own callback rather than QueryWalk's.
+     */
+    class FuzzyWalk {
+      public:
+        FuzzyWalk(const FlatLexicon &lexicon, const FuzzyCallback &callback,
+                const std::string &query, unsigned max_distance)
+            : lexicon(lexicon), callback(callback), passed(0), stopped(false),
+              max_distance(max_distance), accept((uint64_t)1 << query.size()),
+              live(((uint64_t)1 << (query.size() + 1)) - 1) {
+            for(unsigned k = 0; k < 26; k++) {
+                advance[k] = 0;
+            }
+            for(size_t p = 0; p < query.size(); p++) {
+                unsigned k = (unsigned char)(query[p] - 'a');
+                if(k < 26)
+                    advance[k] |= (uint64_t)1 << p;
+            }
+        }
+
+        /* Before any letter, d edits reach the first d positions by
+         * deleting query characters */
+        void start(uint64_t *states) const {
+            for(unsigned d = 0; d <= max_distance; d++) {
+                states[d] = (((uint64_t)2 << d) - 1) & live;
+            }
+        }
+
+        void visit(const FlatLexNode *node, const uint64_t *states) {
+            if(node->word_id >= 0) {
+                for(unsigned d = 0; d <= max_distance; d++) {
+                    if(states[d] & accept) {
+                        passed++;
+                        if(!callback(word, d))
+                            stopped = true;
+                        break;
+                    }
+                }
+            }
+            const FlatLexNode *child = lexicon.firstChild(node);
+            for(uint32_t options = node->child_mask; options != 0 && !stopped;
+                    options &= options - 1, child++) {
+                unsigned k = __builtin_ctz(options);
+                uint64_t next[MAX_FUZZY_DISTANCE + 1];
+                next[0] = ((states[0] & advance[k]) << 1) & live;
+                for(unsigned d = 1; d <= max_distance; d++) {
+                    // the letter matches, is inserted, replaces the
+                    // next query character, or follows deletions
+                    next[d] = (((states[d] & advance[k]) << 1) | states[d - 1] |
+                            (states[d - 1] << 1) | (next[d - 1] << 1)) & live;
+                }
+                if(next[max_distance] == 0)
+                    continue;
+                word.push_back((char)('a' + k));
+                visit(child, next);
+                word.pop_back();
+            }
+        }
+
+        const FlatLexicon &lexicon;
+        const FuzzyCallback &callback;
+        std::string word;
+        size_t passed;
+        bool stopped;
+
+      private:
+        unsigned max_distance;
+        uint64_t advance[26];
+        uint64_t accept, live;
+    };
+
+    size_t fuzzyWords(const FlatLexicon &lexicon, const std::string &word, unsigned max_distance,
+            const FuzzyCallback &callback) {
+        if(word.size() > 63 || max_distance > MAX_FUZZY_DISTANCE)
+            return 0;
+        FuzzyWalk walk(lexicon, callback, word, max_distance);
+        uint64_t states[MAX_FUZZY_DISTANCE + 1];
+        walk.start(states);
+        walk.visit(lexicon.getRoot(), states);
+        return walk.passed;
+    }
@@ -0,0 +1,69 @@
+#ifndef LEXICONQUERY_H
+#define LEXICONQUERY_H
+
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+#include "flatlexicon.h"
+
+/**
+ * Queries over a FlatLexicon that walk the trie, pruning every branch
+ * that can not lead to an answer, instead of scanning the word list.
+ *
+ * Answers are handed to a callback one at a time, in sorted order, as
+ * they are found; nothing is collected. The callback returns false to
+ * end the query early. Every query returns the number of words it
+ * passed to the callback.
+ */
+typedef std::function<bool(const std::string &word)> WordCallback;
+
+/**
+ * The words starting with prefix (lowercase), skipping the first offset
+ * of them and passing at most limit (0 for no limit). Skipped words
+ * are counted a subtrie at a time from the word ids, so a large offset
+ * costs no more than a small one (unless the lexicon has been updated
+ * by LexiconVersions, whose ids are not ranks).
+ */
+size_t prefixWords(const FlatLexicon &lexicon, const std::string &prefix,
+        size_t offset, size_t limit, const WordCallback &callback);
+
+/**
+ * The words matching pattern, in which ? stands for any one letter,
+ * * for any run of letters (possibly none) and every other character
+ * for itself. The pattern is run as a set of positions at each trie
+ * node, so every node is visited at most once however many stars there
+ * are. Patterns are limited to 63 characters; longer ones match
+ * nothing.
+ */
+size_t patternWords(const FlatLexicon &lexicon, const std::string &pattern,
+        const WordCallback &callback);
+
+/**
+ * The words that can be spelled from tiles, a multiset of letters in
+ * which ? is a blank tile standing for any letter. With use_all only
+ * words using every tile (exact anagrams) are passed; otherwise any
+ * word spelled from some of the tiles is.
+ */
+size_t anagramWords(const FlatLexicon &lexicon, const std::string &tiles, bool use_all,
+        const WordCallback &callback);
+
+/* Like WordCallback, with the word's edit distance from the query */
+typedef std::function<bool(const std::string &word, unsigned distance)> FuzzyCallback;
+
+/* Most edits fuzzyWords allows */
+static const unsigned MAX_FUZZY_DISTANCE = 3;
+
+/**
+ * The words at most max_distance edits (letters inserted, deleted or
+ * replaced) from word, with their distance. Runs a Levenshtein
+ * automaton down the trie: a set of pattern positions per number of
+ * edits, advanced a letter at a time, so a subtrie is dropped as soon
+ * as no position survives within max_distance. Words are limited to
+ * 63 characters and max_distance to MAX_FUZZY_DISTANCE; beyond either
+ * nothing matches.
+ */
+size_t fuzzyWords(const FlatLexicon &lexicon, const std::string &word, unsigned max_distance,
+        const FuzzyCallback &callback);
+
+#endif // LEXICONQUERY_H
@@ -0,0 +1,42 @@
+#include "lexiconset.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+    LexiconSet::LexiconSet(const std::vector<std::set<std::string> > &lists) {
+        count = (unsigned)std::min<size_t>(lists.size(), MAX_LEXICONS);
+        std::map<std::string, uint32_t> merged;
+        for(unsigned i = 0; i < count; i++) {
+            for(std::set<std::string>::const_iterator it = lists[i].begin(); it != lists[i].end(); ++it) {
+                std::string word(*it);
+                for(size_t k = 0; k < word.size(); k++)
+                    word[k] = (char)tolower((unsigned char)word[k]);
+                merged[word] |= 1u << i;
+            }
+        }
+
+        std::set<std::string> words;
+        for(std::map<std::string, uint32_t>::const_iterator it = merged.begin(); it != merged.end(); ++it)
+            words.insert(words.end(), it->first);
+        lexicon = std::make_shared<FlatLexicon>(words);
+
+        // words the trie could not store are simply not found here
+        word_masks.assign(lexicon->wordCount(), 0);
+        node_masks.assign(lexicon->nodeCount(), 0);
+        std::vector<uint32_t> path;
+        for(std::map<std::string, uint32_t>::const_iterator it = merged.begin(); it != merged.end(); ++it) {
+            const FlatLexNode *node = lexicon->getRoot();
+            path.assign(1, lexicon->indexOf(node));
+            for(size_t k = 0; k < it->first.size() && node != NULL; k++) {
+                node = lexicon->getChild(node, it->first[k]);
+                if(node != NULL)
+                    path.push_back(lexicon->indexOf(node));
+            }
+            if(node == NULL || node->word_id < 0)
+                continue;
+            word_masks[node->word_id] = it->second;
+            for(size_t k = 0; k < path.size(); k++)
+                node_masks[path[k]] |= it->second;
+        }
+    }
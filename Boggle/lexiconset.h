@@ -0,0 +1,97 @@
+#ifndef LEXICONSET_H
+#define LEXICONSET_H
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "bogglescore.h"
+#include "flatlexicon.h"
+
+/**
+ * Several lexicons merged into one trie, so that a board is searched
+ * for all of them in a single pass. Each word node carries a mask of
+ * the lexicons holding its word (bit i for the i-th), and each node the
+ * union of the masks in its subtrie, which lets a search for some of
+ * the lexicons skip the parts of the trie only the others reach.
+ *
+ * The merged trie is an ordinary FlatLexicon over the union of the
+ * words, searched by a BogglePlayer through useLexicon.
+ */
+class LexiconSet {
+  public:
+    static const unsigned MAX_LEXICONS = 32;
+
+    /* Merges up to MAX_LEXICONS word lists; words are lowercased */
+    explicit LexiconSet(const std::vector<std::set<std::string> > &lists);
+
+    /* Number of lexicons merged */
+    unsigned size() const { return count; }
+
+    /* Mask with a bit for every lexicon */
+    uint32_t allMask() const { return count == 32 ? 0xffffffffu : (1u << count) - 1; }
+
+    /* The merged trie */
+    std::shared_ptr<const FlatLexicon> getLexicon() const { return lexicon; }
+
+    /* The lexicons holding the word of word_id */
+    uint32_t wordMask(int32_t word_id) const { return word_masks[word_id]; }
+
+    /* The lexicons holding some word at or below node */
+    uint32_t nodeMask(const FlatLexNode *node) const {
+        return node_masks[lexicon->indexOf(node)];
+    }
+
+  private:
+    unsigned count;
+    std::shared_ptr<const FlatLexicon> lexicon;
+    std::vector<uint32_t> word_masks;
+    std::vector<uint32_t> node_masks;
+};
+
+/**
+ * Search sink sorting each distinct word of at least a minimum length
+ * into the sets of the lexicons holding it, among those in a mask
+ * (see bogglescore.h for the sink interface). Subtries with no word in
+ * those lexicons are not entered.
+ */
+class LexiconSetSink {
+  public:
+    static const bool KEEPS_WORD = true;
+    static const bool KEEPS_PATH = false;
+    static const bool KEEPS_BLANKS = false;
+
+    /* words must have a set per lexicon of lexicons */
+    LexiconSetSink(const LexiconSet &lexicons, uint32_t which, unsigned minimum_word_length,
+            WordStamps &seen, std::vector<std::set<std::string> > *words)
+        : lexicons(lexicons), which(which), min_length(minimum_word_length), seen(seen),
+          words(words) {}
+
+    bool enters(const FlatLexNode *node) const { return (lexicons.nodeMask(node) & which) != 0; }
+    void path(const FlatLexNode *, uint64_t) {}
+    void blanks(const FlatLexNode *, const WildcardLetters &) {}
+
+    bool wants(const FlatLexNode *node, size_t length) const {
+        return length >= min_length && (lexicons.wordMask(node->word_id) & which) != 0;
+    }
+
+    /* Returns false if the word was already added */
+    bool add(const FlatLexNode *node, const std::string &word) {
+        if(!seen.mark(node->word_id))
+            return false;
+        for(uint32_t mask = lexicons.wordMask(node->word_id) & which; mask != 0; mask &= mask - 1)
+            (*words)[__builtin_ctz(mask)].insert(word);
+        return true;
+    }
+
+  private:
+    const LexiconSet &lexicons;
+    uint32_t which;
+    unsigned min_length;
+    WordStamps &seen;
+    std::vector<std::set<std::string> > *words;
+};
+
+#endif // LEXICONSET_H
@@ -0,0 +1,175 @@
+#include "lexiconversions.h"
+#include "lexiconquery.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <set>
+
+/* Spare nodes given to a new array beyond those in use, at least */
+static const uint32_t MIN_SPARE_NODES = 65536;
+
+    LexiconVersions::LexiconVersions(const FlatLexicon &initial) : published(0) {
+        layout(initial, initial.nodeCount());
+        std::atomic_store(&current, std::shared_ptr<const FlatLexicon>(
+                new FlatLexicon(arena, root, end, word_ids, ranked)));
+        published = 1;
+    }
+
+    std::shared_ptr<const FlatLexicon> LexiconVersions::pin() const {
+        return std::atomic_load(&current);
+    }
+
+    /**
+     * Copies source's trie into a new array with at least spare nodes
+     * to spare. A source with a root other than node 0 (a snapshot) is
+     * laid out again from its words first.
+     */
+    void LexiconVersions::layout(const FlatLexicon &source, size_t spare) {
+        std::unique_ptr<FlatLexicon> fresh;
+        const FlatLexicon *from = &source;
+        if(source.getRoot() != source.image().nodes || !source.ranked()) {
+            std::set<std::string> words;
+            prefixWords(source, "", 0, 0, [&words](const std::string &word) {
+                words.insert(words.end(), word);
+                return true;
+            });
+            fresh.reset(new FlatLexicon(words));
+            from = fresh.get();
+        }
+
+        FlatLexiconImage image = from->image();
+        capacity = image.node_count + (uint32_t)std::max<size_t>(spare, MIN_SPARE_NODES);
+        arena.reset(new FlatLexNode[capacity], std::default_delete<FlatLexNode[]>());
+        memcpy(arena.get(), image.nodes, image.node_count * sizeof(FlatLexNode));
+        end = image.node_count;
+        root = 0;
+        word_ids = image.word_count;
+        ranked = true;
+    }
+
+    size_t LexiconVersions::apply(const std::vector<std::string> &add,
+            const std::vector<std::string> &remove) {
+        std::lock_guard<std::mutex> guard(writer);
+        size_t changed = 0;
+        for(size_t i = 0; i < add.size() + remove.size(); i++) {
+            const std::string &given = i < add.size() ? add[i] : remove[i - add.size()];
+            std::string word;
+            for(size_t k = 0; k < given.size(); k++) {
+                word += (char)tolower((unsigned char)given[k]);
+            }
+            if(word.empty() || word.find_first_not_of("abcdefghijklmnopqrstuvwxyz") != std::string::npos)
+                continue;
+
+            // a path copy appends at most a block of 26 and a tail node
+            // per letter, and a root
+            uint64_t worst = 27 * (uint64_t)word.size() + 1;
+            if(end + worst > capacity) {
+                FlatLexicon working(arena, root, end, word_ids, ranked);
+                layout(working, end);
+            }
+            if(update(word, i < add.size()))
+                changed++;
+        }
+
+        if(changed > 0) {
+            std::atomic_store(&current, std::shared_ptr<const FlatLexicon>(
+                    new FlatLexicon(arena, root, end, word_ids, ranked)));
+            published++;
+        }
+        return changed;
+    }
+
+    /* The children of node, with their letters */
+    LexiconVersions::Block LexiconVersions::children(const FlatLexNode &node) const {
+        Block block;
+        const FlatLexNode *child = arena.get() + node.first_child;
+        for(uint32_t options = node.child_mask; options != 0; options &= options - 1) {
+            block.push_back(std::make_pair((unsigned)__builtin_ctz(options), *child++));
+        }
+        return block;
+    }
+
+    /* Appends block as the children of a copy of parent */
+    FlatLexNode LexiconVersions::place(FlatLexNode parent, const Block &block) {
+        parent.child_mask = 0;
+        parent.first_child = block.empty() ? 0 : end;
+        for(size_t i = 0; i < block.size(); i++) {
+            arena.get()[end++] = block[i].second;
+            parent.child_mask |= 1u << block[i].first;
+        }
+        return parent;
+    }
+
+    /**
+     * Adds or removes one word by path copying, making the new root the
+     * working root. Returns false if there was nothing to do.
+     */
+    bool LexiconVersions::update(const std::string &word, bool add) {
+        const FlatLexNode *nodes = arena.get();
+
+        // the nodes along the longest prefix of word in the trie
+        std::vector<FlatLexNode> path(1, nodes[root]);
+        size_t depth = 0;
+        while(depth < word.size()) {
+            const FlatLexNode &node = path.back();
+            unsigned k = word[depth] - 'a';
+            if(!((node.child_mask >> k) & 1))
+                break;
+            path.push_back(nodes[node.first_child
+                + __builtin_popcount(node.child_mask & ((1u << k) - 1))]);
+            depth++;
+        }
+
+        // the new version of path[depth]
+        FlatLexNode changed;
+        bool prune = false;
+        if(add && depth == word.size()) {
+            if(path.back().word_id >= 0)
+                return false;
+            changed = path.back();
+            changed.word_id = (int32_t)word_ids++;
+        }
+        else if(add) {
+            // a chain of new nodes for the rest of the word
+            FlatLexNode tail = { 0, 0, (int32_t)word_ids++ };
+            for(size_t j = word.size() - 1; j > depth; j--) {
+                FlatLexNode bare = { 0, 0, -1 };
+                tail = place(bare, Block(1, std::make_pair((unsigned)(word[j] - 'a'), tail)));
+            }
+            Block block = children(path[depth]);
+            unsigned k = word[depth] - 'a';
+            size_t at = 0;
+            while(at < block.size() && block[at].first < k)
+                at++;
+            block.insert(block.begin() + at, std::make_pair(k, tail));
+            changed = place(path[depth], block);
+        }
+        else {
+            if(depth < word.size() || path.back().word_id < 0)
+                return false;
+            changed = path.back();
+            changed.word_id = -1;
+            prune = changed.child_mask == 0;
+        }
+        ranked = false;
+
+        // copy each block on the way up with its changed member, or
+        // without it once a removal leaves a node with nothing below it
+        for(size_t i = depth; i > 0; i--) {
+            Block block = children(path[i - 1]);
+            unsigned k = word[i - 1] - 'a';
+            size_t at = 0;
+            while(block[at].first != k)
+                at++;
+            if(prune)
+                block.erase(block.begin() + at);
+            else
+                block[at].second = changed;
+            changed = place(path[i - 1], block);
+            prune = prune && changed.child_mask == 0 && changed.word_id < 0;
+        }
+        arena.get()[end] = changed;
+        root = end++;
+        return true;
+    }
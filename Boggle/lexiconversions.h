@@ -0,0 +1,85 @@
+#ifndef LEXICONVERSIONS_H
+#define LEXICONVERSIONS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flatlexicon.h"
+
+/**
+ * A lexicon that changes while it is being searched. Readers pin the
+ * current snapshot, an ordinary immutable FlatLexicon, and search it
+ * for as long as they like; writers add and remove words, and each
+ * batch of changes is published as a new snapshot in one atomic step.
+ *
+ * All snapshots view one shared node array with room to spare. A
+ * change never touches a node a snapshot can reach: it appends copies
+ * of the sibling blocks along the changed word's path, pointing at the
+ * unchanged subtries below them, and a new root. Only when the spare
+ * room runs out is the trie laid out again from its words, in a new
+ * array; an array is freed once no snapshot using it is pinned.
+ *
+ * Added words get fresh ids after all the others and removed words'
+ * ids go unused (see FlatLexicon::wordCount), until a relayout numbers
+ * them by rank again.
+ */
+class LexiconVersions {
+  public:
+    /* Versions starting from a copy of initial */
+    explicit LexiconVersions(const FlatLexicon &initial);
+
+    /**
+     * The current snapshot. It stays valid and unchanged for as long as
+     * it is held, whatever is published meanwhile. Never waits for a
+     * writer.
+     */
+    std::shared_ptr<const FlatLexicon> pin() const;
+
+    /**
+     * Adds and then removes the given words (in any case; words with
+     * characters other than letters are ignored) and publishes the
+     * result. Writers are applied one at a time.
+     *
+     * Returns the number of words actually added or removed.
+     */
+    size_t apply(const std::vector<std::string> &add, const std::vector<std::string> &remove);
+
+    /* Number of snapshots published so far, counting the first */
+    uint64_t version() const { return published; }
+
+  private:
+    LexiconVersions(const LexiconVersions &);
+    LexiconVersions &operator=(const LexiconVersions &);
+
+    typedef std::vector<std::pair<unsigned, FlatLexNode> > Block;
+
+    void layout(const FlatLexicon &source, size_t spare);
+    bool update(const std::string &word, bool add);
+    Block children(const FlatLexNode &node) const;
+    FlatLexNode place(FlatLexNode parent, const Block &block);
+
+    /* Serializes writers */
+    std::mutex writer;
+
+    /* The published snapshot, accessed with atomic_load and
+     * atomic_store */
+    std::shared_ptr<const FlatLexicon> current;
+    std::atomic<uint64_t> published;
+
+    /* The shared node array and the writer's working trie in it: nodes
+     * below end are in use, and root is the root after the changes
+     * applied so far */
+    std::shared_ptr<FlatLexNode> arena;
+    uint32_t capacity;
+    uint32_t end;
+    uint32_t root;
+    uint32_t word_ids;
+    bool ranked;
+};
+
+#endif // LEXICONVERSIONS_H
@@ -6,11 +6,15 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QtWidgets/QMessageBox>
+#include <QtGui/QColor>
 #include <QtGui/QResizeEvent>
-#include <time.h>
+#include <algorithm>
 #include <iostream>
 
 static int MSECDELAY = 400; // when highlighting dice 
+static unsigned SUGGESTIONS = 5; // words offered for a rejected guess
+static unsigned SUGGEST_EDITS = 2;
+static double SUGGEST_SECONDS = 0.0005; // looking for suggestions on the board
 
 static std::string toLowerCase(std::string strToConvert){
   std::string res;
@@ -31,8 +35,36 @@ MainWindow::MainWindow(const char* lexfilename,
   this->boggle_board = new BoggleBoard(lexfilename, rows, cols);
   this->comp_boggle_player = new BogglePlayer();
   this->comp_boggle_player->buildLexicon(this->boggle_board->lexicon_words);
+  const std::vector<std::string> &rejected = this->comp_boggle_player->getRejectedWords();
+  if(!rejected.empty()) {
+    std::cerr << "Left out " << rejected.size() << " lexicon words with characters"
+      " other than letters, such as " << rejected[0] << std::endl;
+  }
   this->minWordLength = minwordlength;  
 
+  // the word list only hands the view the rows it scrolls to
+  this->computerModel = new WordListModel(this);
+  ui->computerWords->setModel(this->computerModel);
+  ui->computerWords->setUniformItemSizes(true);
+  this->solveGeneration = 0;
+  this->solving = false;
+
+  // the worker shares the lexicon just built, and is deleted on its own
+  // thread once that stops
+  this->solveWorker = new SolveWorker(*this->comp_boggle_player, this->solveGeneration);
+  this->solveWorker->moveToThread(&this->solveThread);
+  connect(&this->solveThread, &QThread::finished, this->solveWorker, &QObject::deleteLater);
+  connect(this, &MainWindow::solveRequested, this->solveWorker, &SolveWorker::solve);
+  connect(this->solveWorker, &SolveWorker::wordsFound, this, &MainWindow::computerWordsFound);
+  connect(this->solveWorker, &SolveWorker::heatFound, this, &MainWindow::computerHeatFound);
+  connect(this->solveWorker, &SolveWorker::solveFinished, this, &MainWindow::computerSolveFinished);
+  this->solveThread.start();
+
+  this->highlightNext = 0;
+  connect(&this->highlightTimer, &QTimer::timeout, this, &MainWindow::highlightNextCell);
+  this->clearTimer.setSingleShot(true);
+  connect(&this->clearTimer, &QTimer::timeout, this, &MainWindow::clearAllHighlights);
+
   /*  
   clearGrid();
   */
@@ -49,6 +81,10 @@ MainWindow::MainWindow(const char* lexfilename,
 }
 
 MainWindow::~MainWindow() {
+  // stops a solve in progress and waits for the worker to notice
+  this->solveGeneration++;
+  this->solveThread.quit();
+  this->solveThread.wait();
   destroyGrid();
   delete ui;
   delete boggle_board;
@@ -120,7 +156,11 @@ void MainWindow::highlightCell(int r, int c) {
 }
 
 void MainWindow::deHighlightCell(int r, int c) {
-  this->gridLabels[r][c]->setStyleSheet("border-radius:8px;background-color:#eee5aa");
+  unsigned int index = r * this->boggle_board->COLS + c;
+  if(index < this->cellStyles.size())
+    this->gridLabels[r][c]->setStyleSheet(this->cellStyles[index]);
+  else
+    this->gridLabels[r][c]->setStyleSheet("border-radius:8px;background-color:#eee5aa");
 }
 
 
@@ -135,7 +175,7 @@ void MainWindow::on_actionNew_Random_triggered() {
   */
   this->ui->humanInput->clear();
   this->ui->humanWords->clear();
-  this->ui->computerWords->clear();
+  this->abandonBoard();
   this->ui->computerScore->setText("0");
   this->ui->humanScore->setText("0");
   this->destroyGrid();
@@ -154,18 +194,50 @@ void MainWindow::on_actionNew_Random_triggered() {
 }
 
 
+void MainWindow::abandonBoard() {
+  /* A new generation makes the worker stop any solve of the old board
+     and us drop the words it has sent. Highlighting of the old board
+     stops too, since its cells are about to go. */
+  this->solveGeneration++;
+  this->solving = false;
+  this->computerModel->clear();
+  this->ui->computerPlayButton->setText("Computer Play!");
+  this->highlightTimer.stop();
+  this->clearTimer.stop();
+  this->highlightPath.clear();
+  this->cellStyles.clear();
+}
+
+
 void MainWindow::highlightLocations(std::vector<int> locations, int delay) {
+  /* The first cell lights up now and the rest one per timer tick, so
+     the event loop keeps running while the path is traced */
   clearAllHighlights();
-  for(unsigned int i=0; i<locations.size(); i++)    {
-    std::vector<int> pos =
-      this->boggle_board->returnGridLocation(locations[i]);
-    qApp->processEvents();
-    highlightCell(pos[0], pos[1]);
-    qApp->processEvents();
-    if(delay>0) {
-      sleepMillisec(delay);
-    }
+  this->clearTimer.stop();
+  this->highlightPath = locations;
+  this->highlightNext = 0;
+  if(delay>0) {
+    highlightNextCell();
+    this->highlightTimer.start(delay);
+  }
+  else {
+    while(this->highlightNext < this->highlightPath.size())
+      highlightNextCell();
+    highlightNextCell();
+  }
+}
+
+
+void MainWindow::highlightNextCell() {
+  if(this->highlightNext >= this->highlightPath.size()) {
+    // the whole path is lit; leave it up for a moment
+    this->highlightTimer.stop();
+    this->clearTimer.start(MSECDELAY);
+    return;
   }
+  std::vector<int> pos =
+    this->boggle_board->returnGridLocation(this->highlightPath[this->highlightNext++]);
+  highlightCell(pos[0], pos[1]);
 }
 
 
@@ -173,7 +245,6 @@ void MainWindow::clearAllHighlights() {
   for(unsigned int r=0; r < this->boggle_board->ROWS; r++)
     for(unsigned int c=0; c < this->boggle_board->COLS; c++)
       deHighlightCell(r,c);
-  qApp->processEvents();
 }
 
 void MainWindow::deHighlightLocations(std::vector<int> locations) {
@@ -181,7 +252,6 @@ void MainWindow::deHighlightLocations(std::vector<int> locations) {
     std::vector<int> pos = this->boggle_board->returnGridLocation(locations[i]);
     deHighlightCell(pos[0], pos[1]);
   }
-  qApp->processEvents();
 }
 
 void MainWindow::popMsgBox(const char* msg) {
@@ -192,6 +262,16 @@ void MainWindow::popMsgBox(const char* msg) {
   qApp->processEvents();
 }
 
+/* msg, followed by a "Did you mean" line if there is anything to offer */
+static std::string withSuggestions(const char* msg, const std::vector<std::string>& words) {
+  std::string text(msg);
+  for(size_t i=0; i < words.size(); i++)
+    text += (i == 0 ? "\nDid you mean: " : ", ") + words[i];
+  if(!words.empty())
+    text += "?";
+  return text;
+}
+
 void MainWindow::checkAndAddWord(std::string word) {
 
 
@@ -204,9 +284,12 @@ void MainWindow::checkAndAddWord(std::string word) {
   return;
   }
   */
+  std::vector<std::string> suggestions;
   bool in_lexicon = this->comp_boggle_player->isInLexicon(word);
   if(!in_lexicon)    {
-    popMsgBox("Word not in lexicon");
+    this->comp_boggle_player->suggestWords(word, SUGGEST_EDITS, SUGGESTIONS, false, &suggestions,
+                                           SUGGEST_SECONDS);
+    popMsgBox(withSuggestions("Word not in lexicon", suggestions).c_str());
     return;
   }
 
@@ -219,7 +302,9 @@ void MainWindow::checkAndAddWord(std::string word) {
 
   std::vector<int> pos = this->comp_boggle_player->isOnBoard(word);
   if(pos.size()==0)    {
-    popMsgBox("Word does not exist on board.");
+    this->comp_boggle_player->suggestWords(word, SUGGEST_EDITS, SUGGESTIONS, true, &suggestions,
+                                           SUGGEST_SECONDS);
+    popMsgBox(withSuggestions("Word does not exist on board.", suggestions).c_str());
     return;
   }
 
@@ -232,22 +317,26 @@ void MainWindow::on_humanInput_returnPressed() {
   std::string word = ui->humanInput->text().toStdString();
   checkAndAddWord(toLowerCase(word));
   ui->humanInput->clear();
-  qApp->processEvents();
-  sleepMillisec(MSECDELAY);
-  this->clearAllHighlights();
+  // an added word clears once its path is traced; otherwise clear
+  // whatever is lit after the usual delay
+  if(!this->highlightTimer.isActive())
+    this->clearTimer.start(MSECDELAY);
 }
 
 void MainWindow::on_actionNew_Custom_triggered() {
-  this->ui->humanInput->clear();
-  this->ui->humanWords->clear();
-  this->ui->computerWords->clear();
-  this->ui->computerScore->setText("0");
-  this->ui->humanScore->setText("0");
-
   std::string** board_setup;
   unsigned int rows, cols;
   this->comp_boggle_player->getCustomBoard(board_setup, &rows, &cols);
   //  std::cerr << "Custom dims " << rows<<","<<cols<<std::endl;
+  this->newCustomBoard(rows, cols, board_setup);
+}
+
+void MainWindow::newCustomBoard(unsigned int rows, unsigned int cols, std::string **board_setup) {
+  this->ui->humanInput->clear();
+  this->ui->humanWords->clear();
+  this->abandonBoard();
+  this->ui->computerScore->setText("0");
+  this->ui->humanScore->setText("0");
 
   if(board_setup!=NULL) {
     this->destroyGrid();
@@ -279,38 +368,67 @@ void MainWindow::on_actionNew_Custom_triggered() {
 
 void MainWindow::updateScores() {
   ui->humanScore->setNum(ui->humanWords->count());
-  ui->computerScore->setNum(ui->computerWords->count());
-  qApp->processEvents();
-}
-
-void MainWindow::sleepMillisec(long int msec)
-{
-  struct timespec req = {0,0};
-  req.tv_sec = 0;
-  req.tv_nsec = msec * 1000000L;
-  nanosleep(&req, (struct timespec *)NULL);
+  ui->computerScore->setNum(this->computerModel->wordCount());
 }
 
 void MainWindow::on_computerPlayButton_released() {
-  std::set<std::string> validWords;
-  // change text in button to "Thinking..."
+  if(this->solving)
+    return;
+  // change text in button to "Thinking..." until the worker is done;
+  // its words are listed as they arrive
   this->ui->computerPlayButton->setText("Thinking...");
-  this->ui->computerPlayButton->repaint();
-  qApp->processEvents();
+  this->computerModel->clear();
+  this->solving = true;
 
-  this->comp_boggle_player->getAllValidWords(minWordLength, &validWords);
-  std::set<std::string>::iterator iter;
-  for(iter = validWords.begin(); iter != validWords.end(); iter++)    {
-    //    std::vector<int> pos = this->comp_boggle_player->isOnBoard(*iter);
-    //    this->highlightLocations(pos, 0); // too slow
-    ui->computerWords->addItem(QString(iter->c_str()));
+  QStringList dice;
+  for(unsigned int r=0; r < this->boggle_board->ROWS; r++)
+    for(unsigned int c=0; c < this->boggle_board->COLS; c++)
+      dice.append(QString::fromStdString(this->boggle_board->board[r][c]));
+  emit solveRequested(++this->solveGeneration, this->boggle_board->ROWS,
+                      this->boggle_board->COLS, dice, minWordLength);
+}
+
+void MainWindow::computerWordsFound(quint64 generation, QStringList words) {
+  if(generation != this->solveGeneration)
+    return;
+  this->computerModel->appendWords(words);
+  this->updateScores();
+}
+
+void MainWindow::computerHeatFound(quint64 generation, QVector<int> words, QVector<int> points) {
+  if(generation != this->solveGeneration)
+    return;
+  /* Dice go from the usual pale yellow for no points to red for the
+     die the most points use; the tooltip has the numbers */
+  int most = 1;
+  for(int i = 0; i < points.size(); i++)
+    most = std::max(most, points[i]);
+  QColor cold("#eee5aa"), hot("#e04020");
+  this->cellStyles.clear();
+  for(int i = 0; i < points.size(); i++) {
+    double t = points[i] / (double)most;
+    QColor colour = QColor::fromRgbF(cold.redF() + t * (hot.redF() - cold.redF()),
+                                     cold.greenF() + t * (hot.greenF() - cold.greenF()),
+                                     cold.blueF() + t * (hot.blueF() - cold.blueF()));
+    this->cellStyles.push_back(QString("border-radius:8px;background-color:%1").arg(colour.name()));
+    std::vector<int> pos = this->boggle_board->returnGridLocation(i);
+    this->gridLabels[pos[0]][pos[1]]->setToolTip(
+      QString("%1 words, %2 points").arg(words[i]).arg(points[i]));
   }
+  this->clearAllHighlights();
+}
+
+void MainWindow::computerSolveFinished(quint64 generation, int word_count) {
+  if(generation != this->solveGeneration)
+    return;
+  this->solving = false;
+  // words came in the order the search found them
+  this->computerModel->sortWords();
   this->updateScores();
   this->clearAllHighlights();
   // change text back to "Computer Play!"
   this->ui->computerPlayButton->setText("Computer Play!");
-  this->ui->computerPlayButton->repaint();
-  qApp->processEvents();
+  emit computerPlayFinished(word_count);
 }
 
 void MainWindow::resizeEvent(QResizeEvent *evt)
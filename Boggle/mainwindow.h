@@ -8,6 +8,11 @@
 
 #include "boggleboard.h"
 #include "boggleplayer.h"
+#include "solveworker.h"
+#include "wordlistmodel.h"
+#include <atomic>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QMainWindow>
 
@@ -24,9 +29,31 @@ private:
     BoggleBoard *boggle_board;
     BogglePlayer *comp_boggle_player;
     int minWordLength;
+
+    /* Computer play runs on solveThread; words land in computerModel.
+       solveGeneration changes with every solve and board, so batches
+       from an abandoned solve are dropped, and the worker, which
+       watches it too, stops searching for them. */
+    QThread solveThread;
+    SolveWorker *solveWorker;
+    WordListModel *computerModel;
+    std::atomic<quint64> solveGeneration;
+    bool solving;
+
+    /* Highlighting steps along highlightPath on highlightTimer ticks,
+       then clearTimer takes the highlights off again */
+    QTimer highlightTimer;
+    QTimer clearTimer;
+    std::vector<int> highlightPath;
+    size_t highlightNext;
+
+    /* Background of each die when not highlighted: plain, or coloured
+       by heat once computer play has found the board's words */
+    std::vector<QString> cellStyles;
+
     void createNewGrid(int rows, int cols);
     void destroyGrid();
-    void sleepMillisec(long int msec);
+    void abandonBoard();
     void popMsgBox(const char* msg);
     void clearGrid();
     void highlightCell(int r, int c);
@@ -43,8 +70,18 @@ public:
 			QWidget *parent = 0);
     void clearAllHighlights();
     void checkAndAddWord(std::string word);
+    /* Starts a new game on a rows x cols board of the given dice, as
+       New Custom does, or on a random board if dice is NULL */
+    void newCustomBoard(unsigned int rows, unsigned int cols, std::string **dice);
     ~MainWindow();
 
+signals:
+    void solveRequested(quint64 generation, int rows, int cols, QStringList dice,
+                        int minimum_length);
+    /* Emitted once computer play has listed all its words, so that it
+       can be driven from a test, e.g. with QT_QPA_PLATFORM=offscreen */
+    void computerPlayFinished(int word_count);
+
 private slots:
     void on_actionNew_Random_triggered();
 
@@ -54,6 +91,14 @@ private slots:
 
     void on_computerPlayButton_released();
 
+    void computerWordsFound(quint64 generation, QStringList words);
+
+    void computerSolveFinished(quint64 generation, int word_count);
+
+    void computerHeatFound(quint64 generation, QVector<int> words, QVector<int> points);
+
+    void highlightNextCell();
+
 private:
     Ui::MainWindow *ui;
 };
@@ -0,0 +1,1510 @@
+/******************************************************
+ * Performance tests for the Boggle player.
+ *
+ * usage: perftest load LEXFILE [threads]
+ *        perftest synth COUNT OUTFILE
+ *        perftest solve LEXFILE [boards]
+ *        perftest score LEXFILE [boards]
+ *        perftest slice LEXFILE [boards]
+ *        perftest blank LEXFILE [boards]
+ *        perftest query LEXFILE [repeats]
+ *        perftest cache LEXFILE [boards]
+ *        perftest delta LEXFILE [batches]
+ *        perftest paths LEXFILE [boards]
+ *        perftest abi LEXFILE [boards]
+ *        perftest stream LEXFILE [boards]
+ *        perftest interleave LEXFILE [boards]
+ *        perftest multilex LEXFILE [boards]
+ *        perftest anytime LEXFILE [boards]
+ *        perftest topology LEXFILE [boards]
+ *        perftest heat LEXFILE [boards]
+ *        perftest design LEXFILE [runs]
+ * ****************************************************/
+
+#include "boggleabi.h"
+#include "boggleboard.h"
+#include "bogglecache.h"
+#include "boggleplayer.h"
+#include "boggleslice.h"
+#include "bogglesynth.h"
+#include "bogglestream.h"
+#include "lexiconloader.h"
+#include "lexiconquery.h"
+#include "lexiconversions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Runs fn in a child process and prints its wall time and peak
+ * resident set size. A separate process keeps the RSS high-water mark
+ * of one loader from hiding the other's.
+ */
+template <class Fn>
+static bool measureInChild(const char *label, Fn fn) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if(pid == 0) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t words = fn();
+        double secs = secondsSince(start);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << label << ": " << words << " words, " << secs * 1000 << " ms, peak RSS "
+            << usage.ru_maxrss / 1024 << " MB" << std::endl;
+        _exit(words > 0 ? 0 : 1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Compares BoggleBoard's std::set based load with the streaming loader */
+static int loadBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest load LEXFILE [threads]" << std::endl;
+        return 1;
+    }
+    const char *lexfile = argv[2];
+    unsigned threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    bool ok = measureInChild("std::set + insert", [&]() -> size_t {
+        std::streambuf *saved = std::cout.rdbuf(NULL);   // mute BoggleBoard
+        BoggleBoard board(lexfile, 4, 4);
+        BogglePlayer player;
+        player.buildLexicon(board.lexicon_words);
+        std::cout.rdbuf(saved);
+        return board.lexicon_words.size();
+    });
+
+    ok &= measureInChild("streaming + bulk", [&]() -> size_t {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        WordList words;
+        if(!loadWordList(lexfile, &words))
+            return 0;
+        std::cout << "  read+split+sort " << secondsSince(start) * 1000 << " ms, "
+            << words.memoryUsage() / 1024 << " KB" << std::endl;
+        BogglePlayer player;
+        player.buildLexicon(words, threads);
+        return words.size();
+    });
+
+    return ok ? 0 : 1;
+}
+
+/* Writes count random words, unsorted and with some duplicates */
+static int synthBench(int argc, char *argv[]) {
+    if(argc < 4) {
+        std::cerr << "usage: perftest synth COUNT OUTFILE" << std::endl;
+        return 1;
+    }
+    unsigned long count = strtoul(argv[2], NULL, 10);
+    std::ofstream out(argv[3]);
+    if(!out) {
+        std::cerr << "Could not open " << argv[3] << std::endl;
+        return 1;
+    }
+    // letters roughly by English frequency so the trie has realistic
+    // shared prefixes
+    static const char LETTERS[] =
+        "eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrr"
+        "ddddllllcccuuummwwffggyyppbbvkjxqz";
+    std::mt19937 rng(42);
+    std::string word;
+    for(unsigned long i = 0; i < count; i++) {
+        unsigned len = 3 + rng() % 10;
+        word.clear();
+        for(unsigned k = 0; k < len; k++) {
+            word += LETTERS[rng() % (sizeof(LETTERS) - 1)];
+        }
+        out << word << '\n';
+    }
+    return out ? 0 : 1;
+}
+
+/**
+ * Random square boards of the given size, rolled from the standard
+ * dice bag the way BoggleBoard::initRandomBoard rolls a 4x4 board.
+ */
+static std::vector<std::vector<std::string> > randomBoards(BoggleBoard &bag,
+        unsigned size, unsigned count) {
+    std::vector<std::vector<std::string> > boards(count);
+    for(unsigned b = 0; b < count; b++) {
+        for(unsigned i = 0; i < size * size; i++) {
+            boards[b].push_back(bag.diceBag[i % bag.diceBag.size()]->getRandomFace());
+        }
+    }
+    return boards;
+}
+
+/* Sets board b on player, as the string** setBoard expects */
+static void setBoard(BogglePlayer &player, unsigned size, std::vector<std::string> &b) {
+    std::vector<std::string *> rows(size);
+    for(unsigned r = 0; r < size; r++) {
+        rows[r] = &b[r * size];
+    }
+    player.setBoard(size, size, &rows[0]);
+}
+
+/* Times getAllValidWords and isOnBoard with and without the
+ * specialized kernels on random boards of each kernel size */
+static int solveBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest solve LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 2000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer generic, fixed;
+    generic.buildLexicon(bag.lexicon_words);
+    fixed.shareLexicon(generic);
+    generic.setKernelsEnabled(false);
+    srand(1);
+
+    unsigned sizes[] = { 4, 5, 6, 7 };
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        unsigned size = sizes[s];
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        std::vector<std::set<std::string> > found(count);
+        double secs[2][2] = { { 0, 0 }, { 0, 0 } };
+        size_t words = 0;
+
+        for(int k = 0; k < 2; k++) {
+            BogglePlayer &player = k ? fixed : generic;
+            for(unsigned b = 0; b < count; b++) {
+                std::set<std::string> result;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                setBoard(player, size, boards[b]);
+                player.getAllValidWords(2, &result);
+                secs[k][0] += secondsSince(start);
+
+                start = std::chrono::steady_clock::now();
+                for(std::set<std::string>::const_iterator it = result.begin(); it != result.end(); ++it) {
+                    if(player.isOnBoard(*it).empty()) {
+                        std::cerr << "isOnBoard missed " << *it << std::endl;
+                        return 1;
+                    }
+                }
+                secs[k][1] += secondsSince(start);
+
+                if(k == 0) {
+                    found[b].swap(result);
+                    words += found[b].size();
+                }
+                else if(result != found[b]) {
+                    std::cerr << "Kernel result differs on a " << size << "x" << size << " board" << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        std::cout << size << "x" << size << ": " << words / (double)count << " words/board"
+            << (size == 7 ? " (no kernel; both columns generic)" : "") << "\n"
+            << "  getAllValidWords  generic " << secs[0][0] * 1e6 / count << " us"
+            << "  kernel " << secs[1][0] * 1e6 / count << " us"
+            << "  x" << secs[0][0] / secs[1][0] << "\n"
+            << "  isOnBoard         generic " << secs[0][1] * 1e9 / words << " ns"
+            << "  kernel " << secs[1][1] * 1e9 / words << " ns"
+            << "  x" << secs[0][1] / secs[1][1] << std::endl;
+    }
+    return 0;
+}
+
+/* Times scoring boards from a full getAllValidWords set against the
+ * count-only and top-K modes of scoreBoard */
+static int scoreBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest score LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 1000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    ScoringRules rules = ScoringRules::official();
+    srand(1);
+
+    // build the score table up front so that it is not timed
+    std::vector<std::vector<std::string> > warmup = randomBoards(bag, 4, 1);
+    ScoreResult ignored;
+    setBoard(player, 4, warmup[0]);
+    player.scoreBoard(0, SCORE_BY_POINTS, &ignored);
+
+    unsigned sizes[] = { 4, 5, 6, 7, 10 };
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        unsigned size = sizes[s];
+        unsigned boards_of_size = size > 7 ? count / 10 + 1 : count;
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, boards_of_size);
+        double secs[3] = { 0, 0, 0 };
+        uint64_t total = 0;
+
+        for(unsigned b = 0; b < boards_of_size; b++) {
+            setBoard(player, size, boards[b]);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::set<std::string> words;
+            player.getAllValidWords(rules.minimum_length, &words);
+            uint64_t set_total = 0;
+            for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+                set_total += rules.pointsFor(it->size());
+            }
+            secs[0] += secondsSince(start);
+
+            ScoreResult counted, top;
+            start = std::chrono::steady_clock::now();
+            player.scoreBoard(0, SCORE_BY_POINTS, &counted);
+            secs[1] += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            player.scoreBoard(10, SCORE_BY_POINTS, &top);
+            secs[2] += secondsSince(start);
+
+            if(counted.words != words.size() || counted.total != set_total ||
+               top.total != set_total || top.top.size() != std::min<size_t>(10, words.size())) {
+                std::cerr << "Score differs from the word set on a " << size << "x" << size
+                    << " board" << std::endl;
+                return 1;
+            }
+            total += set_total;
+        }
+
+        std::cout << size << "x" << size << ": " << total / (double)boards_of_size << " points/board\n"
+            << "  set+score " << secs[0] * 1e6 / boards_of_size << " us"
+            << "  count-only " << secs[1] * 1e6 / boards_of_size << " us"
+            << " (x" << secs[0] / secs[1] << ")"
+            << "  top-10 " << secs[2] * 1e6 / boards_of_size << " us"
+            << " (x" << secs[0] / secs[2] << ")" << std::endl;
+    }
+    return 0;
+}
+
+/* Times solving boards one at a time against SlicedSolver batches of
+ * 64, checking that both find the same words */
+static int sliceBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest slice LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 6400;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    unsigned sizes[] = { 4, 5 };
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        unsigned size = sizes[s];
+        SlicedSolver sliced(*player.getLexicon(), size, size);
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        std::vector<std::set<std::string> > single(count);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(unsigned b = 0; b < count; b++) {
+            setBoard(player, size, boards[b]);
+            player.getAllValidWords(3, &single[b]);
+        }
+        double one_secs = secondsSince(start);
+
+        ScoreResult ignored;
+        start = std::chrono::steady_clock::now();
+        for(unsigned b = 0; b < count; b++) {
+            setBoard(player, size, boards[b]);
+            player.scoreBoard(0, SCORE_BY_POINTS, &ignored);
+        }
+        double count_secs = secondsSince(start);
+
+        double batch_secs = 0, id_secs = 0;
+        std::vector<std::vector<std::string> > batch;
+        std::vector<std::set<std::string> > found;
+        std::vector<std::vector<int32_t> > ids;
+        for(unsigned b = 0; b < count; b += SlicedSolver::MAX_BOARDS) {
+            unsigned end = std::min<unsigned>(count, b + SlicedSolver::MAX_BOARDS);
+            batch.assign(boards.begin() + b, boards.begin() + end);
+            start = std::chrono::steady_clock::now();
+            sliced.solve(batch, 3, &found);
+            batch_secs += secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            sliced.solve(batch, 3, &ids);
+            id_secs += secondsSince(start);
+            for(unsigned i = b; i < end; i++) {
+                if(found[i - b] != single[i] || ids[i - b].size() != single[i].size()) {
+                    std::cerr << "SlicedSolver differs on board " << i << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        std::cout << size << "x" << size << ", batches of " << SlicedSolver::MAX_BOARDS << ":\n"
+            << "  word sets  one at a time " << one_secs * 1e6 / count << " us/board"
+            << "  sliced " << batch_secs * 1e6 / count << " us/board"
+            << "  x" << one_secs / batch_secs << "\n"
+            << "  word ids   count-only scoreBoard " << count_secs * 1e6 / count << " us/board"
+            << "  sliced " << id_secs * 1e6 / count << " us/board"
+            << "  x" << count_secs / id_secs << std::endl;
+    }
+    return 0;
+}
+
+/* Times getAllValidWords on random boards as rolled and with one and
+ * two of their dice replaced by blanks, against the 26 and 676 solves
+ * of substituting every letter for the blanks */
+static int blankBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest blank LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 1000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    unsigned sizes[] = { 4, 5, 7 };
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        unsigned size = sizes[s];
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        double secs[3] = { 0, 0, 0 };
+        size_t words[3] = { 0, 0, 0 };
+        for(unsigned blanks = 0; blanks < 3; blanks++) {
+            for(unsigned b = 0; b < count; b++) {
+                std::vector<std::string> board = boards[b];
+                for(unsigned k = 0; k < blanks; k++) {
+                    board[(b + k * (size + 2)) % board.size()] = WILDCARD_DIE;
+                }
+                std::set<std::string> result;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                setBoard(player, size, board);
+                player.getAllValidWords(2, &result);
+                secs[blanks] += secondsSince(start);
+                words[blanks] += result.size();
+            }
+        }
+
+        std::cout << size << "x" << size << (size == 7 ? " (no kernel)" : "") << "\n";
+        for(unsigned blanks = 0; blanks < 3; blanks++) {
+            std::cout << "  " << blanks << " blanks  " << words[blanks] / (double)count
+                << " words/board  " << secs[blanks] * 1e6 / count << " us/board  x"
+                << secs[blanks] / secs[0] << " of no blanks";
+            if(blanks > 0)
+                std::cout << "  (substituting: x" << (blanks == 1 ? 26 : 676) << ")";
+            std::cout << "\n";
+        }
+        std::cout.flush();
+    }
+    return 0;
+}
+
+/* Whether text[t..] matches pattern[p..], ? and * as in patternWords */
+static bool globMatch(const char *pattern, const char *text, unsigned length) {
+    if(*pattern == '\0')
+        return length == 0;
+    if(*pattern == '*') {
+        for(unsigned skip = 0; skip <= length; skip++) {
+            if(globMatch(pattern + 1, text + skip, length - skip))
+                return true;
+        }
+        return false;
+    }
+    return length > 0 && (*pattern == '?' || *pattern == *text)
+        && globMatch(pattern + 1, text + 1, length - 1);
+}
+
+/* Whether word can be spelled from tiles as in anagramWords */
+static bool fromTiles(const char *word, unsigned length, const std::string &tiles, bool use_all) {
+    int counts[27] = { 0 };
+    for(size_t i = 0; i < tiles.size(); i++) {
+        counts[tiles[i] == '?' ? 26 : tiles[i] - 'a']++;
+    }
+    if(use_all && length != tiles.size())
+        return false;
+    for(unsigned i = 0; i < length; i++) {
+        int k = word[i] - 'a';
+        if(counts[k] > 0)
+            counts[k]--;
+        else if(counts[26] > 0)
+            counts[26]--;
+        else
+            return false;
+    }
+    return true;
+}
+
+/* Levenshtein distance between word and query, by the textbook table */
+static unsigned editDistance(const char *word, unsigned length, const std::string &query) {
+    std::vector<unsigned> row(query.size() + 1);
+    for(size_t j = 0; j <= query.size(); j++)
+        row[j] = j;
+    for(unsigned i = 1; i <= length; i++) {
+        unsigned diagonal = row[0];
+        row[0] = i;
+        for(size_t j = 1; j <= query.size(); j++) {
+            unsigned above = row[j];
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1),
+                    diagonal + (word[i - 1] == query[j - 1] ? 0 : 1));
+            diagonal = above;
+        }
+    }
+    return row[query.size()];
+}
+
+/* Times the trie queries of lexiconquery.h against a linear scan of
+ * the word list answering the same questions */
+static int queryBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest query LEXFILE [repeats]" << std::endl;
+        return 1;
+    }
+    unsigned repeats = argc > 3 ? atoi(argv[3]) : 100;
+
+    WordList words;
+    if(!loadWordList(argv[2], &words)) {
+        std::cerr << "Could not read " << argv[2] << std::endl;
+        return 1;
+    }
+    FlatLexicon lexicon(words);
+
+    struct Query {
+        const char *label;
+        int kind;           // 0 prefix, 1 pattern, 2 anagram, 3 fuzzy (limit edits)
+        std::string text;
+        size_t offset, limit;
+        bool use_all;
+    };
+    Query queries[] = {
+        { "prefix con", 0, "con", 0, 0, false },
+        { "prefix s, offset 5000, limit 20", 0, "s", 5000, 20, false },
+        { "pattern c?t*", 1, "c?t*", 0, 0, false },
+        { "pattern *ing", 1, "*ing", 0, 0, false },
+        { "pattern ?r??e*s", 1, "?r??e*s", 0, 0, false },
+        { "anagrams of aeinrst", 2, "aeinrst", 0, 0, true },
+        { "words from aeinrst", 2, "aeinrst", 0, 0, false },
+        { "words from tiles??", 2, "tiles??", 0, 0, false },
+        { "within 1 edit of wrod", 3, "wrod", 0, 1, false },
+        { "within 2 edits of boggle", 3, "boggle", 0, 2, false },
+        { "within 2 edits of quixotc", 3, "quixotc", 0, 2, false },
+    };
+
+    for(size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const Query &query = queries[q];
+        std::vector<std::string> trie_words, scan_words;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(unsigned r = 0; r < repeats; r++) {
+            trie_words.clear();
+            WordCallback collect = [&trie_words](const std::string &word) {
+                trie_words.push_back(word);
+                return true;
+            };
+            if(query.kind == 0)
+                prefixWords(lexicon, query.text, query.offset, query.limit, collect);
+            else if(query.kind == 1)
+                patternWords(lexicon, query.text, collect);
+            else if(query.kind == 2)
+                anagramWords(lexicon, query.text, query.use_all, collect);
+            else
+                fuzzyWords(lexicon, query.text, query.limit,
+                        [&trie_words](const std::string &word, unsigned) {
+                    trie_words.push_back(word);
+                    return true;
+                });
+        }
+        double trie_secs = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for(unsigned r = 0; r < repeats; r++) {
+            scan_words.clear();
+            size_t skipped = 0;
+            for(size_t i = 0; i < words.size(); i++) {
+                const char *word = words.data(i);
+                unsigned length = words.length(i);
+                bool match;
+                if(query.kind == 0)
+                    match = length >= query.text.size()
+                        && query.text.compare(0, std::string::npos, word, query.text.size()) == 0;
+                else if(query.kind == 1)
+                    match = globMatch(query.text.c_str(), word, length);
+                else if(query.kind == 2)
+                    match = fromTiles(word, length, query.text, query.use_all);
+                else
+                    match = editDistance(word, length, query.text) <= query.limit;
+                if(!match)
+                    continue;
+                if(query.kind == 3) {
+                    scan_words.push_back(words.word(i));
+                    continue;
+                }
+                if(skipped < query.offset) {
+                    skipped++;
+                    continue;
+                }
+                scan_words.push_back(words.word(i));
+                if(query.limit != 0 && scan_words.size() == query.limit)
+                    break;
+            }
+        }
+        double scan_secs = secondsSince(start);
+
+        if(trie_words != scan_words) {
+            std::cerr << query.label << ": trie and scan disagree" << std::endl;
+            return 1;
+        }
+        std::cout << query.label << ": " << trie_words.size() << " words\n"
+            << "  scan " << scan_secs * 1e6 / repeats << " us"
+            << "  trie " << trie_secs * 1e6 / repeats << " us"
+            << "  x" << scan_secs / trie_secs << std::endl;
+    }
+    return 0;
+}
+
+/* Times a stream of 4x4 boards in which every distinct board comes
+ * back four times, each time rotated or mirrored at random, solved
+ * plainly and through a SolveCache */
+static int cacheBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest cache LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 4000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    std::vector<std::vector<std::string> > distinct = randomBoards(bag, 4, count / 4 + 1);
+    std::vector<std::vector<std::string> > stream(count);
+    for(unsigned b = 0; b < count; b++) {
+        const std::vector<std::string> &board = distinct[rand() % distinct.size()];
+        unsigned turn = rand() % 8;
+        for(unsigned i = 0; i < 16; i++) {
+            unsigned r = i / 4, c = i % 4;
+            if(turn & 1)
+                r = 3 - r;
+            if(turn & 2)
+                c = 3 - c;
+            stream[b].push_back(board[(turn & 4) ? c * 4 + r : r * 4 + c]);
+        }
+    }
+
+    double plain_secs = 0, cached_secs = 0;
+    SolveCache cache(count);
+    for(unsigned b = 0; b < count; b++) {
+        std::set<std::string> plain, cached;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        setBoard(player, 4, stream[b]);
+        player.getAllValidWords(3, &plain);
+        plain_secs += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        cache.getAllValidWords(player, 4, 4, stream[b], 3, &cached);
+        cached_secs += secondsSince(start);
+        if(cached != plain) {
+            std::cerr << "Cached result differs on board " << b << std::endl;
+            return 1;
+        }
+    }
+
+    SolveCacheStats stats = cache.stats();
+    std::cout << count << " boards, " << distinct.size() << " distinct\n"
+        << "  plain " << plain_secs * 1e6 / count << " us/board"
+        << "  cached " << cached_secs * 1e6 / count << " us/board"
+        << "  x" << plain_secs / cached_secs << "\n"
+        << "  " << stats.toJson() << std::endl;
+    return 0;
+}
+
+/**
+ * Applies batches of 50 additions and 50 removals to a LexiconVersions
+ * and compares each with building the changed lexicon from scratch,
+ * then compares solving on the final snapshot with solving on a fresh
+ * build of the same words, and finally applies batches while another
+ * thread solves on whatever snapshot is current.
+ */
+static int deltaBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest delta LEXFILE [batches]" << std::endl;
+        return 1;
+    }
+    unsigned batches = argc > 3 ? atoi(argv[3]) : 20;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    std::set<std::string> words(bag.lexicon_words.begin(), bag.lexicon_words.end());
+    std::vector<std::string> pool(words.begin(), words.end());
+    FlatLexicon initial(words);
+    LexiconVersions versions(initial);
+    std::mt19937 rng(1);
+
+    std::vector<std::vector<std::string> > adds(batches), removes(batches);
+    for(unsigned b = 0; b < batches; b++) {
+        for(unsigned i = 0; i < 50; i++) {
+            std::string made = pool[rng() % pool.size()];
+            made += (char)('a' + rng() % 26);
+            adds[b].push_back(made);
+            removes[b].push_back(pool[rng() % pool.size()]);
+        }
+    }
+
+    double apply_secs = 0, build_secs = 0;
+    for(unsigned b = 0; b < batches; b++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        versions.apply(adds[b], removes[b]);
+        apply_secs += secondsSince(start);
+
+        for(size_t i = 0; i < adds[b].size(); i++)
+            words.insert(adds[b][i]);
+        for(size_t i = 0; i < removes[b].size(); i++)
+            words.erase(removes[b][i]);
+        start = std::chrono::steady_clock::now();
+        FlatLexicon rebuilt(words);
+        build_secs += secondsSince(start);
+        if(b + 1 == batches && rebuilt.fingerprint() != versions.pin()->fingerprint()) {
+            std::cerr << "Updated lexicon differs from a rebuilt one" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << batches << " batches of 100 changes to " << pool.size() << " words\n"
+        << "  apply " << apply_secs * 1e3 / batches << " ms/batch"
+        << "  rebuild " << build_secs * 1e3 / batches << " ms/batch"
+        << "  x" << build_secs / apply_secs << std::endl;
+
+    srand(1);
+    std::vector<std::vector<std::string> > boards = randomBoards(bag, 4, 2000);
+    BogglePlayer updated, fresh;
+    updated.useLexicon(versions.pin());
+    fresh.buildLexicon(words);
+    double updated_secs = 0, fresh_secs = 0;
+    for(size_t b = 0; b < boards.size(); b++) {
+        std::set<std::string> found_updated, found_fresh;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        setBoard(updated, 4, boards[b]);
+        updated.getAllValidWords(3, &found_updated);
+        updated_secs += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        setBoard(fresh, 4, boards[b]);
+        fresh.getAllValidWords(3, &found_fresh);
+        fresh_secs += secondsSince(start);
+        if(found_updated != found_fresh) {
+            std::cerr << "Updated lexicon finds different words on board " << b << std::endl;
+            return 1;
+        }
+    }
+    std::cout << boards.size() << " boards\n"
+        << "  snapshot " << updated_secs * 1e6 / boards.size() << " us/board"
+        << "  fresh " << fresh_secs * 1e6 / boards.size() << " us/board" << std::endl;
+
+    std::atomic<bool> done(false);
+    unsigned long solved = 0;
+    std::thread reader([&]() {
+        BogglePlayer player;
+        for(size_t b = 0; !done; b = (b + 1) % boards.size(), solved++) {
+            std::set<std::string> found;
+            player.useLexicon(versions.pin());
+            setBoard(player, 4, boards[b]);
+            player.getAllValidWords(3, &found);
+        }
+    });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(unsigned b = 0; b < batches; b++)
+        versions.apply(removes[b], adds[b]);
+    double writer_secs = secondsSince(start);
+    done = true;
+    reader.join();
+    std::cout << "concurrent: " << batches << " batches in " << writer_secs * 1e3
+        << " ms while solving " << solved << " boards, version " << versions.version() << std::endl;
+    return 0;
+}
+
+/* Counts the paths of word from die cell onwards by trying them all */
+static uint64_t countEveryPath(const std::vector<std::string> &dice, unsigned size,
+        const std::string &word, size_t pos, int cell, std::vector<bool> &used) {
+    const std::string &text = dice[cell];
+    if(used[cell] || word.compare(pos, text.size(), text) != 0)
+        return 0;
+    pos += text.size();
+    if(pos == word.size())
+        return 1;
+    uint64_t total = 0;
+    used[cell] = true;
+    int row = cell / size, col = cell % size;
+    for(int r = row - 1; r <= row + 1; r++) {
+        for(int c = col - 1; c <= col + 1; c++) {
+            if(r >= 0 && c >= 0 && r < (int)size && c < (int)size)
+                total += countEveryPath(dice, size, word, pos, r * size + c, used);
+        }
+    }
+    used[cell] = false;
+    return total;
+}
+
+/**
+ * Times the single pass path counts against getAllValidWords on random
+ * boards, then memoized against exhaustive counting of single words on
+ * 5x5 boards of few distinct letters, where paths multiply.
+ */
+static int pathsBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest paths LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 2000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    std::vector<std::vector<std::string> > boards = randomBoards(bag, 4, count);
+    double words_secs = 0, counts_secs = 0;
+    uint64_t paths = 0, words = 0;
+    for(unsigned b = 0; b < count; b++) {
+        std::set<std::string> found;
+        std::map<std::string, uint64_t> counts;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        setBoard(player, 4, boards[b]);
+        player.getAllValidWords(3, &found);
+        words_secs += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        player.getAllPathCounts(3, &counts);
+        counts_secs += secondsSince(start);
+        words += counts.size();
+        for(std::map<std::string, uint64_t>::iterator it = counts.begin(); it != counts.end(); ++it)
+            paths += it->second;
+    }
+    std::cout << count << " 4x4 boards, " << words << " words, " << paths << " paths\n"
+        << "  getAllValidWords " << words_secs * 1e6 / count << " us/board"
+        << "  getAllPathCounts " << counts_secs * 1e6 / count << " us/board" << std::endl;
+
+    const char letters[] = "eest";
+    double memo_secs = 0, every_secs = 0;
+    uint64_t checked = 0;
+    for(unsigned b = 0; b < count / 20 + 1; b++) {
+        std::vector<std::string> dice(25);
+        for(unsigned i = 0; i < 25; i++)
+            dice[i] = std::string(1, letters[rand() % 4]);
+        setBoard(player, 5, dice);
+        std::set<std::string> found;
+        player.getAllValidWords(7, &found);
+        for(std::set<std::string>::iterator it = found.begin(); it != found.end(); ++it) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            uint64_t memo = player.countPaths(*it);
+            memo_secs += secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            uint64_t every = 0;
+            std::vector<bool> used(25, false);
+            for(int cell = 0; cell < 25; cell++)
+                every += countEveryPath(dice, 5, *it, 0, cell, used);
+            every_secs += secondsSince(start);
+            if(memo != every) {
+                std::cerr << "Path counts differ for " << *it << std::endl;
+                return 1;
+            }
+            checked++;
+        }
+    }
+    std::cout << checked << " words of 7+ letters on 5x5 boards of e, s and t\n"
+        << "  memoized " << memo_secs * 1e6 / checked << " us/word"
+        << "  every path " << every_secs * 1e6 / checked << " us/word"
+        << "  x" << every_secs / memo_secs << std::endl;
+
+    // the worst case: runs of e's on a board of nothing else
+    std::vector<std::string> es(16, "e");
+    for(size_t length = 6; length <= 10; length += 2) {
+        std::string run(length, 'e');
+        setBoard(player, 4, es);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t memo = player.countPaths(run);
+        memo_secs = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        uint64_t every = 0;
+        std::vector<bool> used(16, false);
+        for(int cell = 0; cell < 16; cell++)
+            every += countEveryPath(es, 4, run, 0, cell, used);
+        every_secs = secondsSince(start);
+        if(memo != every) {
+            std::cerr << "Path counts differ for " << run << std::endl;
+            return 1;
+        }
+        std::cout << length << " e's on 4x4 e's: " << memo << " paths"
+            << "  memoized " << memo_secs * 1e3 << " ms"
+            << "  every path " << every_secs * 1e3 << " ms" << std::endl;
+    }
+    return 0;
+}
+
+/**
+ * Times solving into a std::set and writing the words out as lines of
+ * text, as a separate solver process answers, against boggle_solve
+ * handing out the packed words of the C interface.
+ */
+static int abiBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest abi LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 4000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    boggle_lexicon *lexicon = boggle_lexicon_load(argv[2]);
+    boggle_player *handle = boggle_player_new(lexicon);
+    if(handle == NULL) {
+        std::cerr << "Can not load " << argv[2] << std::endl;
+        return 1;
+    }
+    srand(1);
+
+    std::vector<std::vector<std::string> > boards = randomBoards(bag, 4, count);
+    double text_secs = 0, abi_secs = 0;
+    size_t words = 0;
+    for(unsigned b = 0; b < count; b++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::set<std::string> found;
+        setBoard(player, 4, boards[b]);
+        player.getAllValidWords(3, &found);
+        std::string reply;
+        for(std::set<std::string>::iterator it = found.begin(); it != found.end(); ++it) {
+            reply += *it;
+            reply += '\n';
+        }
+        text_secs += secondsSince(start);
+
+        const char *dice[16];
+        for(unsigned i = 0; i < 16; i++)
+            dice[i] = boards[b][i].c_str();
+        boggle_words result;
+        start = std::chrono::steady_clock::now();
+        boggle_set_board(handle, 4, 4, dice);
+        boggle_solve(handle, 3, &result);
+        abi_secs += secondsSince(start);
+        if(result.count != found.size()) {
+            std::cerr << "boggle_solve found different words on board " << b << std::endl;
+            return 1;
+        }
+        words += result.count;
+    }
+    boggle_player_free(handle);
+    boggle_lexicon_free(lexicon);
+
+    std::cout << count << " boards, " << words << " words\n"
+        << "  set and text " << text_secs * 1e6 / count << " us/board"
+        << "  boggle_solve " << abi_secs * 1e6 / count << " us/board"
+        << "  x" << text_secs / abi_secs << std::endl;
+    return 0;
+}
+
+/**
+ * Times reading a corpus of boards from text parsed board by board
+ * against a mapped board stream: reading alone, then setting each board
+ * on a player, then solving each too.
+ */
+static int streamBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest stream LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 200000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    std::vector<std::vector<std::string> > boards = randomBoards(bag, 4, count);
+    const char *text_file = "perftest.brd", *stream_file = "perftest.bbs";
+    {
+        std::ofstream text(text_file), binary(stream_file, std::ios::binary);
+        BoardStreamWriter writer(binary, 4, 4);
+        for(unsigned b = 0; b < count; b++) {
+            writeTextBoard(text, 4, 4, boards[b]);
+            writer.add(boards[b]);
+        }
+    }
+
+    const char *stages[] = { " boards read\n", " boards read and set\n", " boards read and solved\n" };
+    for(int stage = 0; stage < 3; stage++) {
+        unsigned long text_words = 0, stream_words = 0;
+        std::set<std::string> found;
+        std::vector<std::string> dice;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::ifstream text(text_file);
+        unsigned rows, cols;
+        while(readTextBoard(text, &rows, &cols, &dice)) {
+            if(stage > 0)
+                player.setBoard(rows, cols, dice);
+            if(stage > 1) {
+                found.clear();
+                player.getAllValidWords(3, &found);
+                text_words += found.size();
+            }
+        }
+        double text_secs = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        BoardStreamReader stream;
+        stream.open(stream_file);
+        for(size_t b = 0; b < stream.size(); b++) {
+            stream.board(b, &dice);
+            if(stage > 0)
+                player.setBoard(stream.rows(), stream.cols(), dice);
+            if(stage > 1) {
+                found.clear();
+                player.getAllValidWords(3, &found);
+                stream_words += found.size();
+            }
+        }
+        double stream_secs = secondsSince(start);
+        if(stream.size() != count || text_words != stream_words) {
+            std::cerr << "The stream holds different boards than the text" << std::endl;
+            return 1;
+        }
+        std::cout << count << stages[stage]
+            << "  text " << text_secs * 1e6 / count << " us/board"
+            << "  stream " << stream_secs * 1e6 / count << " us/board"
+            << "  x" << text_secs / stream_secs << std::endl;
+        if(stage == 0) {
+            std::cout << "  files: text " << std::ifstream(text_file, std::ios::ate).tellg()
+                << " bytes, stream " << std::ifstream(stream_file, std::ios::ate).tellg()
+                << " bytes" << std::endl;
+        }
+    }
+    std::remove(text_file);
+    std::remove(stream_file);
+    return 0;
+}
+
+/**
+ * A hardware event counter for this thread, read through
+ * perf_event_open. Virtual machines and locked down kernels often have
+ * none; such a counter is not valid() and reads as zero.
+ */
+class HardwareCounter {
+  public:
+    HardwareCounter(uint32_t type, uint64_t config) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~HardwareCounter() {
+        if(fd >= 0)
+            close(fd);
+    }
+
+    bool valid() const { return fd >= 0; }
+
+    void start() {
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+                count = 0;
+        }
+        return count;
+    }
+
+  private:
+    HardwareCounter(const HardwareCounter &);
+    HardwareCounter &operator=(const HardwareCounter &);
+
+    int fd;
+};
+
+/**
+ * Times getAllValidWords on random boards with one recursive walk (the
+ * generic search and the kernels) against interleaved walks with more
+ * and more cursors, counting cache misses where the hardware lets us.
+ */
+static int interleaveBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest interleave LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 1000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    HardwareCounter misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    HardwareCounter l1_misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if(!misses.valid())
+        std::cout << "hardware cache counters unavailable; times only" << std::endl;
+
+    for(unsigned size = 4; size <= 6; size += 2) {
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        std::vector<std::set<std::string> > expected(count);
+        std::cout << count << " " << size << "x" << size << " boards" << std::endl;
+
+        // -2: generic recursion, -1: kernel, n: n interleaved cursors
+        int modes[] = { -2, -1, 2, 4, 8, 16 };
+        for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            player.setKernelsEnabled(modes[m] != -2);
+            player.setInterleavedCursors(modes[m] > 0 ? modes[m] : 0);
+            double secs = 0;
+            uint64_t llc = 0, l1 = 0;
+            for(unsigned b = 0; b < count; b++) {
+                std::set<std::string> found;
+                setBoard(player, size, boards[b]);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                misses.start();
+                l1_misses.start();
+                player.getAllValidWords(3, &found);
+                l1 += l1_misses.stop();
+                llc += misses.stop();
+                secs += secondsSince(start);
+                if(m == 0)
+                    expected[b].swap(found);
+                else if(found != expected[b]) {
+                    std::cerr << "Mode " << modes[m] << " finds different words on board "
+                        << b << std::endl;
+                    return 1;
+                }
+            }
+            std::cout << "  " << (modes[m] == -2 ? "generic" : modes[m] == -1 ? "kernel" : "cursors ");
+            if(modes[m] > 0)
+                std::cout << modes[m];
+            std::cout << "  " << secs * 1e6 / count << " us/board";
+            if(misses.valid()) {
+                std::cout << "  cache misses " << llc / count << "/board"
+                    << "  L1D misses " << l1 / count << "/board";
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Solves boards for four word lists drawn from the lexicon, with a
+ * player per list against one player searching them merged.
+ */
+static int multilexBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest multilex LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 2000;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+
+    // the whole list, half of it, the short words, and the words
+    // spelled backwards standing in for a second language
+    std::vector<std::set<std::string> > lists(4);
+    size_t rank = 0;
+    for(std::set<std::string>::const_iterator it = bag.lexicon_words.begin();
+            it != bag.lexicon_words.end(); ++it, rank++) {
+        lists[0].insert(*it);
+        if(rank % 2 == 0)
+            lists[1].insert(*it);
+        if(it->size() <= 6)
+            lists[2].insert(*it);
+        lists[3].insert(std::string(it->rbegin(), it->rend()));
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    LexiconSet lexicons(lists);
+    std::cout << "merged " << lexicons.getLexicon()->wordCount() << " words in "
+        << secondsSince(start) * 1e3 << " ms" << std::endl;
+
+    std::vector<BogglePlayer> singles(lists.size());
+    for(size_t i = 0; i < lists.size(); i++)
+        singles[i].buildLexicon(lists[i]);
+    BogglePlayer merged;
+    merged.useLexicon(lexicons.getLexicon());
+
+    srand(1);
+    std::vector<std::vector<std::string> > boards = randomBoards(bag, 4, count);
+    double single_secs = 0, merged_secs = 0, subset_secs = 0;
+    for(size_t b = 0; b < boards.size(); b++) {
+        std::vector<std::set<std::string> > separate(lists.size()), together, half;
+        start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < singles.size(); i++) {
+            setBoard(singles[i], 4, boards[b]);
+            singles[i].getAllValidWords(3, &separate[i]);
+        }
+        single_secs += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        setBoard(merged, 4, boards[b]);
+        merged.getAllValidWords(3, lexicons, lexicons.allMask(), &together);
+        merged_secs += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        merged.getAllValidWords(3, lexicons, 2, &half);
+        subset_secs += secondsSince(start);
+        if(together != separate || half[1] != separate[1]) {
+            std::cerr << "Merged lexicon finds different words on board " << b << std::endl;
+            return 1;
+        }
+    }
+    std::cout << boards.size() << " boards, " << lists.size() << " lexicons\n"
+        << "  separate " << single_secs * 1e6 / count << " us/board"
+        << "  merged " << merged_secs * 1e6 / count << " us/board"
+        << "  x" << single_secs / merged_secs
+        << "  one lexicon of the merged " << subset_secs * 1e6 / count << " us/board" << std::endl;
+    return 0;
+}
+
+/**
+ * Scores random boards completely, then best first under shrinking
+ * time budgets, reporting how much of the board's score each budget
+ * gets.
+ */
+static int anytimeBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest anytime LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 200;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    for(unsigned size = 4; size <= 8; size += 2) {
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        std::vector<uint64_t> totals(count);
+        double full_secs = 0, best_first_secs = 0;
+        for(unsigned b = 0; b < count; b++) {
+            ScoreResult score;
+            AnytimeResult anytime;
+            setBoard(player, size, boards[b]);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            player.scoreBoard(0, SCORE_BY_POINTS, &score);
+            full_secs += secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            player.solveAnytime(SolveBudget(), &anytime);
+            best_first_secs += secondsSince(start);
+            if(!anytime.complete || anytime.found.total != score.total) {
+                std::cerr << "Best-first solve scores board " << b << " differently" << std::endl;
+                return 1;
+            }
+            totals[b] = score.total;
+        }
+        std::cout << count << " " << size << "x" << size << " boards\n"
+            << "  depth first " << full_secs * 1e3 / count << " ms/board"
+            << "  best first " << best_first_secs * 1e3 / count << " ms/board" << std::endl;
+
+        double budgets[] = { 0.0001, 0.0005, 0.002, 0.005 };
+        for(size_t k = 0; k < sizeof(budgets) / sizeof(budgets[0]); k++) {
+            uint64_t points = 0, all_points = 0;
+            unsigned complete = 0;
+            for(unsigned b = 0; b < count; b++) {
+                AnytimeResult anytime;
+                setBoard(player, size, boards[b]);
+                player.solveAnytime(SolveBudget(budgets[k]), &anytime);
+                points += anytime.found.total;
+                all_points += totals[b];
+                complete += anytime.complete;
+            }
+            std::cout << "  " << budgets[k] * 1e3 << " ms budget: "
+                << 100.0 * points / std::max<uint64_t>(all_points, 1) << "% of the points, "
+                << complete << " boards complete" << std::endl;
+        }
+    }
+    return 0;
+}
+
+/* Times the generic search over the same dice laid out as a grid, a
+ * torus and a hex board; with PROBES=1 also per die expanded, which is
+ * where the shapes should cost the same */
+static int topologyBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest topology LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 500;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    player.setKernelsEnabled(false);
+    srand(1);
+
+    for(unsigned size = 4; size <= 6; size++) {
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        const char *names[] = { "grid", "torus", "hex" };
+        BoardTopology shapes[] = { BoardTopology::grid(size, size),
+            BoardTopology::torus(size, size), BoardTopology::hex(size, size) };
+        std::cout << count << " " << size << "x" << size << " boards" << std::endl;
+        for(int k = 0; k < 3; k++) {
+            double secs = 0;
+            size_t words = 0;
+            uint64_t expanded = 0;
+            for(unsigned b = 0; b < count; b++) {
+                std::set<std::string> found;
+                player.setBoard(shapes[k], boards[b]);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                player.getAllValidWords(3, &found);
+                secs += secondsSince(start);
+                words += found.size();
+                expanded += player.lastSolveProbes().counters[PROBE_NODES_EXPANDED];
+            }
+            std::cout << "  " << names[k] << ": " << words / (double)count << " words/board  "
+                << secs * 1e6 / count << " us/board";
+            if(probesEnabled())
+                std::cout << "  " << secs * 1e9 / std::max<uint64_t>(expanded, 1) << " ns/die expanded";
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
+/* Times per-die heat gathered during the solve against the way it had
+ * to be done before: solving, then isOnBoard for every word */
+static int heatBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest heat LEXFILE [boards]" << std::endl;
+        return 1;
+    }
+    unsigned count = argc > 3 ? atoi(argv[3]) : 500;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    ScoringRules rules = ScoringRules::official();
+    srand(1);
+
+    // the score table and per-word masks are built on first use
+    std::vector<std::vector<std::string> > warmup = randomBoards(bag, 4, 1);
+    ScoreResult warm_score;
+    CellHeat warm_heat;
+    setBoard(player, 4, warmup[0]);
+    player.getCellHeat(&warm_score, &warm_heat);
+
+    for(unsigned size = 4; size <= 8; size += 2) {
+        std::vector<std::vector<std::string> > boards = randomBoards(bag, size, count);
+        double score_secs = 0, heat_secs = 0, lookup_secs = 0;
+        for(unsigned b = 0; b < count; b++) {
+            setBoard(player, size, boards[b]);
+            ScoreResult score;
+            CellHeat heat;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            player.scoreBoard(0, SCORE_BY_POINTS, &score);
+            score_secs += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            player.getCellHeat(&score, &heat);
+            heat_secs += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            std::set<std::string> words;
+            std::vector<uint32_t> first(size * size, 0);
+            player.getAllValidWords(rules.minimum_length, &words);
+            for(std::set<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+                std::vector<int> path = player.isOnBoard(*it);
+                for(size_t k = 0; k < path.size(); k++)
+                    first[path[k]]++;
+            }
+            lookup_secs += secondsSince(start);
+            if(words.size() != score.words) {
+                std::cerr << "Heat solve counts board " << b << " differently" << std::endl;
+                return 1;
+            }
+        }
+        std::cout << count << " " << size << "x" << size << " boards\n"
+            << "  scoreBoard " << score_secs * 1e6 / count << " us/board"
+            << "  getCellHeat " << heat_secs * 1e6 / count << " us/board\n"
+            << "  solve + isOnBoard per word " << lookup_secs * 1e6 / count << " us/board"
+            << "  x" << lookup_secs / heat_secs << std::endl;
+    }
+    return 0;
+}
+
+/* Times BoardSynthesizer to its first board holding a set of theme
+ * words, over several seeds, against drawing boards from the dice bag
+ * and checking each word with isOnBoard for a second */
+static int designBench(int argc, char *argv[]) {
+    if(argc < 3) {
+        std::cerr << "usage: perftest design LEXFILE [runs]" << std::endl;
+        return 1;
+    }
+    unsigned runs = argc > 3 ? atoi(argv[3]) : 10;
+
+    std::streambuf *saved = std::cout.rdbuf(NULL);
+    BoggleBoard bag(argv[2], 4, 4);
+    std::cout.rdbuf(saved);
+    BogglePlayer player;
+    player.buildLexicon(bag.lexicon_words);
+    srand(1);
+
+    struct Theme {
+        unsigned size;
+        const char *words;
+    };
+    Theme themes[] = {
+        { 4, "cat dog bird fish" },
+        { 5, "boggle puzzle theme words quiz" },
+        { 6, "planet comet orbit galaxy nebula star moon" },
+    };
+    for(size_t t = 0; t < sizeof(themes) / sizeof(themes[0]); t++) {
+        unsigned size = themes[t].size;
+        std::vector<std::string> targets;
+        std::istringstream split(themes[t].words);
+        std::string word;
+        while(split >> word)
+            targets.push_back(word);
+
+        SynthOptions options;
+        options.seconds = 0;
+        double total = 0, slowest = 0;
+        for(unsigned r = 0; r < runs; r++) {
+            options.seed = r + 1;
+            BoardSynthesizer synthesizer(player, BoardTopology::grid(size, size), targets, options);
+            SynthResult result;
+            synthesizer.run(&result);
+            if(!result.found) {
+                std::cerr << themes[t].words << ": no board found" << std::endl;
+                return 1;
+            }
+            total += result.first_seconds;
+            slowest = std::max(slowest, result.first_seconds);
+        }
+
+        // the same second spent drawing boards at random
+        uint64_t drawn = 0, hits = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while(secondsSince(start) < 1) {
+            std::vector<std::vector<std::string> > boards = randomBoards(bag, size, 100);
+            for(size_t b = 0; b < boards.size(); b++) {
+                setBoard(player, size, boards[b]);
+                bool all = true;
+                for(size_t i = 0; i < targets.size() && all; i++)
+                    all = !player.isOnBoard(targets[i]).empty();
+                drawn++;
+                hits += all;
+            }
+        }
+        std::cout << size << "x" << size << " " << themes[t].words << "\n"
+            << "  synthesizer first board " << total * 1e3 / runs << " ms mean, "
+            << slowest * 1e3 << " ms worst of " << runs << "\n"
+            << "  random boards: " << hits << " of " << drawn << " in 1 s hold every word"
+            << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if(mode == "load")
+        return loadBench(argc, argv);
+    if(mode == "synth")
+        return synthBench(argc, argv);
+    if(mode == "solve")
+        return solveBench(argc, argv);
+    if(mode == "score")
+        return scoreBench(argc, argv);
+    if(mode == "slice")
+        return sliceBench(argc, argv);
+    if(mode == "blank")
+        return blankBench(argc, argv);
+    if(mode == "query")
+        return queryBench(argc, argv);
+    if(mode == "cache")
+        return cacheBench(argc, argv);
+    if(mode == "delta")
+        return deltaBench(argc, argv);
+    if(mode == "paths")
+        return pathsBench(argc, argv);
+    if(mode == "abi")
+        return abiBench(argc, argv);
+    if(mode == "stream")
+        return streamBench(argc, argv);
+    if(mode == "interleave")
+        return interleaveBench(argc, argv);
+    if(mode == "multilex")
+        return multilexBench(argc, argv);
+    if(mode == "anytime")
+        return anytimeBench(argc, argv);
+    if(mode == "topology")
+        return topologyBench(argc, argv);
+    if(mode == "heat")
+        return heatBench(argc, argv);
+    if(mode == "design")
+        return designBench(argc, argv);
+
+    std::cerr << "usage: perftest load LEXFILE [threads]\n"
+        "       perftest synth COUNT OUTFILE\n"
+        "       perftest solve LEXFILE [boards]\n"
+        "       perftest score LEXFILE [boards]\n"
+        "       perftest slice LEXFILE [boards]\n"
+        "       perftest blank LEXFILE [boards]\n"
+        "       perftest query LEXFILE [repeats]\n"
+        "       perftest cache LEXFILE [boards]\n"
+        "       perftest delta LEXFILE [batches]\n"
+        "       perftest paths LEXFILE [boards]\n"
+        "       perftest abi LEXFILE [boards]\n"
+        "       perftest stream LEXFILE [boards]\n"
+        "       perftest interleave LEXFILE [boards]\n"
+        "       perftest multilex LEXFILE [boards]\n"
+        "       perftest anytime LEXFILE [boards]\n"
+        "       perftest topology LEXFILE [boards]\n"
+        "       perftest heat LEXFILE [boards]\n"
+        "       perftest design LEXFILE [runs]" << std::endl;
+    return 1;
+}
@@ -0,0 +1,61 @@
+#include "solveworker.h"
+
+    SolveWorker::SolveWorker(const BogglePlayer &lexicon_owner,
+            const std::atomic<quint64> &current, QObject *parent)
+            : QObject(parent), current(current) {
+        qRegisterMetaType<QVector<int> >("QVector<int>");
+        player.shareLexicon(lexicon_owner);
+    }
+
+    void SolveWorker::solve(quint64 generation, int rows, int cols, QStringList dice,
+            int minimum_length) {
+        std::vector<std::string> board;
+        board.reserve(dice.size());
+        for(int i = 0; i < dice.size(); i++)
+            board.push_back(dice[i].toStdString());
+        player.setBoard(rows, cols, board);
+
+        // the words listed are the words that count, so that one search
+        // finds them and their heat
+        ScoringRules rules = ScoringRules::official();
+        rules.minimum_length = minimum_length;
+        player.setScoringRules(rules);
+
+        // batches go out while the search runs, so the window lists
+        // words before the solve is over; once the window has moved on
+        // to another board or solve the search stops
+        QStringList batch;
+        int found = 0;
+        WordCallback stream = [this, generation, &batch, &found](const std::string &word) {
+            if(generation != current.load(std::memory_order_relaxed))
+                return false;
+            batch.append(QString::fromLatin1(word.c_str()));
+            found++;
+            if(batch.size() == BATCH_SIZE) {
+                emit wordsFound(generation, batch);
+                batch.clear();
+            }
+            return true;
+        };
+        ScoreResult score;
+        CellHeat heat;
+        bool heated = player.getCellHeat(&score, &heat, stream);
+        if(!heated) {
+            // boards of more than 64 dice have no heat
+            player.getAllValidWords(minimum_length, stream);
+        }
+        if(generation != current.load(std::memory_order_relaxed))
+            return;
+        if(!batch.isEmpty())
+            emit wordsFound(generation, batch);
+
+        if(heated) {
+            QVector<int> words, points;
+            for(size_t i = 0; i < heat.words.size(); i++) {
+                words.append((int)heat.words[i]);
+                points.append((int)heat.points[i]);
+            }
+            emit heatFound(generation, words, points);
+        }
+        emit solveFinished(generation, found);
+    }
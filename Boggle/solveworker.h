@@ -0,0 +1,54 @@
+#ifndef SOLVEWORKER_H
+#define SOLVEWORKER_H
+
+#include "boggleplayer.h"
+#include <atomic>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+/**
+ * Solves boards for the window off the GUI thread. The worker is moved
+ * to its own QThread and searches with its own BogglePlayer over the
+ * window's lexicon, so the window's player stays free for checking
+ * human words while a solve runs.
+ *
+ * Results come back as queued signals in batches of up to BATCH_SIZE
+ * words, sent in the order the search finds them while it is still
+ * running, and tagged with the generation the solve was asked for; the
+ * window sorts the list once the solve has finished. The window
+ * bumps its generation when the board changes and drops batches from
+ * older solves; the worker watches the same counter and stops a solve
+ * as soon as it is stale. After the words comes the board's heat: the
+ * number of words and points using each die (see CellHeat), gathered
+ * in the same search as the words.
+ */
+class SolveWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int BATCH_SIZE = 512;
+
+    /* current is the window's latest generation, which must outlive
+     * the worker */
+    SolveWorker(const BogglePlayer &lexicon_owner, const std::atomic<quint64> &current,
+                QObject *parent = 0);
+
+public slots:
+    /* Finds the words of at least minimum_length letters on a rows x
+     * cols board of dice in row-major order */
+    void solve(quint64 generation, int rows, int cols, QStringList dice,
+               int minimum_length);
+
+signals:
+    void wordsFound(quint64 generation, QStringList words);
+    void heatFound(quint64 generation, QVector<int> words, QVector<int> points);
+    void solveFinished(quint64 generation, int word_count);
+
+private:
+    BogglePlayer player;
+    const std::atomic<quint64> &current;
+};
+
+#endif // SOLVEWORKER_H
@@ -0,0 +1,54 @@
+#include "wordlistmodel.h"
+
+#include <algorithm>
+
+    WordListModel::WordListModel(QObject *parent)
+            : QAbstractListModel(parent), shown(0) {}
+
+    int WordListModel::rowCount(const QModelIndex &parent) const {
+        return parent.isValid() ? 0 : shown;
+    }
+
+    QVariant WordListModel::data(const QModelIndex &index, int role) const {
+        if(!index.isValid() || index.row() >= shown || role != Qt::DisplayRole)
+            return QVariant();
+        return words[index.row()];
+    }
+
+    bool WordListModel::canFetchMore(const QModelIndex &parent) const {
+        return !parent.isValid() && shown < wordCount();
+    }
+
+    void WordListModel::fetchMore(const QModelIndex &parent) {
+        if(parent.isValid())
+            return;
+        int more = std::min(FETCH_SIZE, wordCount() - shown);
+        if(more <= 0)
+            return;
+        beginInsertRows(QModelIndex(), shown, shown + more - 1);
+        shown += more;
+        endInsertRows();
+    }
+
+    void WordListModel::appendWords(const QStringList &batch) {
+        words.reserve(words.size() + batch.size());
+        for(int i = 0; i < batch.size(); i++)
+            words.push_back(batch[i]);
+        // until the view has a screenful it will not scroll, and so
+        // never ask for more
+        if(shown < FETCH_SIZE)
+            fetchMore(QModelIndex());
+    }
+
+    void WordListModel::sortWords() {
+        emit layoutAboutToBeChanged();
+        std::sort(words.begin(), words.end());
+        emit layoutChanged();
+    }
+
+    void WordListModel::clear() {
+        beginResetModel();
+        words.clear();
+        shown = 0;
+        endResetModel();
+    }
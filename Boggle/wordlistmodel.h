@@ -0,0 +1,45 @@
+#ifndef WORDLISTMODEL_H
+#define WORDLISTMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
+#include <vector>
+
+/**
+ * The computer's word list for a QListView. Words are appended in
+ * batches as a solve streams them in, but the view is only told about
+ * them FETCH_SIZE rows at a time, through canFetchMore and fetchMore,
+ * as it scrolls towards the end; a board with tens of thousands of
+ * words costs the view no more than the rows it has shown.
+ */
+class WordListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static const int FETCH_SIZE = 256;
+
+    explicit WordListModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    /* Adds words after those already held; the first FETCH_SIZE rows
+     * are shown at once, the rest when the view fetches them */
+    void appendWords(const QStringList &batch);
+    void clear();
+
+    /* Puts the words held, shown or not, into alphabetical order */
+    void sortWords();
+
+    /* All the words held, whether the view has fetched them or not */
+    int wordCount() const { return (int)words.size(); }
+
+private:
+    std::vector<QString> words;
+    int shown;
+};
+
+#endif // WORDLISTMODEL_H